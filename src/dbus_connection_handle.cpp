@@ -18,11 +18,45 @@
 
 #include "dbus_connection_handle.h"
 #include "scoped_dbus_error.h"
+#include "dbus_message_handle.h"
 
 #include <stdexcept>
 #include <boost/throw_exception.hpp>
 
+namespace
+{
+
+usc::DBusMessageHandle bus_method_call(char const* method)
+{
+    return usc::DBusMessageHandle{
+        dbus_message_new_method_call(DBUS_SERVICE_DBUS, DBUS_PATH_DBUS, DBUS_INTERFACE_DBUS, method)};
+}
+
+void throw_on_error_reply(DBusMessage* reply, std::string const& what)
+{
+    usc::ScopedDBusError error;
+
+    if (!reply)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error(what + ": No reply"));
+    }
+
+    if (dbus_set_error_from_message(&error, reply))
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error(what + ": " + error.message_str()));
+    }
+}
+
+}
+
 usc::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
+    : DBusConnectionHandle{address, Registration::blocking}
+{
+}
+
+usc::DBusConnectionHandle::DBusConnectionHandle(
+    std::string const& address, Registration registration)
+    : registration{registration}
 {
     dbus_threads_init_default();
     ScopedDBusError error;
@@ -34,6 +68,17 @@ usc::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
             std::runtime_error("dbus_connection_open: " + error.message_str()));
     }
 
+    if (registration == Registration::peer)
+        return;
+
+    if (registration == Registration::pipelined)
+    {
+        // Hello must be the first message, and the bus handles messages
+        // in order, so anything sent after it may go out straight away
+        send_pending(bus_method_call("Hello"), "");
+        return;
+    }
+
     if (!dbus_bus_register(connection, &error))
     {
         BOOST_THROW_EXCEPTION(
@@ -41,8 +86,20 @@ usc::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
     }
 }
 
+usc::DBusConnectionHandle::DBusConnectionHandle(DBusConnection* connection)
+    : connection{dbus_connection_ref(connection)},
+      registration{Registration::peer}
+{
+}
+
 usc::DBusConnectionHandle::~DBusConnectionHandle()
 {
+    for (auto const& pending : pending_replies)
+    {
+        dbus_pending_call_cancel(pending.call);
+        dbus_pending_call_unref(pending.call);
+    }
+
     if (dbus_connection_get_is_connected(connection))
         dbus_connection_close(connection);
     dbus_connection_unref(connection);
@@ -50,6 +107,26 @@ usc::DBusConnectionHandle::~DBusConnectionHandle()
 
 void usc::DBusConnectionHandle::request_name(char const* name) const
 {
+    if (registration == Registration::peer)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::logic_error(std::string{"dbus_request_name: No bus to own "} + name + " on"));
+    }
+
+    if (registration == Registration::pipelined)
+    {
+        dbus_uint32_t const flags{DBUS_NAME_FLAG_DO_NOT_QUEUE};
+        auto const request = bus_method_call("RequestName");
+        dbus_message_append_args(
+            request,
+            DBUS_TYPE_STRING, &name,
+            DBUS_TYPE_UINT32, &flags,
+            DBUS_TYPE_INVALID);
+
+        send_pending(request, name);
+        return;
+    }
+
     ScopedDBusError error;
 
     auto const request_result = dbus_bus_request_name(
@@ -67,6 +144,76 @@ void usc::DBusConnectionHandle::request_name(char const* name) const
     }
 }
 
+void usc::DBusConnectionHandle::finish_registration()
+{
+    auto const replies = std::move(pending_replies);
+    pending_replies.clear();
+
+    std::string failure;
+
+    for (auto const& pending : replies)
+    {
+        dbus_pending_call_block(pending.call);
+
+        DBusMessageHandle const reply{dbus_pending_call_steal_reply(pending.call)};
+        dbus_pending_call_unref(pending.call);
+
+        if (!failure.empty())
+            continue;
+
+        try
+        {
+            if (pending.name.empty())
+            {
+                throw_on_error_reply(reply, "dbus_bus_register");
+
+                char const* unique_name{nullptr};
+                if (!dbus_message_get_args(reply, nullptr, DBUS_TYPE_STRING, &unique_name, DBUS_TYPE_INVALID) ||
+                    !dbus_bus_set_unique_name(connection, unique_name))
+                {
+                    BOOST_THROW_EXCEPTION(
+                        std::runtime_error("dbus_bus_register: Invalid Hello reply"));
+                }
+            }
+            else
+            {
+                throw_on_error_reply(reply, "dbus_request_name");
+
+                dbus_uint32_t request_result{0};
+                dbus_message_get_args(reply, nullptr, DBUS_TYPE_UINT32, &request_result, DBUS_TYPE_INVALID);
+                if (request_result != DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER)
+                {
+                    BOOST_THROW_EXCEPTION(
+                        std::runtime_error(
+                            "dbus_request_name: Failed to become primary owner of " + pending.name));
+                }
+            }
+        }
+        catch (std::runtime_error const& error)
+        {
+            // Keep going, so that every pending call is released
+            failure = error.what();
+        }
+    }
+
+    if (!failure.empty())
+        BOOST_THROW_EXCEPTION(std::runtime_error(failure));
+}
+
+void usc::DBusConnectionHandle::send_pending(DBusMessage* message, std::string const& name) const
+{
+    DBusPendingCall* call{nullptr};
+
+    if (!dbus_connection_send_with_reply(connection, message, &call, DBUS_TIMEOUT_USE_DEFAULT) || !call)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::runtime_error("dbus_connection_send_with_reply: Failed to send " +
+                               std::string{dbus_message_get_member(message)}));
+    }
+
+    pending_replies.push_back({name, call});
+}
+
 void usc::DBusConnectionHandle::add_match(char const* match) const
 {
     ScopedDBusError error;
@@ -96,6 +243,22 @@ void usc::DBusConnectionHandle::add_filter(
     }
 }
 
+void usc::DBusConnectionHandle::register_object_path(
+    char const* path,
+    DBusObjectPathVTable const& vtable,
+    void* user_data) const
+{
+    ScopedDBusError error;
+
+    dbus_connection_try_register_object_path(
+        connection, path, &vtable, user_data, &error);
+    if (error)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::runtime_error("dbus_connection_register_object_path: " + error.message_str()));
+    }
+}
+
 usc::DBusConnectionHandle::operator ::DBusConnection*() const
 {
     return connection;
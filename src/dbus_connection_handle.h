@@ -22,6 +22,7 @@
 #include <dbus/dbus.h>
 
 #include <string>
+#include <vector>
 
 namespace usc
 {
@@ -29,12 +30,30 @@ namespace usc
 class DBusConnectionHandle
 {
 public:
+    // A blocking connection waits for the bus to reply to Hello and to each
+    // RequestName before returning. A pipelined one sends them without
+    // waiting, so that the round trips of several names and connections
+    // overlap, and finish_registration() waits for all the replies. A
+    // peer-to-peer connection, to a DBusServer rather than a bus, doesn't
+    // register at all, and has no names.
+    enum class Registration { blocking, pipelined, peer };
+
     DBusConnectionHandle(std::string const& address);
+    DBusConnectionHandle(std::string const& address, Registration registration);
+    // Takes a reference to connection, a peer-to-peer connection that a
+    // DBusServer has accepted
+    explicit DBusConnectionHandle(DBusConnection* connection);
     ~DBusConnectionHandle();
 
     void request_name(char const* name) const;
+    // Waits for the replies to Hello and the names requested so far, and
+    // throws if any of them failed. Does nothing on a blocking connection.
+    // The unique name and the names aren't known to be ours until then.
+    void finish_registration();
     void add_match(char const* match) const;
     void add_filter(DBusHandleMessageFunction filter_func, void* user_data) const;
+    void register_object_path(
+        char const* path, DBusObjectPathVTable const& vtable, void* user_data) const;
 
     operator ::DBusConnection*() const;
 
@@ -42,7 +61,20 @@ private:
     DBusConnectionHandle(DBusConnectionHandle const&) = delete;
     DBusConnectionHandle& operator=(DBusConnectionHandle const&) = delete;
 
+    struct PendingReply
+    {
+        // Empty for Hello
+        std::string name;
+        DBusPendingCall* call;
+    };
+
+    void send_pending(DBusMessage* message, std::string const& name) const;
+
     ::DBusConnection* connection;
+    Registration const registration;
+    // Registration bookkeeping, not connection state, so request_name()
+    // stays const
+    mutable std::vector<PendingReply> pending_replies;
 };
 
 }
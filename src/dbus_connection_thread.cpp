@@ -18,30 +18,52 @@
 
 #include "dbus_connection_thread.h"
 #include "dbus_event_loop.h"
+#include "dbus_event_loop_pool.h"
 #include "thread_name.h"
 
-usc::DBusConnectionThread::DBusConnectionThread(std::shared_ptr<DBusEventLoop> const& loop) : dbus_event_loop(loop)
+#include <future>
+
+usc::DBusConnectionThread::DBusConnectionThread(std::shared_ptr<DBusEventLoop> const& loop)
 {
-    std::promise<void> event_loop_started;
-    auto event_loop_started_future = event_loop_started.get_future();
+    start({loop});
+}
 
-    dbus_loop_thread = std::thread(
-        [this,&event_loop_started]
-        {
-            usc::set_thread_name("USC/DBus");
-            dbus_event_loop->run(event_loop_started);
-        });
+usc::DBusConnectionThread::DBusConnectionThread(std::shared_ptr<DBusEventLoopPool> const& pool)
+{
+    start(pool->loops());
+}
 
-    event_loop_started_future.wait();
+void usc::DBusConnectionThread::start(std::vector<std::shared_ptr<DBusEventLoop>> const& loops)
+{
+    dbus_event_loops = loops;
+
+    for (size_t i = 0; i < dbus_event_loops.size(); ++i)
+    {
+        auto const dbus_event_loop = dbus_event_loops[i];
+        std::promise<void> event_loop_started;
+        auto event_loop_started_future = event_loop_started.get_future();
+
+        dbus_loop_threads.emplace_back(
+            [dbus_event_loop,i,&event_loop_started]
+            {
+                usc::set_thread_name("USC/DBus-" + std::to_string(i));
+                dbus_event_loop->run(event_loop_started);
+            });
+
+        event_loop_started_future.wait();
+    }
 }
 
 usc::DBusConnectionThread::~DBusConnectionThread()
 {
-    dbus_event_loop->stop();
-    dbus_loop_thread.join();
+    for (auto const& dbus_event_loop : dbus_event_loops)
+        dbus_event_loop->stop();
+
+    for (auto& dbus_loop_thread : dbus_loop_threads)
+        dbus_loop_thread.join();
 }
 
 usc::DBusEventLoop & usc::DBusConnectionThread::loop()
 {
-    return *dbus_event_loop;
+    return *dbus_event_loops.front();
 }
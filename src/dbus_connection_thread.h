@@ -19,22 +19,31 @@
 #ifndef USC_DBUS_CONNECTION_THREAD_H_
 #define USC_DBUS_CONNECTION_THREAD_H_
 
+#include <memory>
 #include <thread>
+#include <vector>
 
 namespace usc
 {
 
 class DBusEventLoop;
+class DBusEventLoopPool;
+
+// Runs each loop on its own thread, named USC/DBus-N after the loop's
+// index in the pool
 class DBusConnectionThread
 {
 public:
     DBusConnectionThread(std::shared_ptr<DBusEventLoop> const& thread);
+    DBusConnectionThread(std::shared_ptr<DBusEventLoopPool> const& pool);
     ~DBusConnectionThread();
     DBusEventLoop & loop();
 
 private:
-    std::shared_ptr<DBusEventLoop> dbus_event_loop;
-    std::thread dbus_loop_thread;
+    void start(std::vector<std::shared_ptr<DBusEventLoop>> const& loops);
+
+    std::vector<std::shared_ptr<DBusEventLoop>> dbus_event_loops;
+    std::vector<std::thread> dbus_loop_threads;
 };
 
 }
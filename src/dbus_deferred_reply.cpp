@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbus_deferred_reply.h"
+#include "dbus_connection_handle.h"
+#include "dbus_event_loop.h"
+#include "dbus_message_handle.h"
+
+#include <cstdarg>
+
+namespace
+{
+
+void send_from_loop(
+    std::weak_ptr<usc::DBusEventLoop> const& weak_loop,
+    std::shared_ptr<usc::DBusConnectionHandle> const& connection,
+    usc::DBusMessageHandle reply)
+{
+    // The loop only holds a weak reference, so that a reply still queued
+    // on a stopped loop doesn't keep it alive
+    auto const loop = weak_loop.lock();
+    if (!loop || !reply)
+        return;
+
+    loop->enqueue(
+        [connection, reply = std::move(reply)]
+        {
+            dbus_connection_send(*connection, reply, nullptr);
+        });
+}
+
+}
+
+struct usc::DBusDeferredReply::State
+{
+    State(
+        std::shared_ptr<DBusEventLoop> const& loop,
+        std::shared_ptr<DBusConnectionHandle> const& connection,
+        DBusMessage* method_call)
+        : loop{loop},
+          connection{connection},
+          method_call{dbus_message_ref(method_call)},
+          replied{false}
+    {
+    }
+
+    ~State()
+    {
+        if (!replied)
+        {
+            send_from_loop(
+                loop, connection,
+                DBusMessageHandle{
+                    dbus_message_new_error(method_call, DBUS_ERROR_FAILED, "No reply")});
+        }
+
+        dbus_message_unref(method_call);
+    }
+
+    std::weak_ptr<DBusEventLoop> const loop;
+    std::shared_ptr<DBusConnectionHandle> const connection;
+    DBusMessage* const method_call;
+    std::atomic<bool> replied;
+};
+
+usc::DBusDeferredReply::DBusDeferredReply(
+    std::shared_ptr<DBusEventLoop> const& loop,
+    std::shared_ptr<DBusConnectionHandle> const& connection,
+    DBusMessage* method_call)
+    : state{std::make_shared<State>(loop, connection, method_call)}
+{
+}
+
+void usc::DBusDeferredReply::send_return(int first_arg_type, ...) const
+{
+    va_list args;
+    va_start(args, first_arg_type);
+    DBusMessageHandle reply{
+        dbus_message_new_method_return(state->method_call), first_arg_type, args};
+    va_end(args);
+
+    send(std::move(reply));
+}
+
+void usc::DBusDeferredReply::send_error(char const* name, char const* message) const
+{
+    send(DBusMessageHandle{dbus_message_new_error(state->method_call, name, message)});
+}
+
+DBusMessage* usc::DBusDeferredReply::method_call() const
+{
+    return state->method_call;
+}
+
+void usc::DBusDeferredReply::send(DBusMessageHandle reply) const
+{
+    if (state->replied.exchange(true))
+        return;
+
+    send_from_loop(state->loop, state->connection, std::move(reply));
+}
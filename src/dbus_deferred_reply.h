@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_DBUS_DEFERRED_REPLY_H_
+#define USC_DBUS_DEFERRED_REPLY_H_
+
+#include <dbus/dbus.h>
+
+#include <atomic>
+#include <memory>
+
+namespace usc
+{
+class DBusConnectionHandle;
+class DBusEventLoop;
+class DBusMessageHandle;
+
+// The reply to a method call, sent after the handler for the call has
+// returned. Copies share the same reply. The reply can be given from any
+// thread and is sent from the thread of loop; only the first one given is
+// sent. If no reply has been given when the last copy is destroyed, the
+// caller gets an error instead of waiting for its timeout.
+class DBusDeferredReply
+{
+public:
+    DBusDeferredReply(
+        std::shared_ptr<DBusEventLoop> const& loop,
+        std::shared_ptr<DBusConnectionHandle> const& connection,
+        DBusMessage* method_call);
+
+    // Arguments as for dbus_message_append_args()
+    void send_return(int first_arg_type, ...) const;
+    void send_error(char const* name, char const* message) const;
+
+    DBusMessage* method_call() const;
+
+private:
+    struct State;
+
+    void send(DBusMessageHandle reply) const;
+
+    std::shared_ptr<State> state;
+};
+
+}
+
+#endif
@@ -22,10 +22,15 @@
 
 #include "dbus_event_loop.h"
 #include "dbus_connection_handle.h"
+#include "epoll_event_loop_backend.h"
+#include "io_uring_event_loop_backend.h"
+#include "steady_clock.h"
 
 #include <algorithm>
 
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
 #include <sys/timerfd.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -36,6 +41,15 @@
 namespace
 {
 
+// How many times we re-handle an edge-triggered fd that still has pending
+// events before deferring it to the next loop iteration
+int const max_edge_triggered_drain_rounds = 16;
+
+// Normal priority actions run in batches of this size, with urgent actions
+// run in between, and only so many batches run per loop iteration
+size_t const action_batch_size = 16;
+int const max_action_batches_per_iteration = 16;
+
 uint32_t dbus_flags_to_epoll_events(DBusWatch* bus_watch)
 {
     unsigned int flags;
@@ -69,54 +83,178 @@ unsigned int epoll_events_to_dbus_flags(uint32_t events)
     return flags;
 }
 
-timespec msec_to_timespec(int msec)
+int64_t steady_clock_nanoseconds()
 {
-    static long const milli_to_nano = 1000000;
-    time_t const sec = msec / 1000;
-    long const nsec = (msec % 1000) * milli_to_nano;
-    return timespec{sec, nsec};
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
+std::string unique_name_of(DBusConnection* connection)
+{
+    auto const name = dbus_bus_get_unique_name(connection);
+    return name ? name : "";
 }
 
-usc::DBusEventLoop::DBusEventLoop()
-    : running{false},
-      epoll_fd{epoll_create1(EPOLL_CLOEXEC)}
+// The stats entry a message's handler time goes to
+size_t method_index_of(usc::DBusEventLoopStats const& stats, DBusMessage* message)
 {
-    if (epoll_fd == -1)
+    switch (dbus_message_get_type(message))
     {
-        BOOST_THROW_EXCEPTION(
-            std::system_error(errno, std::system_category(), "epoll_create1"));
+    case DBUS_MESSAGE_TYPE_METHOD_CALL:
+    case DBUS_MESSAGE_TYPE_SIGNAL:
+    {
+        auto const interface = dbus_message_get_interface(message);
+        auto const member = dbus_message_get_member(message);
+        return stats.method_index(interface ? interface : "", member ? member : "");
+    }
+    case DBUS_MESSAGE_TYPE_METHOD_RETURN:
+        return usc::DBusEventLoopStats::method_return;
+    case DBUS_MESSAGE_TYPE_ERROR:
+        return usc::DBusEventLoopStats::error_reply;
+    default:
+        return usc::DBusEventLoopStats::other_method;
     }
+}
+
+// Peers of a DBusServer have no bus, so no unique name, and share one
+// stats entry
+std::string stats_label_for(std::string const& name)
+{
+    return name.empty() ? "(peer)" : name;
+}
+
+bool has_unread_data(int fd)
+{
+    int bytes{0};
+    return ioctl(fd, FIONREAD, &bytes) == 0 && bytes > 0;
+}
+
+// The bytes written to the socket that its peer hasn't read yet
+int unread_output_bytes(int fd)
+{
+    int bytes{0};
+    return ioctl(fd, TIOCOUTQ, &bytes) == 0 ? bytes : 0;
+}
+
+}
 
-    int pipefd[2]{};
+usc::DBusEventLoop::DBusEventLoop()
+    : DBusEventLoop{1, Trigger::level}
+{
+}
+
+usc::DBusEventLoop::DBusEventLoop(int max_events_per_wakeup, Trigger trigger)
+    : DBusEventLoop{max_events_per_wakeup, trigger, std::make_shared<SteadyClock>()}
+{
+}
 
-    if (pipe2(pipefd, O_CLOEXEC) == -1)
+usc::DBusEventLoop::DBusEventLoop(
+    int max_events_per_wakeup,
+    Trigger trigger,
+    std::shared_ptr<Clock> const& clock)
+    : DBusEventLoop{max_events_per_wakeup, trigger, clock, Backend::epoll}
+{
+}
+
+usc::DBusEventLoop::DBusEventLoop(
+    int max_events_per_wakeup,
+    Trigger trigger,
+    std::shared_ptr<Clock> const& clock,
+    Backend backend)
+    : max_events_per_wakeup{std::max(max_events_per_wakeup, 1)},
+      trigger{trigger},
+      running{false},
+      iteration_count{0},
+      wake_up_pending{false},
+      clock{clock},
+      dispatch_pending{false},
+      actions_pending{false},
+      dispatch_round{0},
+      timer_fd_armed{false},
+      deadline_miss_count{0},
+      instrumentation_enabled_{false},
+      instrumenting{false},
+      first_pending_action_time{0},
+      wake_up_fd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)},
+      timer_fd{timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)},
+      backend_{backend}
+{
+    if (wake_up_fd == -1)
     {
         BOOST_THROW_EXCEPTION(
-            std::system_error(errno, std::system_category(), "pipe2"));
-
+            std::system_error(errno, std::system_category(), "eventfd"));
     }
 
-    wake_up_fd_r = mir::Fd{pipefd[0]};
-    wake_up_fd_w = mir::Fd{pipefd[1]};
-
-    epoll_event ev{};
-    ev.data.fd = wake_up_fd_r;
-    ev.events = EPOLLIN;
-    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, ev.data.fd, &ev) == -1)
+    if (timer_fd == -1)
     {
         BOOST_THROW_EXCEPTION(
-            std::system_error(errno, std::system_category(), "epoll_ctl"));
+            std::system_error(errno, std::system_category(), "timerfd_create"));
+    }
+
+    if (backend_ == Backend::io_uring)
+    {
+        try
+        {
+            event_backend.reset(new IoUringEventLoopBackend{[this] { wake_up_loop(); }});
+        }
+        catch (std::system_error const&)
+        {
+            backend_ = Backend::epoll;
+        }
     }
+
+    if (backend_ == Backend::epoll)
+        event_backend.reset(new EpollEventLoopBackend);
+
+    event_backend->add_counter_fd(wake_up_fd);
+    event_backend->add_counter_fd(timer_fd);
 }
 
-void usc::DBusEventLoop::add_connection(std::shared_ptr<DBusConnectionHandle> const& connection)
+void usc::DBusEventLoop::add_connection(
+    std::shared_ptr<DBusConnectionHandle> const& connection,
+    int priority)
 {
-    if (running)
-        BOOST_THROW_EXCEPTION(std::logic_error("Connection added after dbus event loop started"));
+    check_connections_can_change("Connection added");
+
+    priority = std::max(priority, 1);
+
+    // Services that share a connection each add it. It keeps one entry,
+    // at the highest priority asked for.
+    auto const existing = std::find_if(
+        connections.begin(), connections.end(),
+        [&connection] (ConnectionEntry const& entry) { return entry.handle == connection; });
+    if (existing != connections.end())
+    {
+        if (existing->priority < priority)
+        {
+            auto entry = std::move(*existing);
+            connections.erase(existing);
+            entry.priority = priority;
+
+            auto const position = std::find_if(
+                connections.begin(), connections.end(),
+                [priority] (ConnectionEntry const& other) { return other.priority < priority; });
+            connections.insert(position, std::move(entry));
+        }
+        return;
+    }
 
-    connections.push_back(connection);
+    auto const position = std::find_if(
+        connections.begin(), connections.end(),
+        [priority] (ConnectionEntry const& entry) { return entry.priority < priority; });
+    auto& entry = *connections.insert(
+        position,
+        ConnectionEntry{
+            connection,
+            priority,
+            std::unique_ptr<ConnectionWakeUp>{new ConnectionWakeUp{this, {false}}},
+            unique_name_of(*connection),
+            0});
+
+    // Connections added before the loop runs may learn their names later,
+    // so they get their stats entries in run()
+    if (running)
+        entry.stats_index = stats_.add_connection(stats_label_for(entry.name));
 
     dbus_connection_set_watch_functions(
         *connection,
@@ -136,79 +274,242 @@ void usc::DBusEventLoop::add_connection(std::shared_ptr<DBusConnectionHandle> co
 
     dbus_connection_set_wakeup_main_function(
         *connection,
-        DBusEventLoop::static_wake_up_loop,
-        this, nullptr);
+        DBusEventLoop::static_wake_up_loop_for_connection,
+        entry.wake_up.get(), nullptr);
 }
 
-usc::DBusEventLoop::~DBusEventLoop()
+void usc::DBusEventLoop::remove_connection(std::shared_ptr<DBusConnectionHandle> const& connection)
 {
-    stop();
+    check_connections_can_change("Connection removed");
+
+    auto const entry = std::find_if(
+        connections.begin(), connections.end(),
+        [&connection] (ConnectionEntry const& entry) { return entry.handle == connection; });
+    if (entry == connections.end())
+        return;
+
+    stop_watching(*entry);
+    connections.erase(entry);
+}
+
+void usc::DBusEventLoop::add_server(DBusServer* server)
+{
+    check_connections_can_change("Server added");
+
+    if (!dbus_server_set_watch_functions(
+            server,
+            DBusEventLoop::static_add_watch,
+            DBusEventLoop::static_remove_watch,
+            DBusEventLoop::static_toggle_watch,
+            this,
+            nullptr) ||
+        !dbus_server_set_timeout_functions(
+            server,
+            DBusEventLoop::static_add_timeout,
+            DBusEventLoop::static_remove_timeout,
+            DBusEventLoop::static_toggle_timeout,
+            this,
+            nullptr))
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("DBusEventLoop: Failed to watch server"));
+    }
+}
+
+void usc::DBusEventLoop::remove_server(DBusServer* server)
+{
+    check_connections_can_change("Server removed");
+
+    dbus_server_set_watch_functions(server, nullptr, nullptr, nullptr, nullptr, nullptr);
+    dbus_server_set_timeout_functions(server, nullptr, nullptr, nullptr, nullptr, nullptr);
+}
 
-    for(auto connection : connections)
+void usc::DBusEventLoop::check_connections_can_change(char const* change) const
+{
+    // The loop walks the connections and fds without holding a lock, so
+    // only it can change them while it runs, and only between walks
+    if (running && std::this_thread::get_id() != loop_thread)
     {
-        dbus_connection_set_watch_functions(
-            *connection, nullptr, nullptr, nullptr, nullptr, nullptr);
+        BOOST_THROW_EXCEPTION(
+            std::logic_error(std::string{change} + " after dbus event loop started"));
+    }
+}
+
+void usc::DBusEventLoop::stop_watching(ConnectionEntry const& connection)
+{
+    dbus_connection_set_watch_functions(
+        *connection.handle, nullptr, nullptr, nullptr, nullptr, nullptr);
+
+    dbus_connection_set_timeout_functions(
+        *connection.handle, nullptr, nullptr, nullptr, nullptr, nullptr);
+
+    dbus_connection_set_wakeup_main_function(
+        *connection.handle, nullptr, nullptr, nullptr);
+}
+
+usc::DBusEventLoop::~DBusEventLoop()
+{
+    stop();
 
-        dbus_connection_set_timeout_functions(
-            *connection, nullptr, nullptr, nullptr, nullptr, nullptr);
+    for(auto const& connection : connections)
+        stop_watching(connection);
 
-        dbus_connection_set_wakeup_main_function(
-            *connection, nullptr, nullptr, nullptr);
+    for (auto& entry : fd_table)
+    {
+        while (auto const node = entry.watches)
+        {
+            entry.watches = node->next;
+            delete node;
+        }
     }
 }
 
 void usc::DBusEventLoop::run(std::promise<void>& started)
 {
+    // Connections that registered with the bus without blocking only
+    // learnt their unique names after they were added
+    for (auto& connection : connections)
+    {
+        if (connection.name.empty())
+            connection.name = unique_name_of(*connection.handle);
+        connection.stats_index = stats_.add_connection(stats_label_for(connection.name));
+    }
+
+    loop_thread = std::this_thread::get_id();
     running = true;
     started.set_value();
 
+    std::vector<epoll_event> events(max_events_per_wakeup);
+    std::vector<epoll_event> events_to_redeliver;
+
     while (running)
     {
-        epoll_event event{};
-        int n = epoll_wait(epoll_fd, &event, 1, -1);
+        // Don't block if edge-triggered fds still have pending events, or
+        // connections or actions are left over from their dispatch budget
+        int const timeout =
+            pending_edge_events.empty() && !dispatch_pending && !actions_pending ? -1 : 0;
+        int n = event_backend->wait(events.data(), events.size(), timeout);
         if (n == -1)
         {
             if (errno == EINTR)
                 continue;
 
             BOOST_THROW_EXCEPTION(
-                std::system_error(errno, std::system_category(), "epoll_wait"));
+                std::system_error(errno, std::system_category(), "DBusEventLoop wait"));
         }
 
-        if (event.data.fd == wake_up_fd_r)
-        {
-            char c;
-            if (read(event.data.fd, &c, 1));
-        }
-        else
-        {
-            auto const& matching_watches = enabled_watches_for(event.data.fd);
-            for (auto const& watch : matching_watches)
-            {
-                dbus_watch_handle(watch, epoll_events_to_dbus_flags(event.events));
-            }
-
-            if (matching_watches.empty())
-            {
-                auto timeout = enabled_timeout_for(event.data.fd);
-                if (timeout)
-                    dbus_timeout_handle(timeout);
-            }
-        }
+        ++iteration_count;
+
+        instrumenting = instrumentation_enabled_.load(std::memory_order_relaxed);
+        auto const woke_up_at =
+            instrumenting ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+        events_to_redeliver.swap(pending_edge_events);
+
+        for (int i = 0; i < n; ++i)
+            handle_event(events[i]);
+
+        for (auto const& event : events_to_redeliver)
+            handle_event(event);
+
+        events_to_redeliver.clear();
+
+        run_due_timers();
 
-        dispatch_actions();
+        actions_pending = dispatch_actions();
 
-        for (auto connection : connections)
+        for (auto const& connection : connections)
+            write_outgoing_data(connection);
+
+        if (instrumenting)
+            stats_.record_wake_up_to_dispatch(std::chrono::steady_clock::now() - woke_up_at);
+
+        dispatch_pending = dispatch_connections();
+
+        if (instrumenting)
+            stats_.record_iteration_time(std::chrono::steady_clock::now() - woke_up_at);
+    }
+
+    event_backend->stop_waiting();
+
+    // Flush any remaining outgoing messages
+    for (auto const& connection : connections)
+        dbus_connection_flush(*connection.handle);
+}
+
+void usc::DBusEventLoop::write_outgoing_data(ConnectionEntry const& connection)
+{
+    if (!connection.wake_up->has_outgoing_data.exchange(false))
+        return;
+
+    // Write as much as the socket accepts without blocking. libdbus keeps
+    // the connection's write watch enabled while data remains, so the rest
+    // is written as EPOLLOUT reports the socket writable, rather than
+    // blocking the loop on a slow reader.
+    if (dbus_connection_has_messages_to_send(*connection.handle))
+        dbus_connection_read_write(*connection.handle, 0);
+}
+
+bool usc::DBusEventLoop::dispatch_connections()
+{
+    bool data_remains{false};
+
+    for (size_t begin = 0; begin < connections.size();)
+    {
+        auto const priority = connections[begin].priority;
+        auto end = begin;
+        while (end < connections.size() && connections[end].priority == priority)
+            ++end;
+
+        // Rotate the starting connection within each priority group, so
+        // equal priority connections take turns going first
+        auto const group_size = end - begin;
+        for (size_t i = 0; i < group_size; ++i)
         {
-            dbus_connection_flush(*connection);
+            auto const& connection =
+                connections[begin + (i + dispatch_round) % group_size];
 
-            while (dbus_connection_dispatch(*connection) == DBUS_DISPATCH_DATA_REMAINS);
+            if (dispatch_with_budget(connection, priority * messages_per_priority))
+                data_remains = true;
         }
+
+        begin = end;
     }
 
-    // Flush any remaining outgoing messages
-    for (auto connection : connections)
-        dbus_connection_flush(*connection);
+    ++dispatch_round;
+
+    return data_remains;
+}
+
+bool usc::DBusEventLoop::dispatch_with_budget(ConnectionEntry const& connection, int budget)
+{
+    for (int i = 0; i < budget; ++i)
+    {
+        auto const status = instrumenting ?
+            dispatch_instrumented(connection) :
+            dbus_connection_dispatch(*connection.handle);
+
+        if (status != DBUS_DISPATCH_DATA_REMAINS)
+            return false;
+    }
+
+    return dbus_connection_get_dispatch_status(*connection.handle) == DBUS_DISPATCH_DATA_REMAINS;
+}
+
+DBusDispatchStatus usc::DBusEventLoop::dispatch_instrumented(ConnectionEntry const& connection)
+{
+    auto const message = dbus_connection_borrow_message(*connection.handle);
+    if (!message)
+        return dbus_connection_dispatch(*connection.handle);
+
+    auto const method = method_index_of(stats_, message);
+    dbus_connection_return_message(*connection.handle, message);
+
+    auto const start = std::chrono::steady_clock::now();
+    auto const status = dbus_connection_dispatch(*connection.handle);
+    stats_.record_handler_time(
+        connection.stats_index, method, std::chrono::steady_clock::now() - start);
+
+    return status;
 }
 
 void usc::DBusEventLoop::stop()
@@ -217,52 +518,178 @@ void usc::DBusEventLoop::stop()
     wake_up_loop();
 }
 
-std::vector<DBusWatch*> usc::DBusEventLoop::enabled_watches_for(int fd)
+std::chrono::steady_clock::time_point usc::DBusEventLoop::now() const
 {
-    std::lock_guard<std::mutex> lock{mutex};
+    return clock->now();
+}
 
-    std::vector<DBusWatch*> ret_watches;
+uint64_t usc::DBusEventLoop::iterations() const
+{
+    return iteration_count;
+}
 
-    for (auto const& w : watches)
+void usc::DBusEventLoop::handle_event(epoll_event const& event)
+{
+    if (event.data.fd == wake_up_fd)
     {
-        if (dbus_watch_get_unix_fd(w) == fd &&
-            dbus_watch_get_enabled(w))
-        {
-            ret_watches.push_back(w);
-        }
+        drain_wake_up_fd();
+    }
+    else if (event.data.fd == timer_fd)
+    {
+        drain_timer_fd();
+    }
+    else
+    {
+        handle_watch_fd(event.data.fd, event.events);
+    }
+}
+
+bool usc::DBusEventLoop::handle_watch_fd(int fd, uint32_t events)
+{
+    auto output_before = trigger == Trigger::edge ? unread_output_bytes(fd) : 0;
+
+    if (!handle_enabled_watches(fd, events))
+        return false;
+
+    if (trigger == Trigger::level)
+        return true;
+
+    // With edge-triggered notifications we won't hear about this fd
+    // again until its state changes, so keep handling it while libdbus
+    // has more to read or write.
+    for (int round = 0; round < max_edge_triggered_drain_rounds; ++round)
+    {
+        events = edge_events_still_pending(fd, events, output_before);
+        if (events == 0)
+            return true;
+
+        output_before = unread_output_bytes(fd);
+        if (!handle_enabled_watches(fd, events))
+            return true;
+    }
+
+    events = edge_events_still_pending(fd, events, output_before);
+    if (events != 0)
+    {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        pending_edge_events.push_back(ev);
+    }
+
+    return true;
+}
+
+bool usc::DBusEventLoop::handle_enabled_watches(int fd, uint32_t events)
+{
+    auto const flags = epoll_events_to_dbus_flags(events);
+    int handled{0};
+
+    // Look up each watch just before handling it, since handling a watch
+    // may cause libdbus to remove others on the same fd
+    while (auto const watch = enabled_watch_for(fd, handled))
+    {
+        dbus_watch_handle(watch, flags);
+        ++handled;
     }
 
-    return ret_watches;
+    return handled > 0;
+}
+
+uint32_t usc::DBusEventLoop::edge_events_still_pending(
+    int fd, uint32_t events, int output_before)
+{
+    auto const enabled_events = enabled_events_for(fd);
+    uint32_t pending_events{0};
+
+    if ((events & EPOLLIN) && (enabled_events & EPOLLIN) && has_unread_data(fd))
+        pending_events |= EPOLLIN;
+
+    // libdbus keeps its write watch enabled until everything queued is
+    // sent, but writes only so much per dbus_watch_handle(). Only handle it
+    // again if the last write got somewhere: one that didn't found the
+    // socket full, and the kernel reports EPOLLOUT again once the peer
+    // reads, rather than us spinning until it does.
+    if ((events & EPOLLOUT) && (enabled_events & EPOLLOUT) &&
+        unread_output_bytes(fd) > output_before)
+    {
+        pending_events |= EPOLLOUT;
+    }
+
+    return pending_events;
+}
+
+uint32_t usc::DBusEventLoop::trigger_events() const
+{
+    return trigger == Trigger::edge ? EPOLLET : 0;
+}
+
+void usc::DBusEventLoop::drain_wake_up_fd()
+{
+    // The backend has already read the eventfd. Clear the pending flag so
+    // that a wake up requested after this point writes to the eventfd again.
+    // Anything enqueued before it is picked up by the dispatch_actions() call
+    // later in this iteration.
+    wake_up_pending = false;
+}
+
+void usc::DBusEventLoop::drain_timer_fd()
+{
+    // The timerfd is one-shot, so it's disarmed now that it has fired
+    std::lock_guard<std::mutex> lock{mutex};
+    timer_fd_armed = false;
+}
+
+usc::DBusEventLoop::FdEntry* usc::DBusEventLoop::fd_entry_for(int fd)
+{
+    if (fd < 0 || static_cast<size_t>(fd) >= fd_table.size())
+        return nullptr;
+
+    return &fd_table[fd];
 }
 
-DBusTimeout* usc::DBusEventLoop::enabled_timeout_for(int fd)
+usc::DBusEventLoop::FdEntry& usc::DBusEventLoop::create_fd_entry_for(int fd)
+{
+    if (static_cast<size_t>(fd) >= fd_table.size())
+        fd_table.resize(fd + 1);
+
+    return fd_table[fd];
+}
+
+DBusWatch* usc::DBusEventLoop::enabled_watch_for(int fd, int index)
 {
     std::lock_guard<std::mutex> lock{mutex};
 
-    for (auto const& p : timeouts)
+    auto const entry = fd_entry_for(fd);
+    if (!entry)
+        return nullptr;
+
+    for (auto node = entry->watches; node; node = node->next)
     {
-        if (p.second == fd && dbus_timeout_get_enabled(p.first))
-            return p.first;
+        if (dbus_watch_get_enabled(node->watch) && index-- == 0)
+            return node->watch;
     }
 
     return nullptr;
 }
 
+uint32_t usc::DBusEventLoop::enabled_events_for(int fd)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return epoll_events_for_watch_fd(fd);
+}
+
 dbus_bool_t usc::DBusEventLoop::add_watch(DBusWatch* watch)
 {
     std::lock_guard<std::mutex> lock{mutex};
 
     int const watch_fd = dbus_watch_get_unix_fd(watch);
 
-    if (!is_watched(watch_fd))
-    {
-        epoll_event ev{};
-        ev.data.fd = watch_fd;
-        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, watch_fd, &ev) == -1)
-            return FALSE;
-    }
+    if (!is_watched(watch_fd) && !event_backend->add(watch_fd, 0))
+        return FALSE;
 
-    watches.push_back(watch);
+    auto& entry = create_fd_entry_for(watch_fd);
+    entry.watches = new WatchNode{watch, entry.watches};
 
     update_events_for_watch_fd(watch_fd);
 
@@ -273,11 +700,24 @@ void usc::DBusEventLoop::remove_watch(DBusWatch* watch)
 {
     std::lock_guard<std::mutex> lock{mutex};
 
-    watches.erase(std::remove(begin(watches), end(watches), watch), end(watches));
-
     int const watch_fd = dbus_watch_get_unix_fd(watch);
+    auto const entry = fd_entry_for(watch_fd);
+    if (!entry)
+        return;
+
+    for (auto link = &entry->watches; *link; link = &(*link)->next)
+    {
+        if ((*link)->watch == watch)
+        {
+            auto const node = *link;
+            *link = node->next;
+            delete node;
+            break;
+        }
+    }
+
     if (!is_watched(watch_fd))
-        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, watch_fd, nullptr);
+        event_backend->remove(watch_fd);
     else
         update_events_for_watch_fd(watch_fd);
 }
@@ -292,29 +732,24 @@ void usc::DBusEventLoop::toggle_watch(DBusWatch* watch)
 
 void usc::DBusEventLoop::update_events_for_watch_fd(int watch_fd)
 {
-    epoll_event ev{};
-    ev.events = epoll_events_for_watch_fd(watch_fd);
-    ev.data.fd = watch_fd;
-    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, watch_fd, &ev);
+    event_backend->modify(
+        watch_fd, epoll_events_for_watch_fd(watch_fd) | trigger_events());
 }
 
 bool usc::DBusEventLoop::is_watched(int watch_fd)
 {
-    auto const iter = std::find_if(
-        begin(watches), end(watches),
-        [watch_fd] (DBusWatch* w) { return dbus_watch_get_unix_fd(w) == watch_fd; });
-
-    return iter != end(watches);
+    auto const entry = fd_entry_for(watch_fd);
+    return entry && entry->watches;
 }
 
 uint32_t usc::DBusEventLoop::epoll_events_for_watch_fd(int fd)
 {
     uint32_t events{};
 
-    for (auto const& watch : watches)
+    if (auto const entry = fd_entry_for(fd))
     {
-        if (dbus_watch_get_unix_fd(watch) == fd)
-            events |= dbus_flags_to_epoll_events(watch);
+        for (auto node = entry->watches; node; node = node->next)
+            events |= dbus_flags_to_epoll_events(node->watch);
     }
 
     return events;
@@ -324,102 +759,273 @@ dbus_bool_t usc::DBusEventLoop::add_timeout(DBusTimeout* timeout)
 {
     std::lock_guard<std::mutex> lock{mutex};
 
-    auto tfd = mir::Fd{timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC)};
+    schedule_timeout(timeout);
+    update_timer_fd();
 
-    epoll_event ev{};
-    ev.events = EPOLLIN;
-    ev.data.fd = tfd;
-
-    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, tfd, &ev))
-        return FALSE;
-
-    timeouts.emplace_back(timeout, std::move(tfd));
-
-    return update_timer_fd_for(timeout);
+    return TRUE;
 }
 
 void usc::DBusEventLoop::remove_timeout(DBusTimeout* timeout)
 {
     std::lock_guard<std::mutex> lock{mutex};
 
-    auto tfd = timer_fd_for(timeout);
-    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, tfd, nullptr);
-
-    timeouts.erase(
-        std::remove_if(begin(timeouts), end(timeouts),
-            [timeout] (decltype(timeouts)::const_reference p)
-            {
-                return p.first == timeout;
-            }),
-        end(timeouts));
+    auto const iter = timeout_ids.find(timeout);
+    if (iter == timeout_ids.end())
+        return;
 
+    timers.cancel(iter->second);
+    timeout_ids.erase(iter);
+    update_timer_fd();
 }
 
 void usc::DBusEventLoop::toggle_timeout(DBusTimeout* timeout)
 {
     std::lock_guard<std::mutex> lock{mutex};
-    update_timer_fd_for(timeout);
-}
 
+    schedule_timeout(timeout);
+    update_timer_fd();
+}
 
-dbus_bool_t usc::DBusEventLoop::update_timer_fd_for(DBusTimeout* timeout)
+void usc::DBusEventLoop::schedule_timeout(DBusTimeout* timeout)
 {
-    itimerspec spec{};
-
-    auto tfd = timer_fd_for(timeout);
+    auto& id = timeout_ids[timeout];
+    if (id)
+        timers.cancel(id);
+    id = 0;
 
     if (dbus_timeout_get_enabled(timeout))
     {
-        spec.it_interval = msec_to_timespec(dbus_timeout_get_interval(timeout));
-        spec.it_value = spec.it_interval;
+        auto const deadline = clock->now() +
+            std::chrono::milliseconds{dbus_timeout_get_interval(timeout)};
+        id = timers.add(deadline, [this, timeout] { handle_timeout(timeout); });
     }
+}
 
-    if (timerfd_settime(tfd, 0, &spec, nullptr) == -1)
-        return FALSE;
+void usc::DBusEventLoop::handle_timeout(DBusTimeout* timeout)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
 
-    return TRUE;
+        // Skip the timeout if it was removed, disabled or rescheduled after
+        // it became due
+        auto const iter = timeout_ids.find(timeout);
+        if (iter == timeout_ids.end() ||
+            timers.is_pending(iter->second) ||
+            !dbus_timeout_get_enabled(timeout))
+        {
+            return;
+        }
+
+        // libdbus timeouts fire periodically until removed or disabled
+        schedule_timeout(timeout);
+    }
+
+    dbus_timeout_handle(timeout);
 }
 
-int usc::DBusEventLoop::timer_fd_for(DBusTimeout* timeout)
+void usc::DBusEventLoop::run_due_timers()
 {
-    auto iter = std::find_if(begin(timeouts), end(timeouts),
-        [timeout] (std::pair<DBusTimeout*,int> const& p)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (timers.take_due(clock->now(), due_timer_tasks) == 0)
         {
-            return p.first == timeout;
-        });
-    return (iter == end(timeouts) ? -1 : iter->second);
+            update_timer_fd();
+            return;
+        }
+    }
+
+    for (auto& task : due_timer_tasks)
+        task();
+
+    due_timer_tasks.clear();
+
+    std::lock_guard<std::mutex> lock{mutex};
+    update_timer_fd();
+}
+
+void usc::DBusEventLoop::update_timer_fd()
+{
+    TimerQueue::TimePoint deadline;
+    bool const has_deadline = timers.next_deadline(deadline);
+
+    // Only touch the timerfd when the earliest deadline changes
+    if (has_deadline == timer_fd_armed &&
+        (!has_deadline || deadline == armed_deadline))
+    {
+        return;
+    }
+
+    itimerspec spec{};
+
+    if (has_deadline)
+    {
+        // Arm the timer relative to the loop's clock, which doesn't have to
+        // be CLOCK_MONOTONIC
+        auto const delay = std::max(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - clock->now()),
+            std::chrono::nanoseconds{1});
+        auto const sec = std::chrono::duration_cast<std::chrono::seconds>(delay);
+        spec.it_value.tv_sec = sec.count();
+        spec.it_value.tv_nsec = (delay - sec).count();
+    }
+
+    if (timerfd_settime(timer_fd, 0, &spec, nullptr) == 0)
+    {
+        timer_fd_armed = has_deadline;
+        armed_deadline = deadline;
+    }
 }
 
 void usc::DBusEventLoop::wake_up_loop()
 {
-    if (write(wake_up_fd_w, "a", 1) != 1)
+    // Any number of wake ups between two loop iterations cost a single write
+    if (wake_up_pending.exchange(true))
+        return;
+
+    uint64_t const one{1};
+    if (write(wake_up_fd, &one, sizeof one) != sizeof one)
     {
         BOOST_THROW_EXCEPTION(
             std::system_error(errno, std::system_category(), "write"));
     }
 }
 
-void usc::DBusEventLoop::enqueue(std::function<void()> const& action)
+void usc::DBusEventLoop::enqueue(Task action)
+{
+    enqueue(ActionPriority::normal, std::move(action));
+}
+
+void usc::DBusEventLoop::enqueue(ActionPriority priority, Task action)
 {
+    if (instrumentation_enabled_.load(std::memory_order_relaxed))
     {
-        std::lock_guard<std::mutex> lock{mutex};
-        actions.push_back(action);
+        int64_t no_pending_action{0};
+        first_pending_action_time.compare_exchange_strong(
+            no_pending_action, steady_clock_nanoseconds());
     }
 
+    if (priority == ActionPriority::urgent)
+        urgent_actions.push(std::move(action));
+    else
+        actions.push(std::move(action));
+
     wake_up_loop();
 }
 
-void usc::DBusEventLoop::dispatch_actions()
+void usc::DBusEventLoop::enqueue(
+    ActionPriority priority,
+    std::chrono::steady_clock::duration max_delay,
+    Task action)
+{
+    auto const deadline = clock->now() + max_delay;
+
+    enqueue(
+        priority,
+        [this, deadline, action = std::move(action)] () mutable
+        {
+            if (clock->now() > deadline)
+                ++deadline_miss_count;
+            action();
+        });
+}
+
+usc::DBusEventLoop::Backend usc::DBusEventLoop::backend() const
+{
+    return backend_;
+}
+
+uint64_t usc::DBusEventLoop::deadline_misses() const
+{
+    return deadline_miss_count;
+}
+
+usc::DBusEventLoop::DelayedAction usc::DBusEventLoop::enqueue_after(
+    std::chrono::steady_clock::duration delay, Task action)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const id = timers.add(clock->now() + delay, std::move(action));
+    update_timer_fd();
+
+    return DelayedAction{this, id};
+}
+
+bool usc::DBusEventLoop::cancel_delayed_action(TimerQueue::Id id)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (!timers.cancel(id))
+        return false;
+
+    update_timer_fd();
+    return true;
+}
+
+usc::DBusEventLoop::DelayedAction::DelayedAction()
+    : loop{nullptr}, id{0}
 {
-    decltype(actions) actions_to_dispatch;
+}
 
+usc::DBusEventLoop::DelayedAction::DelayedAction(DBusEventLoop* loop, TimerQueue::Id id)
+    : loop{loop}, id{id}
+{
+}
+
+bool usc::DBusEventLoop::DelayedAction::cancel()
+{
+    return loop && loop->cancel_delayed_action(id);
+}
+
+bool usc::DBusEventLoop::dispatch_actions()
+{
+    if (instrumenting)
     {
-        std::lock_guard<std::mutex> lock{mutex};
-        actions.swap(actions_to_dispatch);
+        auto const enqueued_at = first_pending_action_time.exchange(0);
+        if (enqueued_at != 0)
+        {
+            stats_.record_action_latency(
+                std::chrono::nanoseconds{steady_clock_nanoseconds() - enqueued_at});
+        }
+    }
+
+    size_t run = urgent_actions.run_pending();
+    bool more_pending{true};
+
+    // Run normal actions in batches, checking for urgent actions in
+    // between, so urgent work doesn't wait behind a large backlog
+    for (int batch = 0; batch < max_action_batches_per_iteration; ++batch)
+    {
+        auto const run_in_batch = actions.run_pending(action_batch_size);
+        run += run_in_batch;
+
+        if (run_in_batch < action_batch_size)
+        {
+            more_pending = false;
+            break;
+        }
+
+        run += urgent_actions.run_pending();
     }
 
-    for (auto const& action : actions_to_dispatch)
-        action();
+    if (instrumenting)
+        stats_.record_action_queue_depth(run);
+
+    return more_pending;
+}
+
+void usc::DBusEventLoop::set_instrumentation_enabled(bool enabled)
+{
+    instrumentation_enabled_ = enabled;
+}
+
+bool usc::DBusEventLoop::instrumentation_enabled() const
+{
+    return instrumentation_enabled_;
+}
+
+usc::DBusEventLoopStats& usc::DBusEventLoop::stats()
+{
+    return stats_;
 }
 
 dbus_bool_t usc::DBusEventLoop::static_add_watch(DBusWatch* watch, void* data)
@@ -452,7 +1058,9 @@ void usc::DBusEventLoop::static_toggle_timeout(DBusTimeout* timeout, void* data)
     static_cast<DBusEventLoop*>(data)->toggle_timeout(timeout);
 }
 
-void usc::DBusEventLoop::static_wake_up_loop(void* data)
+void usc::DBusEventLoop::static_wake_up_loop_for_connection(void* data)
 {
-    static_cast<DBusEventLoop*>(data)->wake_up_loop();
+    auto const wake_up = static_cast<ConnectionWakeUp*>(data);
+    wake_up->has_outgoing_data = true;
+    wake_up->loop->wake_up_loop();
 }
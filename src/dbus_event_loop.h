@@ -19,34 +19,181 @@
 #ifndef USC_DBUS_EVENT_LOOP_H_
 #define USC_DBUS_EVENT_LOOP_H_
 
+#include "dbus_event_loop_backend.h"
+#include "dbus_event_loop_stats.h"
+#include "task_queue.h"
+#include "timer_queue.h"
+
 #include <mir/fd.h>
 
 #include <dbus/dbus.h>
 
+#include <sys/epoll.h>
+
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <mutex>
 #include <future>
+#include <thread>
 
 namespace usc
 {
+class Clock;
 class DBusConnectionHandle;
 
 class DBusEventLoop
 {
 public:
+    enum class Trigger { level, edge };
+    // How the loop waits for its fds. io_uring falls back to epoll if the
+    // kernel doesn't support it.
+    enum class Backend { epoll, io_uring };
+
     DBusEventLoop();
+    DBusEventLoop(int max_events_per_wakeup, Trigger trigger);
+    DBusEventLoop(
+        int max_events_per_wakeup,
+        Trigger trigger,
+        std::shared_ptr<Clock> const& clock);
+    DBusEventLoop(
+        int max_events_per_wakeup,
+        Trigger trigger,
+        std::shared_ptr<Clock> const& clock,
+        Backend backend);
     ~DBusEventLoop();
 
-    void add_connection(std::shared_ptr<DBusConnectionHandle> const& connection);
+    // Connections are dispatched in order of decreasing priority, round-robin
+    // among connections of equal priority. On each loop iteration a
+    // connection may dispatch up to priority * messages_per_priority
+    // messages before the loop moves on, so a busy connection can't starve
+    // the others. A connection can be added more than once, by each of the
+    // services sharing it, and then has the highest of the priorities.
+    static int const default_priority = 1;
+    static int const messages_per_priority = 8;
+
+    // Connections are added before the loop starts, except that once it
+    // runs its own actions (see enqueue()) can add and remove them, for
+    // peers that connect to a DBusServer the loop watches
+    void add_connection(
+        std::shared_ptr<DBusConnectionHandle> const& connection,
+        int priority = default_priority);
+    void remove_connection(std::shared_ptr<DBusConnectionHandle> const& connection);
+
+    // Watches server for new connections, which libdbus hands to the
+    // server's new connection function on the loop thread. Added and
+    // removed like connections, and removed before the loop is destroyed.
+    void add_server(DBusServer* server);
+    void remove_server(DBusServer* server);
     void run(std::promise<void>& started);
     void stop();
 
-    void enqueue(std::function<void()> const& action);
+    // Urgent actions run before any normal ones that are pending. An
+    // action that starts running more than max_delay after it was enqueued,
+    // on the loop's clock, counts as a deadline miss.
+    enum class ActionPriority { normal, urgent };
+
+    void enqueue(Task action);
+    void enqueue(ActionPriority priority, Task action);
+    void enqueue(
+        ActionPriority priority,
+        std::chrono::steady_clock::duration max_delay,
+        Task action);
+
+    uint64_t deadline_misses() const;
+
+    // The backend actually in use
+    Backend backend() const;
+
+    // Instrumentation is off by default. While it's on, the loop records
+    // latencies, action queue depths and per-connection and per-method
+    // handler times in stats().
+    void set_instrumentation_enabled(bool enabled);
+    bool instrumentation_enabled() const;
+    DBusEventLoopStats& stats();
+
+    // A handle to an action scheduled with enqueue_after(). Destroying the
+    // handle doesn't cancel the action, and the handle must not be used
+    // after the loop is destroyed.
+    class DelayedAction
+    {
+    public:
+        DelayedAction();
+
+        // Returns false if the action has already started running or
+        // has been cancelled
+        bool cancel();
+
+    private:
+        friend class DBusEventLoop;
+        DelayedAction(DBusEventLoop* loop, TimerQueue::Id id);
+
+        DBusEventLoop* loop;
+        TimerQueue::Id id;
+    };
+
+    // Runs the action on the loop thread once delay has elapsed on the
+    // loop's clock
+    DelayedAction enqueue_after(
+        std::chrono::steady_clock::duration delay, Task action);
+
+    // The time on the loop's clock, which delays and deadlines are
+    // measured on
+    std::chrono::steady_clock::time_point now() const;
+
+    // The number of times the loop has woken up to handle events
+    uint64_t iterations() const;
 
 private:
-    std::vector<DBusWatch*> enabled_watches_for(int fd);
-    DBusTimeout* enabled_timeout_for(int fd);
+    // Per-fd state, indexed directly by fd number. Watches sharing an fd
+    // are kept in an intrusive singly linked list.
+    struct WatchNode
+    {
+        DBusWatch* watch;
+        WatchNode* next;
+    };
+
+    struct FdEntry
+    {
+        WatchNode* watches{nullptr};
+    };
+
+    FdEntry* fd_entry_for(int fd);
+    FdEntry& create_fd_entry_for(int fd);
+
+    // The wakeup_main data of each connection. libdbus calls wakeup_main
+    // when it has queued outgoing data it couldn't write straight away.
+    struct ConnectionWakeUp
+    {
+        DBusEventLoop* const loop;
+        std::atomic<bool> has_outgoing_data;
+    };
+
+    struct ConnectionEntry
+    {
+        std::shared_ptr<DBusConnectionHandle> handle;
+        int priority;
+        std::unique_ptr<ConnectionWakeUp> wake_up;
+        // The unique bus name, used to label instrumentation
+        std::string name;
+        size_t stats_index;
+    };
+
+    void check_connections_can_change(char const* change) const;
+    void stop_watching(ConnectionEntry const& connection);
+
+    void handle_event(epoll_event const& event);
+    bool handle_watch_fd(int fd, uint32_t events);
+    bool handle_enabled_watches(int fd, uint32_t events);
+    uint32_t edge_events_still_pending(int fd, uint32_t events, int output_before);
+    uint32_t trigger_events() const;
+    void drain_wake_up_fd();
+    void drain_timer_fd();
+
+    DBusWatch* enabled_watch_for(int fd, int index);
+    uint32_t enabled_events_for(int fd);
 
     dbus_bool_t add_watch(DBusWatch* watch);
     void remove_watch(DBusWatch* watch);
@@ -58,11 +205,18 @@ private:
     dbus_bool_t add_timeout(DBusTimeout* timeout);
     void remove_timeout(DBusTimeout* timeout);
     void toggle_timeout(DBusTimeout* timeout);
-    dbus_bool_t update_timer_fd_for(DBusTimeout* timeout);
-    int timer_fd_for(DBusTimeout* timeout);
+    void schedule_timeout(DBusTimeout* timeout);
+    void handle_timeout(DBusTimeout* timeout);
+    void run_due_timers();
+    void update_timer_fd();
+    bool cancel_delayed_action(TimerQueue::Id id);
 
     void wake_up_loop();
-    void dispatch_actions();
+    bool dispatch_actions();
+    void write_outgoing_data(ConnectionEntry const& connection);
+    bool dispatch_connections();
+    bool dispatch_with_budget(ConnectionEntry const& connection, int budget);
+    DBusDispatchStatus dispatch_instrumented(ConnectionEntry const& connection);
 
     static dbus_bool_t static_add_watch(DBusWatch* watch, void* data);
     static void static_remove_watch(DBusWatch* watch, void* data);
@@ -70,18 +224,48 @@ private:
     static dbus_bool_t static_add_timeout(DBusTimeout* timeout, void* data);
     static void static_remove_timeout(DBusTimeout* timeout, void* data);
     static void static_toggle_timeout(DBusTimeout* timeout, void* data);
-    static void static_wake_up_loop(void* data);
+    static void static_wake_up_loop_for_connection(void* data);
 
+    int const max_events_per_wakeup;
+    Trigger const trigger;
     std::atomic<bool> running;
+    // Set before running, so valid whenever it is
+    std::thread::id loop_thread;
+    std::atomic<uint64_t> iteration_count;
+    std::atomic<bool> wake_up_pending;
+    std::vector<epoll_event> pending_edge_events;
+    std::shared_ptr<Clock> const clock;
+    bool dispatch_pending;
+    bool actions_pending;
+    size_t dispatch_round;
 
     std::mutex mutex;
-    std::vector<std::shared_ptr<DBusConnectionHandle>> connections;
-    std::vector<DBusWatch*> watches;
-    std::vector<std::pair<DBusTimeout*,mir::Fd>> timeouts;
-    std::vector<std::function<void(void)>> actions;
-    mir::Fd epoll_fd;
-    mir::Fd wake_up_fd_r;
-    mir::Fd wake_up_fd_w;
+    // Sorted by decreasing priority
+    std::vector<ConnectionEntry> connections;
+    std::vector<FdEntry> fd_table;
+    // libdbus timeouts and delayed actions share a single timerfd, armed
+    // for the earliest deadline in the timer queue
+    TimerQueue timers;
+    std::unordered_map<DBusTimeout*, TimerQueue::Id> timeout_ids;
+    std::vector<Task> due_timer_tasks;
+    bool timer_fd_armed;
+    TimerQueue::TimePoint armed_deadline;
+    TaskQueue urgent_actions;
+    TaskQueue actions;
+    std::atomic<uint64_t> deadline_miss_count;
+
+    std::atomic<bool> instrumentation_enabled_;
+    // Whether the current iteration is instrumented. Only used by the loop
+    // thread.
+    bool instrumenting;
+    // When the oldest action not yet dispatched was enqueued, in steady
+    // clock nanoseconds, or 0 if there is none
+    std::atomic<int64_t> first_pending_action_time;
+    DBusEventLoopStats stats_;
+    mir::Fd wake_up_fd;
+    mir::Fd timer_fd;
+    Backend backend_;
+    std::unique_ptr<DBusEventLoopBackend> event_backend;
 };
 
 }
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_DBUS_EVENT_LOOP_BACKEND_H_
+#define USC_DBUS_EVENT_LOOP_BACKEND_H_
+
+#include <sys/epoll.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace usc
+{
+
+// How a DBusEventLoop waits for its fds to become ready. Interest and
+// readiness are expressed with epoll flags whatever the implementation.
+//
+// add(), modify() and remove() may be called from any thread while the
+// loop thread is in wait(), but implementations may delay applying them
+// until the next call to wait().
+class DBusEventLoopBackend
+{
+public:
+    virtual ~DBusEventLoopBackend() = default;
+
+    // Watches an eventfd or timerfd. The backend consumes the counter
+    // before reporting the fd as readable, so the loop doesn't read it.
+    virtual void add_counter_fd(int fd) = 0;
+
+    virtual bool add(int fd, uint32_t events) = 0;
+    virtual void modify(int fd, uint32_t events) = 0;
+    virtual void remove(int fd) = 0;
+
+    // Returns the number of events stored in events, or -1 with errno set.
+    // A timeout_ms of -1 waits indefinitely.
+    virtual int wait(epoll_event* events, int max_events, int timeout_ms) = 0;
+
+    // Called by the thread that calls wait() once it won't wait any more
+    virtual void stop_waiting() {}
+
+    // The number of syscalls the backend has made
+    uint64_t syscalls() const { return syscall_count; }
+
+protected:
+    DBusEventLoopBackend() : syscall_count{0} {}
+
+    std::atomic<uint64_t> syscall_count;
+
+private:
+    DBusEventLoopBackend(DBusEventLoopBackend const&) = delete;
+    DBusEventLoopBackend& operator=(DBusEventLoopBackend const&) = delete;
+};
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbus_event_loop_pool.h"
+#include "dbus_event_loop.h"
+
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+
+usc::DBusEventLoopPool::DBusEventLoopPool(
+    std::vector<std::shared_ptr<DBusEventLoop>> const& loops)
+    : loops_{loops},
+      next_loop{0}
+{
+    if (loops_.empty())
+        BOOST_THROW_EXCEPTION(std::invalid_argument("DBusEventLoopPool needs at least one loop"));
+}
+
+std::shared_ptr<usc::DBusEventLoop> usc::DBusEventLoopPool::loop_for(std::string const& service)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& loop = service_loops[service];
+    if (!loop)
+    {
+        loop = loops_[next_loop];
+        next_loop = (next_loop + 1) % loops_.size();
+    }
+
+    return loop;
+}
+
+void usc::DBusEventLoopPool::enqueue(std::string const& service, Task action)
+{
+    loop_for(service)->enqueue(std::move(action));
+}
+
+std::vector<std::shared_ptr<usc::DBusEventLoop>> const& usc::DBusEventLoopPool::loops() const
+{
+    return loops_;
+}
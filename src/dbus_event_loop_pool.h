@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_DBUS_EVENT_LOOP_POOL_H_
+#define USC_DBUS_EVENT_LOOP_POOL_H_
+
+#include "task.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace usc
+{
+class DBusEventLoop;
+
+// A fixed set of D-Bus event loops, each meant to run on its own thread,
+// with the D-Bus services spread across them so that a service blocked in
+// a slow handler doesn't hold up the others.
+class DBusEventLoopPool
+{
+public:
+    explicit DBusEventLoopPool(std::vector<std::shared_ptr<DBusEventLoop>> const& loops);
+
+    // Returns the loop serving service. Services are assigned to loops
+    // round-robin, in the order they are first asked for.
+    std::shared_ptr<DBusEventLoop> loop_for(std::string const& service);
+
+    // Runs the action on the loop serving service
+    void enqueue(std::string const& service, Task action);
+
+    std::vector<std::shared_ptr<DBusEventLoop>> const& loops() const;
+
+private:
+    DBusEventLoopPool(DBusEventLoopPool const&) = delete;
+    DBusEventLoopPool& operator=(DBusEventLoopPool const&) = delete;
+
+    std::vector<std::shared_ptr<DBusEventLoop>> const loops_;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<DBusEventLoop>> service_loops;
+    size_t next_loop;
+};
+
+}
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbus_event_loop_stats.h"
+#include "dbus_method_table.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace
+{
+
+void report_histogram(
+    std::ostream& out, char const* name, usc::LatencyHistogram const& histogram)
+{
+    auto const counts = histogram.counts();
+
+    out << name << ":";
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        if (counts[i] == 0)
+            continue;
+
+        auto const lower = i == 0 ? 0 : 1ull << (i - 1);
+        out << " [" << lower << "us,";
+        if (i + 1 < counts.size())
+            out << (1ull << i) << "us)";
+        else
+            out << "inf)";
+        out << "=" << counts[i];
+    }
+    out << "\n";
+}
+
+template<typename Times>
+void report_handler_times(std::ostream& out, char const* kind, Times const& times)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    for (auto const& entry : times)
+    {
+        auto const calls = entry.calls.load(std::memory_order_relaxed);
+        if (calls == 0)
+            continue;
+
+        std::chrono::nanoseconds const total{entry.total_ns.load(std::memory_order_relaxed)};
+        std::chrono::nanoseconds const max{entry.max_ns.load(std::memory_order_relaxed)};
+
+        out << kind << " " << entry.name
+            << ": calls=" << calls
+            << " total=" << duration_cast<microseconds>(total).count() << "us"
+            << " max=" << duration_cast<microseconds>(max).count() << "us\n";
+    }
+}
+
+}
+
+usc::LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void usc::LatencyHistogram::record(std::chrono::nanoseconds duration)
+{
+    buckets[bucket_for(duration)].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::array<uint64_t, usc::LatencyHistogram::num_buckets> usc::LatencyHistogram::counts() const
+{
+    std::array<uint64_t, num_buckets> result;
+
+    for (size_t i = 0; i < num_buckets; ++i)
+        result[i] = buckets[i].load(std::memory_order_relaxed);
+
+    return result;
+}
+
+void usc::LatencyHistogram::reset()
+{
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+size_t usc::LatencyHistogram::bucket_for(std::chrono::nanoseconds duration)
+{
+    auto const us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    if (us <= 0)
+        return 0;
+
+    // The bucket is one more than the position of the highest set bit
+    size_t const bucket = 64 - __builtin_clzll(static_cast<unsigned long long>(us));
+    return std::min(bucket, num_buckets - 1);
+}
+
+usc::DBusEventLoopStats::HandlerTimes::HandlerTimes(std::string const& name)
+    : name{name}
+{
+    reset();
+}
+
+void usc::DBusEventLoopStats::HandlerTimes::reset()
+{
+    calls.store(0, std::memory_order_relaxed);
+    total_ns.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+}
+
+usc::DBusEventLoopStats::DBusEventLoopStats()
+    : last_action_queue_depth{0},
+      max_action_queue_depth{0}
+{
+    for (auto const name : {"(other)", "(method return)", "(error)"})
+    {
+        method_times.emplace_back(name);
+        method_names.push_back({"", ""});
+    }
+}
+
+void usc::DBusEventLoopStats::add_methods(DBusMethodTable const& table)
+{
+    table.for_each_method(
+        [this] (char const* interface, char const* member) { add_method(interface, member); });
+}
+
+size_t usc::DBusEventLoopStats::add_method(char const* interface, char const* member)
+{
+    std::lock_guard<std::mutex> lock{handler_times_mutex};
+
+    // Two methods sharing a hash is unlikely enough that the second just
+    // counts as (other)
+    auto const hash = DBusMethodTable::hash_method(interface, member);
+    auto const existing = method_indices.find(hash);
+    if (existing != method_indices.end())
+        return method_index(interface, member);
+
+    auto const index = method_times.size();
+    method_times.emplace_back(std::string{interface} + "." + member);
+    method_names.push_back({interface, member});
+    method_indices.emplace(hash, index);
+
+    return index;
+}
+
+size_t usc::DBusEventLoopStats::add_connection(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock{handler_times_mutex};
+
+    auto const existing = std::find_if(
+        connection_times.begin(), connection_times.end(),
+        [&name] (HandlerTimes const& times) { return times.name == name; });
+    if (existing != connection_times.end())
+        return existing - connection_times.begin();
+
+    connection_times.emplace_back(name);
+    return connection_times.size() - 1;
+}
+
+size_t usc::DBusEventLoopStats::method_index(char const* interface, char const* member) const
+{
+    auto const iter = method_indices.find(DBusMethodTable::hash_method(interface, member));
+    if (iter == method_indices.end())
+        return other_method;
+
+    auto const& name = method_names[iter->second];
+    if (name.interface != interface || name.member != member)
+        return other_method;
+
+    return iter->second;
+}
+
+void usc::DBusEventLoopStats::record_wake_up_to_dispatch(std::chrono::nanoseconds duration)
+{
+    wake_up_to_dispatch.record(duration);
+}
+
+void usc::DBusEventLoopStats::record_action_latency(std::chrono::nanoseconds duration)
+{
+    action_latency.record(duration);
+}
+
+void usc::DBusEventLoopStats::record_iteration_time(std::chrono::nanoseconds duration)
+{
+    iteration_time.record(duration);
+}
+
+void usc::DBusEventLoopStats::record_action_queue_depth(size_t depth)
+{
+    last_action_queue_depth.store(depth, std::memory_order_relaxed);
+
+    // Only the loop thread records, so this doesn't need to be a CAS loop
+    if (depth > max_action_queue_depth.load(std::memory_order_relaxed))
+        max_action_queue_depth.store(depth, std::memory_order_relaxed);
+}
+
+void usc::DBusEventLoopStats::record_handler_time(
+    size_t connection, size_t method, std::chrono::nanoseconds duration)
+{
+    // Only the loop thread records, so the max doesn't need a CAS loop
+    for (auto times : {&connection_times[connection], &method_times[method]})
+    {
+        times->calls.fetch_add(1, std::memory_order_relaxed);
+        times->total_ns.fetch_add(duration.count(), std::memory_order_relaxed);
+        if (duration.count() > times->max_ns.load(std::memory_order_relaxed))
+            times->max_ns.store(duration.count(), std::memory_order_relaxed);
+    }
+}
+
+std::string usc::DBusEventLoopStats::report() const
+{
+    std::ostringstream out;
+
+    report_histogram(out, "wake_up_to_dispatch", wake_up_to_dispatch);
+    report_histogram(out, "action_latency", action_latency);
+    report_histogram(out, "iteration_time", iteration_time);
+    out << "action_queue_depth: last=" << last_action_queue_depth.load()
+        << " max=" << max_action_queue_depth.load() << "\n";
+
+    std::lock_guard<std::mutex> lock{handler_times_mutex};
+    report_handler_times(out, "connection", connection_times);
+    report_handler_times(out, "method", method_times);
+
+    return out.str();
+}
+
+void usc::DBusEventLoopStats::reset()
+{
+    wake_up_to_dispatch.reset();
+    action_latency.reset();
+    iteration_time.reset();
+    last_action_queue_depth = 0;
+    max_action_queue_depth = 0;
+
+    // Keep the entries, as the loop holds indices into them
+    std::lock_guard<std::mutex> lock{handler_times_mutex};
+    for (auto& times : connection_times)
+        times.reset();
+    for (auto& times : method_times)
+        times.reset();
+}
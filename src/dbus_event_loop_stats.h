@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_DBUS_EVENT_LOOP_STATS_H_
+#define USC_DBUS_EVENT_LOOP_STATS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace usc
+{
+class DBusMethodTable;
+
+// Counts durations in power of two microsecond buckets: bucket 0 holds
+// durations under 1us, bucket i durations in [2^(i-1), 2^i) us, and the
+// last bucket everything longer. Recording is lock-free.
+class LatencyHistogram
+{
+public:
+    static size_t const num_buckets = 24;
+
+    LatencyHistogram();
+
+    void record(std::chrono::nanoseconds duration);
+    std::array<uint64_t, num_buckets> counts() const;
+    void reset();
+
+    static size_t bucket_for(std::chrono::nanoseconds duration);
+
+private:
+    std::array<std::atomic<uint64_t>, num_buckets> buckets;
+};
+
+// Measurements taken by a DBusEventLoop while its instrumentation is
+// enabled. Written by the loop thread, and safe to read from any thread.
+//
+// Handler times are kept per connection and per method of the tables
+// added with add_methods(). Calls to anything else share one "(other)"
+// entry, so that clients calling made up methods can't grow the stats,
+// and recording a call only indexes into entries that already exist.
+class DBusEventLoopStats
+{
+public:
+    // The entries every stats object starts with
+    static size_t const other_method = 0;
+    static size_t const method_return = 1;
+    static size_t const error_reply = 2;
+
+    DBusEventLoopStats();
+
+    // Called before the loop starts, or on its thread. Adding a name
+    // already added returns the existing entry.
+    void add_methods(DBusMethodTable const& table);
+    size_t add_connection(std::string const& name);
+
+    // The entry for a method call or signal, or other_method
+    size_t method_index(char const* interface, char const* member) const;
+
+    // Time from epoll_wait() returning to the loop starting to dispatch
+    // D-Bus messages
+    void record_wake_up_to_dispatch(std::chrono::nanoseconds duration);
+    // Time from an action being enqueued on an idle queue to it running
+    void record_action_latency(std::chrono::nanoseconds duration);
+    void record_iteration_time(std::chrono::nanoseconds duration);
+    void record_action_queue_depth(size_t depth);
+    void record_handler_time(
+        size_t connection, size_t method, std::chrono::nanoseconds duration);
+
+    // A human readable summary of everything recorded so far
+    std::string report() const;
+    void reset();
+
+private:
+    struct HandlerTimes
+    {
+        explicit HandlerTimes(std::string const& name);
+        void reset();
+
+        std::string const name;
+        std::atomic<uint64_t> calls;
+        std::atomic<int64_t> total_ns;
+        std::atomic<int64_t> max_ns;
+    };
+
+    struct MethodName
+    {
+        std::string interface;
+        std::string member;
+    };
+
+    size_t add_method(char const* interface, char const* member);
+
+    LatencyHistogram wake_up_to_dispatch;
+    LatencyHistogram action_latency;
+    LatencyHistogram iteration_time;
+    std::atomic<size_t> last_action_queue_depth;
+    std::atomic<size_t> max_action_queue_depth;
+
+    // Guards adding entries against reading them all. Recording reads only
+    // entries that exist, on the thread that adds them.
+    mutable std::mutex handler_times_mutex;
+    std::deque<HandlerTimes> connection_times;
+    std::deque<HandlerTimes> method_times;
+    std::vector<MethodName> method_names;
+    std::unordered_map<uint64_t, size_t> method_indices;
+};
+
+}
+
+#endif
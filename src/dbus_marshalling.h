@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_DBUS_MARSHALLING_H_
+#define USC_DBUS_MARSHALLING_H_
+
+#include "dbus_message_handle.h"
+
+#include <dbus/dbus.h>
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace usc
+{
+
+// Reads and appends C++ values as D-Bus values, with the D-Bus type fixed
+// at compile time by the C++ type. Used by the stubs that
+// tools/dbus_xml2stubs.py generates from the introspection XML:
+//
+//   bool          b      int32_t   i      std::string     s
+//   uint8_t       y      uint32_t  u      std::tuple<...> (...)
+//   double        d      int64_t   x      std::vector<T>  aT
+//                        uint64_t  t      DBusVariantDict a{sv} (read only)
+//
+// read() returns false, leaving value unspecified, if the value at iter has
+// a different type. Both read() and append() move iter past the value.
+template<typename T>
+struct DBusMarshal;
+
+template<typename T, int dbus_type, typename Wire = T>
+struct DBusBasicMarshal
+{
+    static std::string signature()
+    {
+        return std::string(1, static_cast<char>(dbus_type));
+    }
+
+    static bool read(DBusMessageIter* iter, T& value)
+    {
+        if (dbus_message_iter_get_arg_type(iter) != dbus_type)
+            return false;
+
+        Wire wire;
+        dbus_message_iter_get_basic(iter, &wire);
+        value = static_cast<T>(wire);
+        dbus_message_iter_next(iter);
+        return true;
+    }
+
+    static void append(DBusMessageIter* iter, T const& value)
+    {
+        Wire const wire = value;
+        dbus_message_iter_append_basic(iter, dbus_type, &wire);
+    }
+};
+
+template<> struct DBusMarshal<bool> : DBusBasicMarshal<bool, DBUS_TYPE_BOOLEAN, dbus_bool_t> {};
+template<> struct DBusMarshal<uint8_t> : DBusBasicMarshal<uint8_t, DBUS_TYPE_BYTE> {};
+template<> struct DBusMarshal<int32_t> : DBusBasicMarshal<int32_t, DBUS_TYPE_INT32, dbus_int32_t> {};
+template<> struct DBusMarshal<uint32_t> : DBusBasicMarshal<uint32_t, DBUS_TYPE_UINT32, dbus_uint32_t> {};
+template<> struct DBusMarshal<int64_t> : DBusBasicMarshal<int64_t, DBUS_TYPE_INT64, dbus_int64_t> {};
+template<> struct DBusMarshal<uint64_t> : DBusBasicMarshal<uint64_t, DBUS_TYPE_UINT64, dbus_uint64_t> {};
+template<> struct DBusMarshal<double> : DBusBasicMarshal<double, DBUS_TYPE_DOUBLE> {};
+
+template<>
+struct DBusMarshal<std::string>
+{
+    static std::string signature() { return DBUS_TYPE_STRING_AS_STRING; }
+
+    static bool read(DBusMessageIter* iter, std::string& value)
+    {
+        if (dbus_message_iter_get_arg_type(iter) != DBUS_TYPE_STRING)
+            return false;
+
+        char const* str{""};
+        dbus_message_iter_get_basic(iter, &str);
+        value = str;
+        dbus_message_iter_next(iter);
+        return true;
+    }
+
+    static void append(DBusMessageIter* iter, std::string const& value)
+    {
+        auto const str = value.c_str();
+        dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, &str);
+    }
+};
+
+template<typename... Ts>
+struct DBusMarshal<std::tuple<Ts...>>
+{
+    static std::string signature()
+    {
+        std::string result{"("};
+        for (auto const& member : {DBusMarshal<Ts>::signature()...})
+            result += member;
+        return result + ")";
+    }
+
+    static bool read(DBusMessageIter* iter, std::tuple<Ts...>& value)
+    {
+        if (dbus_message_iter_get_arg_type(iter) != DBUS_TYPE_STRUCT)
+            return false;
+
+        DBusMessageIter iter_struct;
+        dbus_message_iter_recurse(iter, &iter_struct);
+        if (!read_members(&iter_struct, value, std::index_sequence_for<Ts...>{}))
+            return false;
+
+        dbus_message_iter_next(iter);
+        return true;
+    }
+
+    static void append(DBusMessageIter* iter, std::tuple<Ts...> const& value)
+    {
+        DBusMessageIter iter_struct;
+        dbus_message_iter_open_container(iter, DBUS_TYPE_STRUCT, nullptr, &iter_struct);
+        append_members(&iter_struct, value, std::index_sequence_for<Ts...>{});
+        dbus_message_iter_close_container(iter, &iter_struct);
+    }
+
+private:
+    template<size_t... Is>
+    static bool read_members(
+        DBusMessageIter* iter, std::tuple<Ts...>& value, std::index_sequence<Is...>)
+    {
+        bool ok{true};
+        for (bool member_ok : {true, (ok = ok && DBusMarshal<Ts>::read(iter, std::get<Is>(value)))...})
+            (void)member_ok;
+        return ok;
+    }
+
+    template<size_t... Is>
+    static void append_members(
+        DBusMessageIter* iter, std::tuple<Ts...> const& value, std::index_sequence<Is...>)
+    {
+        for (bool appended : {true, (DBusMarshal<Ts>::append(iter, std::get<Is>(value)), true)...})
+            (void)appended;
+    }
+};
+
+template<typename T>
+struct DBusMarshal<std::vector<T>>
+{
+    static std::string signature() { return "a" + DBusMarshal<T>::signature(); }
+
+    static bool read(DBusMessageIter* iter, std::vector<T>& value)
+    {
+        if (dbus_message_iter_get_arg_type(iter) != DBUS_TYPE_ARRAY)
+            return false;
+
+        DBusMessageIter iter_array;
+        dbus_message_iter_recurse(iter, &iter_array);
+
+        value.clear();
+        while (dbus_message_iter_get_arg_type(&iter_array) != DBUS_TYPE_INVALID)
+        {
+            T element;
+            if (!DBusMarshal<T>::read(&iter_array, element))
+                return false;
+            value.push_back(std::move(element));
+        }
+
+        dbus_message_iter_next(iter);
+        return true;
+    }
+
+    static void append(DBusMessageIter* iter, std::vector<T> const& value)
+    {
+        DBusMessageIter iter_array;
+        dbus_message_iter_open_container(
+            iter, DBUS_TYPE_ARRAY, DBusMarshal<T>::signature().c_str(), &iter_array);
+        for (auto const& element : value)
+            DBusMarshal<T>::append(&iter_array, element);
+        dbus_message_iter_close_container(iter, &iter_array);
+    }
+};
+
+// An a{sv} argument, such as a set of settings to change, whose entries
+// are read by the handler with the types their names call for. Only valid
+// while the message it was read from is.
+class DBusVariantDict
+{
+public:
+    DBusVariantDict() : valid{false} {}
+
+    // Calls f(char const* name, DBusMessageIter* value) for each entry,
+    // with value at the contents of the variant. Stops and returns false
+    // as soon as f does.
+    template<typename F>
+    bool for_each(F const& f) const
+    {
+        if (!valid)
+            return true;
+
+        // Iterators are plain structs, so each call starts from a copy
+        DBusMessageIter iter_array = array;
+
+        while (dbus_message_iter_get_arg_type(&iter_array) == DBUS_TYPE_DICT_ENTRY)
+        {
+            DBusMessageIter iter_entry;
+            dbus_message_iter_recurse(&iter_array, &iter_entry);
+
+            char const* name{""};
+            dbus_message_iter_get_basic(&iter_entry, &name);
+            dbus_message_iter_next(&iter_entry);
+
+            DBusMessageIter iter_value;
+            dbus_message_iter_recurse(&iter_entry, &iter_value);
+
+            if (!f(name, &iter_value))
+                return false;
+
+            dbus_message_iter_next(&iter_array);
+        }
+
+        return true;
+    }
+
+private:
+    friend struct DBusMarshal<DBusVariantDict>;
+
+    bool valid;
+    DBusMessageIter array;
+};
+
+template<>
+struct DBusMarshal<DBusVariantDict>
+{
+    static std::string signature() { return "a{sv}"; }
+
+    static bool read(DBusMessageIter* iter, DBusVariantDict& value)
+    {
+        if (dbus_message_iter_get_arg_type(iter) != DBUS_TYPE_ARRAY ||
+            dbus_message_iter_get_element_type(iter) != DBUS_TYPE_DICT_ENTRY)
+        {
+            return false;
+        }
+
+        DBusMessageIter iter_array;
+        dbus_message_iter_recurse(iter, &iter_array);
+
+        // Check the entries once here, so for_each() can trust them
+        for (auto check = iter_array;
+             dbus_message_iter_get_arg_type(&check) == DBUS_TYPE_DICT_ENTRY;
+             dbus_message_iter_next(&check))
+        {
+            DBusMessageIter iter_entry;
+            dbus_message_iter_recurse(&check, &iter_entry);
+            if (dbus_message_iter_get_arg_type(&iter_entry) != DBUS_TYPE_STRING)
+                return false;
+            dbus_message_iter_next(&iter_entry);
+            if (dbus_message_iter_get_arg_type(&iter_entry) != DBUS_TYPE_VARIANT)
+                return false;
+        }
+
+        value.array = iter_array;
+        value.valid = true;
+        dbus_message_iter_next(iter);
+        return true;
+    }
+};
+
+inline bool dbus_read_iter(DBusMessageIter*)
+{
+    return true;
+}
+
+template<typename T, typename... Ts>
+bool dbus_read_iter(DBusMessageIter* iter, T& value, Ts&... values)
+{
+    return DBusMarshal<T>::read(iter, value) && dbus_read_iter(iter, values...);
+}
+
+// Reads the leading arguments of message. Like dbus_message_get_args(),
+// any further arguments are ignored.
+template<typename... Ts>
+bool dbus_read_args(DBusMessage* message, Ts&... values)
+{
+    DBusMessageIter iter;
+    dbus_message_iter_init(message, &iter);
+    return dbus_read_iter(&iter, values...);
+}
+
+inline void dbus_append_iter(DBusMessageIter*)
+{
+}
+
+template<typename T, typename... Ts>
+void dbus_append_iter(DBusMessageIter* iter, T const& value, Ts const&... values)
+{
+    DBusMarshal<T>::append(iter, value);
+    dbus_append_iter(iter, values...);
+}
+
+template<typename... Ts>
+void dbus_append_args(DBusMessage* message, Ts const&... values)
+{
+    DBusMessageIter iter;
+    dbus_message_iter_init_append(message, &iter);
+    dbus_append_iter(&iter, values...);
+}
+
+template<typename T>
+void dbus_append_variant(DBusMessageIter* iter, T const& value)
+{
+    DBusMessageIter iter_variant;
+    dbus_message_iter_open_container(
+        iter, DBUS_TYPE_VARIANT, DBusMarshal<T>::signature().c_str(), &iter_variant);
+    DBusMarshal<T>::append(&iter_variant, value);
+    dbus_message_iter_close_container(iter, &iter_variant);
+}
+
+// Appends a {sv} entry to a property dictionary
+template<typename T>
+void dbus_append_property(DBusMessageIter* iter_dict, char const* name, T const& value)
+{
+    DBusMessageIter iter_entry;
+    dbus_message_iter_open_container(iter_dict, DBUS_TYPE_DICT_ENTRY, nullptr, &iter_entry);
+    dbus_message_iter_append_basic(&iter_entry, DBUS_TYPE_STRING, &name);
+    dbus_append_variant(&iter_entry, value);
+    dbus_message_iter_close_container(iter_dict, &iter_entry);
+}
+
+// A PropertiesChanged signal carrying the properties that
+// append_properties(DBusMessageIter* iter_dict) appends with
+// dbus_append_property()
+template<typename AppendProperties>
+DBusMessageHandle dbus_properties_changed_signal(
+    char const* path, char const* interface, AppendProperties const& append_properties)
+{
+    DBusMessageHandle signal{
+        dbus_message_new_signal(
+            path,
+            "org.freedesktop.DBus.Properties",
+            "PropertiesChanged")};
+
+    DBusMessageIter iter;
+    dbus_message_iter_init_append(signal, &iter);
+
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &interface);
+
+    {
+        DBusMessageIter iter_dict;
+        dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &iter_dict);
+        append_properties(&iter_dict);
+        dbus_message_iter_close_container(&iter, &iter_dict);
+    }
+
+    DBusMarshal<std::vector<std::string>>::append(&iter, {});
+
+    return signal;
+}
+
+// A PropertiesChanged signal carrying the new value of one property
+template<typename T>
+DBusMessageHandle dbus_properties_changed_signal(
+    char const* path, char const* interface, char const* name, T const& value)
+{
+    return dbus_properties_changed_signal(
+        path, interface,
+        [name, &value] (DBusMessageIter* iter_dict) { dbus_append_property(iter_dict, name, value); });
+}
+
+template<typename... Ts>
+void dbus_send_return(DBusConnection* connection, DBusMessage* method_call, Ts const&... values)
+{
+    DBusMessageHandle reply{dbus_message_new_method_return(method_call)};
+    dbus_append_args(reply, values...);
+    dbus_connection_send(connection, reply, nullptr);
+}
+
+inline void dbus_send_error(
+    DBusConnection* connection, DBusMessage* method_call, char const* name, char const* message)
+{
+    DBusMessageHandle reply{dbus_message_new_error(method_call, name, message)};
+    dbus_connection_send(connection, reply, nullptr);
+}
+
+inline void dbus_send_error(DBusConnection* connection, DBusMessage* method_call, char const* message)
+{
+    dbus_send_error(connection, method_call, DBUS_ERROR_FAILED, message);
+}
+
+}
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbus_message_template.h"
+
+#include <cstdarg>
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+
+usc::DBusMessageTemplate::DBusMessageTemplate()
+    : message{nullptr}
+{
+}
+
+usc::DBusMessageTemplate::DBusMessageTemplate(DBusMessage* message)
+    : message{message}
+{
+    if (!message)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Invalid dbus message"));
+
+    dbus_message_ref(message);
+}
+
+usc::DBusMessageTemplate::DBusMessageTemplate(DBusMessageTemplate const& other)
+    : message{other.message}
+{
+    if (message)
+        dbus_message_ref(message);
+}
+
+usc::DBusMessageTemplate& usc::DBusMessageTemplate::operator=(DBusMessageTemplate const& other)
+{
+    if (other.message)
+        dbus_message_ref(other.message);
+    if (message)
+        dbus_message_unref(message);
+
+    message = other.message;
+    return *this;
+}
+
+usc::DBusMessageTemplate::~DBusMessageTemplate()
+{
+    if (message)
+        dbus_message_unref(message);
+}
+
+usc::DBusMessageHandle usc::DBusMessageTemplate::new_method_return()
+{
+    DBusMessageHandle reply{dbus_message_new(DBUS_MESSAGE_TYPE_METHOD_RETURN)};
+    if (!reply)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Invalid dbus message"));
+
+    // As dbus_message_new_method_return() does
+    dbus_message_set_no_reply(reply, TRUE);
+
+    return reply;
+}
+
+usc::DBusMessageTemplate usc::DBusMessageTemplate::method_return(int first_arg_type, ...)
+{
+    auto const reply = new_method_return();
+
+    va_list args;
+    va_start(args, first_arg_type);
+    auto const appended = dbus_message_append_args_valist(reply, first_arg_type, args);
+    va_end(args);
+
+    if (!appended)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::runtime_error("dbus_message_append_args_valist: Failed to append args"));
+    }
+
+    return DBusMessageTemplate{reply};
+}
+
+usc::DBusMessageTemplate::operator bool() const
+{
+    return message != nullptr;
+}
+
+usc::DBusMessageHandle usc::DBusMessageTemplate::instantiate() const
+{
+    if (!message)
+        BOOST_THROW_EXCEPTION(std::logic_error("DBusMessageTemplate: empty template"));
+
+    // The copy is unlocked and has no serial, so the connection gives it
+    // the next one when it's sent
+    DBusMessageHandle copy{dbus_message_copy(message)};
+    if (!copy)
+        BOOST_THROW_EXCEPTION(std::runtime_error("dbus_message_copy: Out of memory"));
+
+    return copy;
+}
+
+usc::DBusMessageHandle usc::DBusMessageTemplate::instantiate_reply(DBusMessage* method_call) const
+{
+    auto reply = instantiate();
+
+    auto const sender = dbus_message_get_sender(method_call);
+    if (!dbus_message_set_reply_serial(reply, dbus_message_get_serial(method_call)) ||
+        (sender && !dbus_message_set_destination(reply, sender)))
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("DBusMessageTemplate: Out of memory"));
+    }
+
+    return reply;
+}
+
+void usc::DBusMessageTemplate::send(DBusConnection* connection) const
+{
+    dbus_connection_send(connection, instantiate(), nullptr);
+}
+
+void usc::DBusMessageTemplate::send_reply(DBusConnection* connection, DBusMessage* method_call) const
+{
+    dbus_connection_send(connection, instantiate_reply(method_call), nullptr);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_DBUS_MESSAGE_TEMPLATE_H_
+#define USC_DBUS_MESSAGE_TEMPLATE_H_
+
+#include "dbus_message_handle.h"
+
+#include <dbus/dbus.h>
+
+namespace usc
+{
+
+// A signal or method return that is marshalled once and then sent many
+// times. Each send copies the marshalled message, which is a memcpy,
+// and only sets what differs per message: the serial, and for replies the
+// reply serial and destination. Copies of a template share the message.
+class DBusMessageTemplate
+{
+public:
+    // An empty template, which can't be instantiated
+    DBusMessageTemplate();
+    // Takes a reference to message, which must not be changed afterwards
+    explicit DBusMessageTemplate(DBusMessage* message);
+    DBusMessageTemplate(DBusMessageTemplate const& other);
+    DBusMessageTemplate& operator=(DBusMessageTemplate const& other);
+    ~DBusMessageTemplate();
+
+    // A method return with no reply serial yet, to append the reply
+    // arguments to before making a template of it
+    static DBusMessageHandle new_method_return();
+    // A template of a method return with arguments as for
+    // dbus_message_append_args()
+    static DBusMessageTemplate method_return(int first_arg_type, ...);
+
+    explicit operator bool() const;
+
+    DBusMessageHandle instantiate() const;
+    DBusMessageHandle instantiate_reply(DBusMessage* method_call) const;
+
+    void send(DBusConnection* connection) const;
+    void send_reply(DBusConnection* connection, DBusMessage* method_call) const;
+
+private:
+    DBusMessage* message;
+};
+
+}
+
+#endif
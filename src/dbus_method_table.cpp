@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbus_method_table.h"
+#include "dbus_connection_handle.h"
+#include "dbus_message_handle.h"
+
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+
+namespace
+{
+
+// FNV-1a, continued from hash
+uint64_t hash_string(char const* str, uint64_t hash = 14695981039346656037ull)
+{
+    for (; *str; ++str)
+    {
+        hash ^= static_cast<unsigned char>(*str);
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+}
+
+uint64_t usc::DBusMethodTable::hash_method(char const* interface, char const* member)
+{
+    // Hash the terminating nul of the interface too, so that moving
+    // characters between the two names changes the hash
+    auto const interface_hash = hash_string(interface) * 1099511628211ull;
+    return hash_string(member, interface_hash);
+}
+
+void usc::DBusMethodTable::add(
+    char const* interface, char const* member, Handler const& handler)
+{
+    auto const hash = hash_method(interface, member);
+
+    // The table is fixed at startup, so a collision between two of our own
+    // methods shows up straight away rather than as a misrouted call
+    if (by_interface_and_member.count(hash))
+    {
+        BOOST_THROW_EXCEPTION(
+            std::logic_error(
+                std::string{"DBusMethodTable: duplicate method "} + interface + "." + member));
+    }
+
+    by_interface_and_member[hash] = entries.size();
+    by_member.emplace(hash_string(member), entries.size());
+    entries.push_back({interface, member, handler});
+}
+
+void usc::DBusMethodTable::wrap(
+    char const* interface, char const* member, Wrapper const& wrap)
+{
+    auto const iter = by_interface_and_member.find(hash_method(interface, member));
+    if (iter == by_interface_and_member.end())
+    {
+        BOOST_THROW_EXCEPTION(
+            std::logic_error(
+                std::string{"DBusMethodTable: no method "} + interface + "." + member));
+    }
+
+    auto& entry = entries[iter->second];
+    entry.handler = wrap(entry.handler);
+}
+
+void usc::DBusMethodTable::for_each_method(
+    std::function<void(char const* interface, char const* member)> const& f) const
+{
+    for (auto const& entry : entries)
+        f(entry.interface.c_str(), entry.member.c_str());
+}
+
+bool usc::DBusMethodTable::dispatch(DBusMessage* method_call) const
+{
+    auto const interface = dbus_message_get_interface(method_call);
+    auto const member = dbus_message_get_member(method_call);
+    if (!member)
+        return false;
+
+    Entry const* entry{nullptr};
+
+    if (interface)
+    {
+        auto const iter = by_interface_and_member.find(hash_method(interface, member));
+        if (iter != by_interface_and_member.end())
+            entry = &entries[iter->second];
+    }
+    else
+    {
+        auto const iter = by_member.find(hash_string(member));
+        if (iter != by_member.end())
+            entry = &entries[iter->second];
+    }
+
+    // Names we don't know about may still share a hash with one we do
+    if (!entry || entry->member != member || (interface && entry->interface != interface))
+        return false;
+
+    entry->handler(method_call);
+    return true;
+}
+
+void usc::DBusMethodTable::register_object_path(
+    DBusConnectionHandle const& connection, char const* path)
+{
+    DBusObjectPathVTable vtable{};
+    vtable.message_function = handle_dbus_message_thunk;
+
+    connection.register_object_path(path, vtable, this);
+}
+
+::DBusHandlerResult usc::DBusMethodTable::handle_dbus_message_thunk(
+    ::DBusConnection* connection, DBusMessage* message, void* user_data)
+{
+    if (dbus_message_get_type(message) != DBUS_MESSAGE_TYPE_METHOD_CALL)
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+    auto const table = static_cast<usc::DBusMethodTable*>(user_data);
+
+    if (!table->dispatch(message))
+    {
+        DBusMessageHandle reply{
+            dbus_message_new_error(message, DBUS_ERROR_FAILED, "Not supported")};
+
+        dbus_connection_send(connection, reply, nullptr);
+    }
+
+    return DBUS_HANDLER_RESULT_HANDLED;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_DBUS_METHOD_TABLE_H_
+#define USC_DBUS_METHOD_TABLE_H_
+
+#include <dbus/dbus.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace usc
+{
+class DBusConnectionHandle;
+
+// The methods of a D-Bus object, looked up by a hash of their interface
+// and member names. Built once when the service starts, so dispatching a
+// call costs one hash and one confirming comparison however many methods
+// there are.
+class DBusMethodTable
+{
+public:
+    using Handler = std::function<void(DBusMessage* method_call)>;
+    using Wrapper = std::function<Handler(Handler const& handler)>;
+
+    DBusMethodTable() = default;
+
+    void add(char const* interface, char const* member, Handler const& handler);
+
+    // Replaces the handler of a method added earlier with wrap(handler),
+    // for behaviour that applies to a method whatever its handler does
+    void wrap(char const* interface, char const* member, Wrapper const& wrap);
+
+    void for_each_method(
+        std::function<void(char const* interface, char const* member)> const& f) const;
+
+    // Calls the handler for the method. Calls without an interface go to
+    // the first method added with a matching member. Returns false if
+    // there is no such method.
+    bool dispatch(DBusMessage* method_call) const;
+
+    // Serves the methods at path. Only method calls for path reach the
+    // table; calls to methods it doesn't have get a "Not supported" error.
+    // The table must outlive the connection's use of it.
+    void register_object_path(DBusConnectionHandle const& connection, char const* path);
+
+    // The hash methods are looked up by
+    static uint64_t hash_method(char const* interface, char const* member);
+
+private:
+    DBusMethodTable(DBusMethodTable const&) = delete;
+    DBusMethodTable& operator=(DBusMethodTable const&) = delete;
+
+    struct Entry
+    {
+        std::string interface;
+        std::string member;
+        Handler handler;
+    };
+
+    static ::DBusHandlerResult handle_dbus_message_thunk(
+        DBusConnection* connection, DBusMessage* message, void* user_data);
+
+    std::vector<Entry> entries;
+    std::unordered_map<uint64_t, size_t> by_interface_and_member;
+    std::unordered_map<uint64_t, size_t> by_member;
+};
+
+}
+
+#endif
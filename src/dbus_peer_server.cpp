@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbus_peer_server.h"
+#include "dbus_connection_handle.h"
+#include "dbus_event_loop.h"
+#include "dbus_message_handle.h"
+#include "scoped_dbus_error.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+
+namespace
+{
+
+// Peers are powerd and unity8 asking for display power changes, so they
+// go before the bus connections of the other services
+int const peer_dispatch_priority = 4;
+
+}
+
+usc::DBusPeerServer::DBusPeerServer(
+    std::shared_ptr<DBusEventLoop> const& loop,
+    std::string const& listen_address,
+    std::vector<uid_t> const& allowed_uids)
+    : loop{loop},
+      allowed_uids{allowed_uids}
+{
+    dbus_threads_init_default();
+    ScopedDBusError error;
+
+    server = dbus_server_listen(listen_address.c_str(), &error);
+    if (!server)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::runtime_error("dbus_server_listen: " + error.message_str()));
+    }
+
+    // Peers have to prove which uid they run as
+    char const* mechanisms[] = {"EXTERNAL", nullptr};
+    dbus_server_set_auth_mechanisms(server, mechanisms);
+    dbus_server_set_new_connection_function(
+        server, DBusPeerServer::static_handle_new_connection, this, nullptr);
+
+    loop->add_server(server);
+}
+
+usc::DBusPeerServer::~DBusPeerServer()
+{
+    loop->remove_server(server);
+    dbus_server_disconnect(server);
+    dbus_server_unref(server);
+
+    for (auto const& peer : peers_)
+        loop->remove_connection(peer.connection);
+}
+
+std::string usc::DBusPeerServer::address() const
+{
+    auto const address = dbus_server_get_address(server);
+    std::string const result{address};
+    dbus_free(address);
+    return result;
+}
+
+void usc::DBusPeerServer::serve(
+    std::shared_ptr<DBusEventLoop> const& service_loop, ServePeer const& serve_peer)
+{
+    // The service's handlers would otherwise run on two threads
+    if (service_loop != loop)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::logic_error("DBusPeerServer: Services must be on the loop serving the peers"));
+    }
+
+    serve_peers.push_back(serve_peer);
+}
+
+void usc::DBusPeerServer::send_to_peers(DBusMessage* message)
+{
+    std::lock_guard<std::mutex> lock{peers_mutex};
+
+    // Each connection numbers its own messages, and a message keeps the
+    // serial it was first sent with, so each peer gets a fresh copy
+    for (auto const& peer : peers_)
+    {
+        DBusMessageHandle const copy{dbus_message_copy(message)};
+        if (copy)
+            dbus_connection_send(*peer.connection, copy, nullptr);
+    }
+}
+
+size_t usc::DBusPeerServer::peers() const
+{
+    std::lock_guard<std::mutex> lock{peers_mutex};
+    return peers_.size();
+}
+
+void usc::DBusPeerServer::handle_new_connection(DBusConnection* connection)
+{
+    // Authentication finishes after this, and checks the uid then
+    dbus_connection_set_unix_user_function(
+        connection, DBusPeerServer::static_is_allowed, this, nullptr);
+
+    // The loop is handling the server's fd, so add the peer once it's done
+    auto const peer = std::make_shared<DBusConnectionHandle>(connection);
+    loop->enqueue([this, peer] { add_peer(peer); });
+}
+
+void usc::DBusPeerServer::add_peer(std::shared_ptr<DBusConnectionHandle> const& connection)
+{
+    connection->add_filter(DBusPeerServer::static_handle_peer_message, this);
+
+    Peer peer{connection, {}};
+    for (auto const& serve_peer : serve_peers)
+        peer.objects.push_back(serve_peer(connection));
+
+    {
+        std::lock_guard<std::mutex> lock{peers_mutex};
+        peers_.push_back(std::move(peer));
+    }
+
+    loop->add_connection(connection, peer_dispatch_priority);
+}
+
+void usc::DBusPeerServer::remove_peer(DBusConnection* connection)
+{
+    Peer removed;
+
+    {
+        std::lock_guard<std::mutex> lock{peers_mutex};
+
+        auto const iter = std::find_if(
+            peers_.begin(), peers_.end(),
+            [connection] (Peer const& peer) { return *peer.connection == connection; });
+        if (iter == peers_.end())
+            return;
+
+        removed = std::move(*iter);
+        peers_.erase(iter);
+    }
+
+    // The connection is closed, and the objects served on it released, as
+    // removed goes out of scope
+    loop->remove_connection(removed.connection);
+}
+
+bool usc::DBusPeerServer::is_allowed(uid_t uid) const
+{
+    return uid == getuid() ||
+        std::find(allowed_uids.begin(), allowed_uids.end(), uid) != allowed_uids.end();
+}
+
+void usc::DBusPeerServer::static_handle_new_connection(
+    DBusServer*, DBusConnection* connection, void* data)
+{
+    static_cast<DBusPeerServer*>(data)->handle_new_connection(connection);
+}
+
+dbus_bool_t usc::DBusPeerServer::static_is_allowed(
+    DBusConnection*, unsigned long uid, void* data)
+{
+    return static_cast<DBusPeerServer*>(data)->is_allowed(uid);
+}
+
+DBusHandlerResult usc::DBusPeerServer::static_handle_peer_message(
+    DBusConnection* connection, DBusMessage* message, void* data)
+{
+    if (dbus_message_is_signal(message, DBUS_INTERFACE_LOCAL, "Disconnected"))
+    {
+        // Called while the loop dispatches the connection, so remove it
+        // once that's done
+        auto const server = static_cast<DBusPeerServer*>(data);
+        server->loop->enqueue([server, connection] { server->remove_peer(connection); });
+        return DBUS_HANDLER_RESULT_HANDLED;
+    }
+
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
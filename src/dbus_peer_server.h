@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_DBUS_PEER_SERVER_H_
+#define USC_DBUS_PEER_SERVER_H_
+
+#include <dbus/dbus.h>
+
+#include <sys/types.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace usc
+{
+class DBusConnectionHandle;
+class DBusEventLoop;
+
+// A private D-Bus server that trusted clients, such as powerd and unity8,
+// connect to directly instead of through the bus daemon, which halves the
+// hops of each call and signal. Only processes running as one of the
+// allowed uids, or as USC's own, can connect.
+//
+// The peers are served on loop, which must be the loop of the services
+// they are served by, and the server must be destroyed after the loop has
+// stopped.
+class DBusPeerServer
+{
+public:
+    DBusPeerServer(
+        std::shared_ptr<DBusEventLoop> const& loop,
+        std::string const& listen_address,
+        std::vector<uid_t> const& allowed_uids);
+    ~DBusPeerServer();
+
+    // The address peers connect to
+    std::string address() const;
+
+    // Called on the loop thread as each peer connects, to register objects
+    // on it. Returns what must be kept alive while the peer is connected.
+    using ServePeer =
+        std::function<std::shared_ptr<void>(std::shared_ptr<DBusConnectionHandle> const& peer)>;
+
+    // Must be called before the loop starts, by a service on the same loop
+    void serve(std::shared_ptr<DBusEventLoop> const& service_loop, ServePeer const& serve_peer);
+
+    // Sends a copy of message to every connected peer, so message may
+    // already have been sent elsewhere. Can be called from any thread.
+    void send_to_peers(DBusMessage* message);
+
+    size_t peers() const;
+
+private:
+    DBusPeerServer(DBusPeerServer const&) = delete;
+    DBusPeerServer& operator=(DBusPeerServer const&) = delete;
+
+    struct Peer
+    {
+        std::shared_ptr<DBusConnectionHandle> connection;
+        std::vector<std::shared_ptr<void>> objects;
+    };
+
+    void handle_new_connection(DBusConnection* connection);
+    void add_peer(std::shared_ptr<DBusConnectionHandle> const& connection);
+    void remove_peer(DBusConnection* connection);
+    bool is_allowed(uid_t uid) const;
+
+    static void static_handle_new_connection(
+        DBusServer* server, DBusConnection* connection, void* data);
+    static dbus_bool_t static_is_allowed(DBusConnection* connection, unsigned long uid, void* data);
+    static DBusHandlerResult static_handle_peer_message(
+        DBusConnection* connection, DBusMessage* message, void* data);
+
+    std::shared_ptr<DBusEventLoop> const loop;
+    std::vector<uid_t> const allowed_uids;
+    ::DBusServer* server;
+    std::vector<ServePeer> serve_peers;
+
+    mutable std::mutex peers_mutex;
+    std::vector<Peer> peers_;
+};
+
+}
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "dbus_rate_limiter.h"
+#include "dbus_connection_handle.h"
+#include "dbus_marshalling.h"
+#include "dbus_message_handle.h"
+
+#include <algorithm>
+
+namespace
+{
+
+size_t const min_senders_before_sweep = 64;
+
+}
+
+usc::DBusSenderBuckets::DBusSenderBuckets(double calls_per_second, int burst)
+    : calls_per_second{calls_per_second},
+      burst{static_cast<double>(std::max(burst, 1))},
+      sweep_at{min_senders_before_sweep}
+{
+}
+
+usc::DBusSenderBuckets::Duration usc::DBusSenderBuckets::take_call(
+    std::string const& sender, TimePoint now)
+{
+    auto iter = buckets.find(sender);
+    if (iter == buckets.end())
+    {
+        if (buckets.size() >= sweep_at)
+            forget_idle_senders(now);
+
+        iter = buckets.emplace(sender, Bucket{burst, now}).first;
+    }
+
+    auto& bucket = iter->second;
+    refill(bucket, now);
+
+    if (bucket.tokens >= 1.0)
+    {
+        bucket.tokens -= 1.0;
+        return Duration::zero();
+    }
+
+    // Round up, so that there is a whole token by then
+    std::chrono::duration<double> const until_refilled{(1.0 - bucket.tokens) / calls_per_second};
+    return std::chrono::duration_cast<Duration>(until_refilled) + Duration{1};
+}
+
+size_t usc::DBusSenderBuckets::senders() const
+{
+    return buckets.size();
+}
+
+void usc::DBusSenderBuckets::refill(Bucket& bucket, TimePoint now) const
+{
+    if (now <= bucket.updated)
+        return;
+
+    std::chrono::duration<double> const elapsed{now - bucket.updated};
+    bucket.tokens = std::min(burst, bucket.tokens + elapsed.count() * calls_per_second);
+    bucket.updated = now;
+}
+
+void usc::DBusSenderBuckets::forget_idle_senders(TimePoint now)
+{
+    // A full bucket is the same as no bucket
+    for (auto iter = buckets.begin(); iter != buckets.end();)
+    {
+        refill(iter->second, now);
+
+        if (iter->second.tokens >= burst)
+            iter = buckets.erase(iter);
+        else
+            ++iter;
+    }
+
+    sweep_at = std::max(min_senders_before_sweep, 2 * buckets.size());
+}
+
+usc::DBusRateLimiter::Limits const usc::DBusRateLimiter::default_limits{20.0, 20};
+
+usc::DBusRateLimiter::DBusRateLimiter(
+    std::shared_ptr<DBusEventLoop> const& loop,
+    std::shared_ptr<DBusConnectionHandle> const& connection,
+    Limits const& limits)
+    : loop{loop},
+      connection{connection},
+      limited{limits.calls_per_second > 0.0},
+      buckets{limits.calls_per_second, limits.burst}
+{
+}
+
+usc::DBusRateLimiter::~DBusRateLimiter()
+{
+    for (auto const& method : methods)
+    {
+        if (method->held_call)
+        {
+            method->held_call_run.cancel();
+            dbus_message_unref(method->held_call);
+        }
+    }
+}
+
+void usc::DBusRateLimiter::limit(
+    DBusMethodTable& table, char const* interface, char const* member, Excess excess)
+{
+    if (!limited)
+        return;
+
+    methods.push_back(
+        std::unique_ptr<Method>(
+            new Method{std::string{interface} + "." + member, excess, {}, nullptr, {}, {}}));
+    auto const method = methods.back().get();
+
+    table.wrap(interface, member,
+        [this, method] (DBusMethodTable::Handler const& handler)
+        {
+            method->handler = handler;
+            return [this, method] (DBusMessage* method_call) { handle(*method, method_call); };
+        });
+}
+
+void usc::DBusRateLimiter::handle(Method& method, DBusMessage* method_call)
+{
+    // Peer-to-peer connections have only the one client
+    auto const sender = dbus_message_get_sender(method_call);
+    auto const delay = sender ?
+        buckets.take_call(sender, loop->now()) :
+        DBusSenderBuckets::Duration::zero();
+
+    if (delay == DBusSenderBuckets::Duration::zero())
+    {
+        // A held call is older than this one
+        drop_held_call(method);
+        method.handler(method_call);
+        return;
+    }
+
+    if (method.excess == Excess::reject)
+    {
+        dbus_send_error(
+            *connection, method_call, DBUS_ERROR_LIMITS_EXCEEDED,
+            ("Too many calls to " + method.name + ", try again later").c_str());
+        return;
+    }
+
+    hold(method, method_call, sender, delay);
+}
+
+void usc::DBusRateLimiter::hold(
+    Method& method,
+    DBusMessage* method_call,
+    char const* sender,
+    DBusSenderBuckets::Duration delay)
+{
+    drop_held_call(method);
+
+    method.held_call = dbus_message_ref(method_call);
+    method.held_sender = sender;
+    method.held_call_run = loop->enqueue_after(delay, [this, &method] { run_held_call(method); });
+}
+
+void usc::DBusRateLimiter::run_held_call(Method& method)
+{
+    // The sender's other limited methods may have used the allowance first
+    auto const delay = buckets.take_call(method.held_sender, loop->now());
+    if (delay != DBusSenderBuckets::Duration::zero())
+    {
+        method.held_call_run = loop->enqueue_after(delay, [this, &method] { run_held_call(method); });
+        return;
+    }
+
+    DBusMessageHandle const method_call{method.held_call};
+    method.held_call = nullptr;
+    method.handler(method_call);
+}
+
+void usc::DBusRateLimiter::drop_held_call(Method& method)
+{
+    if (!method.held_call)
+        return;
+
+    // As far as its sender is concerned the call succeeded, and was then
+    // overridden by the newer one
+    method.held_call_run.cancel();
+    dbus_send_return(*connection, method.held_call);
+    dbus_message_unref(method.held_call);
+    method.held_call = nullptr;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USC_DBUS_RATE_LIMITER_H_
+#define USC_DBUS_RATE_LIMITER_H_
+
+#include "dbus_event_loop.h"
+#include "dbus_method_table.h"
+
+#include <dbus/dbus.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace usc
+{
+class DBusConnectionHandle;
+
+// A token bucket per sender. Each sender may make up to burst calls at
+// once, and calls_per_second on average after that.
+class DBusSenderBuckets
+{
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+    using Duration = std::chrono::steady_clock::duration;
+
+    DBusSenderBuckets(double calls_per_second, int burst);
+
+    // Takes a call by sender at now out of its allowance and returns zero,
+    // or, if it has none left, returns how long until it has
+    Duration take_call(std::string const& sender, TimePoint now);
+
+    // The number of senders that have used some of their allowance
+    size_t senders() const;
+
+private:
+    struct Bucket
+    {
+        double tokens;
+        TimePoint updated;
+    };
+
+    void refill(Bucket& bucket, TimePoint now) const;
+    void forget_idle_senders(TimePoint now);
+
+    double const calls_per_second;
+    double const burst;
+    std::unordered_map<std::string, Bucket> buckets;
+    // Senders come and go, so the buckets are swept once there are this
+    // many of them
+    size_t sweep_at;
+};
+
+// Limits how often each client can call some of the methods of a service,
+// keyed on the unique name of the sender, so that one misbehaving client
+// can't keep the service busy for the others. Only used on the loop
+// thread once the service is serving.
+class DBusRateLimiter
+{
+public:
+    struct Limits
+    {
+        // Zero or less for no limit
+        double calls_per_second;
+        int burst;
+    };
+
+    static Limits const default_limits;
+
+    // What happens to calls beyond a sender's limit
+    enum class Excess
+    {
+        // They get a LimitsExceeded error straight away
+        reject,
+        // They are held until the sender may call again. A newer call to
+        // the same method, from any sender, replaces a held call, which
+        // gets an empty reply without running. For setters, where only the
+        // latest value matters.
+        coalesce
+    };
+
+    DBusRateLimiter(
+        std::shared_ptr<DBusEventLoop> const& loop,
+        std::shared_ptr<DBusConnectionHandle> const& connection,
+        Limits const& limits);
+    ~DBusRateLimiter();
+
+    // Limits calls to a method already added to table. Calls to all the
+    // limited methods of a service come out of the same allowance.
+    void limit(DBusMethodTable& table, char const* interface, char const* member, Excess excess);
+
+private:
+    DBusRateLimiter(DBusRateLimiter const&) = delete;
+    DBusRateLimiter& operator=(DBusRateLimiter const&) = delete;
+
+    struct Method
+    {
+        std::string name;
+        Excess excess;
+        DBusMethodTable::Handler handler;
+        // The call waiting for its sender's allowance, if any
+        DBusMessage* held_call;
+        std::string held_sender;
+        DBusEventLoop::DelayedAction held_call_run;
+    };
+
+    void handle(Method& method, DBusMessage* method_call);
+    void hold(
+        Method& method,
+        DBusMessage* method_call,
+        char const* sender,
+        DBusSenderBuckets::Duration delay);
+    void run_held_call(Method& method);
+    void drop_held_call(Method& method);
+
+    std::shared_ptr<DBusEventLoop> const loop;
+    std::shared_ptr<DBusConnectionHandle> const connection;
+    bool const limited;
+    DBusSenderBuckets buckets;
+    std::vector<std::unique_ptr<Method>> methods;
+};
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbus_worker_pool.h"
+#include "thread_name.h"
+
+#include <algorithm>
+#include <string>
+
+usc::DBusWorkerPool::DBusWorkerPool(int num_threads)
+    : stopping{false}
+{
+    for (int i = 0; i < std::max(num_threads, 1); ++i)
+    {
+        threads.emplace_back(
+            [this,i]
+            {
+                usc::set_thread_name("USC/DBusWork-" + std::to_string(i));
+                run_worker();
+            });
+    }
+}
+
+usc::DBusWorkerPool::~DBusWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+
+    work_available.notify_all();
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void usc::DBusWorkerPool::enqueue(Task work)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        queued_work.push_back(std::move(work));
+    }
+
+    work_available.notify_one();
+}
+
+void usc::DBusWorkerPool::run_worker()
+{
+    std::unique_lock<std::mutex> lock{mutex};
+
+    while (true)
+    {
+        work_available.wait(lock, [this] { return stopping || !queued_work.empty(); });
+        if (stopping)
+            break;
+
+        auto work = std::move(queued_work.front());
+        queued_work.pop_front();
+
+        lock.unlock();
+        work();
+        // Destroy whatever the work captured before taking the lock again
+        work.reset();
+        lock.lock();
+    }
+}
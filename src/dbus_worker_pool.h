@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_DBUS_WORKER_POOL_H_
+#define USC_DBUS_WORKER_POOL_H_
+
+#include "dbus_event_loop.h"
+#include "task.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace usc
+{
+
+// Threads for the slow parts of D-Bus method handlers, so that they don't
+// hold up the D-Bus loops. The threads are named USC/DBusWork-N.
+//
+// Work still queued when the pool is destroyed is dropped without running.
+class DBusWorkerPool
+{
+public:
+    explicit DBusWorkerPool(int num_threads);
+    ~DBusWorkerPool();
+
+    void enqueue(Task work);
+
+    // Runs work on a worker thread, then calls then on the thread of loop,
+    // with the result of work as its argument unless work returns void.
+    // Together with DBusDeferredReply this lets a handler return straight
+    // away and reply once the work is done:
+    //
+    //   DBusDeferredReply reply{loop, connection, message};
+    //   workers.run_then(loop, [] { return slow(); },
+    //       [reply] (int result) { reply.send_return(DBUS_TYPE_INT32, &result, DBUS_TYPE_INVALID); });
+    template<typename Work, typename Then>
+    void run_then(std::shared_ptr<DBusEventLoop> const& loop, Work work, Then then);
+
+private:
+    DBusWorkerPool(DBusWorkerPool const&) = delete;
+    DBusWorkerPool& operator=(DBusWorkerPool const&) = delete;
+
+    void run_worker();
+
+    template<typename Result>
+    struct Continuation;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::deque<Task> queued_work;
+    bool stopping;
+    std::vector<std::thread> threads;
+};
+
+template<typename Result>
+struct DBusWorkerPool::Continuation
+{
+    template<typename Work, typename Then>
+    static void run(DBusEventLoop& loop, Work& work, Then& then)
+    {
+        loop.enqueue(
+            [then = std::move(then), result = work()] () mutable
+            {
+                then(std::move(result));
+            });
+    }
+};
+
+template<>
+struct DBusWorkerPool::Continuation<void>
+{
+    template<typename Work, typename Then>
+    static void run(DBusEventLoop& loop, Work& work, Then& then)
+    {
+        work();
+        loop.enqueue([then = std::move(then)] () mutable { then(); });
+    }
+};
+
+template<typename Work, typename Then>
+void DBusWorkerPool::run_then(std::shared_ptr<DBusEventLoop> const& loop, Work work, Then then)
+{
+    enqueue(
+        [loop, work = std::move(work), then = std::move(then)] () mutable
+        {
+            Continuation<decltype(work())>::run(*loop, work, then);
+        });
+}
+
+}
+
+#endif
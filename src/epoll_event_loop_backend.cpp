@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "epoll_event_loop_backend.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+#include <boost/throw_exception.hpp>
+
+namespace
+{
+// Counter fds are tagged in the upper half of their epoll data, so that
+// wait() can tell them apart without looking them up
+uint64_t const counter_tag = uint64_t{1} << 32;
+
+epoll_data_t data_for(int fd, uint64_t tag)
+{
+    epoll_data_t data;
+    data.u64 = tag | static_cast<uint32_t>(fd);
+    return data;
+}
+}
+
+usc::EpollEventLoopBackend::EpollEventLoopBackend()
+    : epoll_fd{epoll_create1(EPOLL_CLOEXEC)}
+{
+    if (epoll_fd == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "epoll_create1"));
+    }
+}
+
+void usc::EpollEventLoopBackend::add_counter_fd(int fd)
+{
+    // Counters are drained completely whenever they are reported, so level
+    // and edge triggered notifications behave the same
+    if (!add(fd, EPOLLIN, counter_tag))
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "epoll_ctl"));
+    }
+}
+
+bool usc::EpollEventLoopBackend::add(int fd, uint32_t events)
+{
+    return add(fd, events, 0);
+}
+
+bool usc::EpollEventLoopBackend::add(int fd, uint32_t events, uint64_t tag)
+{
+    epoll_event ev{};
+    ev.events = events;
+    ev.data = data_for(fd, tag);
+
+    ++syscall_count;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+void usc::EpollEventLoopBackend::modify(int fd, uint32_t events)
+{
+    epoll_event ev{};
+    ev.events = events;
+    ev.data = data_for(fd, 0);
+
+    ++syscall_count;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void usc::EpollEventLoopBackend::remove(int fd)
+{
+    ++syscall_count;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int usc::EpollEventLoopBackend::wait(epoll_event* events, int max_events, int timeout_ms)
+{
+    ++syscall_count;
+    int const n = epoll_wait(epoll_fd, events, max_events, timeout_ms);
+
+    for (int i = 0; i < n; ++i)
+    {
+        auto const tag = events[i].data.u64 & ~uint64_t{0xffffffff};
+        int const fd = static_cast<int>(static_cast<uint32_t>(events[i].data.u64));
+
+        // The loop only knows fds
+        events[i].data = data_for(fd, 0);
+
+        if (tag == counter_tag)
+        {
+            // Only the loop reads its counters, so one reported readable
+            // can't be empty unless the report was spurious
+            uint64_t count;
+            ++syscall_count;
+            if (read(fd, &count, sizeof count) != sizeof count && errno != EAGAIN)
+            {
+                BOOST_THROW_EXCEPTION(
+                    std::system_error(errno, std::system_category(), "read"));
+            }
+        }
+    }
+
+    return n;
+}
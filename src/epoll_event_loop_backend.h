@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_EPOLL_EVENT_LOOP_BACKEND_H_
+#define USC_EPOLL_EVENT_LOOP_BACKEND_H_
+
+#include "dbus_event_loop_backend.h"
+
+#include <mir/fd.h>
+
+#include <cstdint>
+
+namespace usc
+{
+
+class EpollEventLoopBackend : public DBusEventLoopBackend
+{
+public:
+    EpollEventLoopBackend();
+
+    void add_counter_fd(int fd) override;
+    bool add(int fd, uint32_t events) override;
+    void modify(int fd, uint32_t events) override;
+    void remove(int fd) override;
+    int wait(epoll_event* events, int max_events, int timeout_ms) override;
+
+private:
+    bool add(int fd, uint32_t events, uint64_t tag);
+
+    mir::Fd const epoll_fd;
+};
+
+}
+
+#endif
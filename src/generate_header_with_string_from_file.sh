@@ -22,5 +22,5 @@ header_guard=$(echo "USC_$(basename $header)_" | tr '[a-z].' '[A-Z]_')
 
 echo "#ifndef $header_guard
 #define $header_guard
-const char* const $varname = R\"($(cat $filename))\";
+const char* const $varname = R\"xml($(cat $filename))xml\";
 #endif" > $header
@@ -17,10 +17,28 @@
 #ifndef USC_INPUT_CONFIGURATION_H_
 #define USC_INPUT_CONFIGURATION_H_
 
+#include <boost/optional.hpp>
+
 #include <cstdint>
 
 namespace usc
 {
+// Settings to change together. Settings that are not set keep their
+// current values.
+struct InputSettings
+{
+    boost::optional<int32_t> mouse_primary_button;
+    boost::optional<double> mouse_cursor_speed;
+    boost::optional<double> mouse_scroll_speed;
+    boost::optional<int32_t> touchpad_primary_button;
+    boost::optional<double> touchpad_cursor_speed;
+    boost::optional<double> touchpad_scroll_speed;
+    boost::optional<bool> two_finger_scroll;
+    boost::optional<bool> tap_to_click;
+    boost::optional<bool> disable_touchpad_while_typing;
+    boost::optional<bool> disable_touchpad_with_mouse;
+};
+
 class InputConfiguration
 {
 public:
@@ -37,6 +55,13 @@ public:
     virtual void set_disable_touchpad_while_typing(bool enable) = 0;
     virtual void set_disable_touchpad_with_mouse(bool enable) = 0;
 
+    // Changes all the settings at once, reconfiguring each device at most
+    // once. Settings that already have the given value don't count as
+    // changes.
+    virtual void apply_settings(InputSettings const& settings) = 0;
+    // The current value of every setting
+    virtual InputSettings current_settings() = 0;
+
 protected:
     InputConfiguration() = default;
     InputConfiguration(InputConfiguration const&) = delete;
@@ -0,0 +1,481 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "io_uring_event_loop_backend.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <unistd.h>
+#include <endian.h>
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+#include <boost/throw_exception.hpp>
+
+namespace
+{
+
+// Enough for the few fds of a loop; when more changes are queued the
+// submission queue is flushed early
+unsigned const ring_entries = 64;
+
+// Request user data packs what the request is for, the generation of the
+// fd's interest set it was submitted for, and the fd
+enum RequestKind : uint64_t
+{
+    cancel_request = 0,
+    poll_request = 1,
+    counter_poll_request = 2,
+    counter_read_request = 3
+};
+
+uint64_t user_data_for(RequestKind kind, uint32_t generation, int fd)
+{
+    return (static_cast<uint64_t>(kind) << 62) |
+           (static_cast<uint64_t>(generation & 0x3fffffff) << 32) |
+           static_cast<uint32_t>(fd);
+}
+
+RequestKind kind_of(uint64_t user_data)
+{
+    return static_cast<RequestKind>(user_data >> 62);
+}
+
+uint32_t generation_of(uint64_t user_data)
+{
+    return (user_data >> 32) & 0x3fffffff;
+}
+
+int fd_of(uint64_t user_data)
+{
+    return static_cast<int>(static_cast<uint32_t>(user_data));
+}
+
+uint32_t poll_mask_for(uint32_t epoll_events)
+{
+    uint32_t const mask = epoll_events & ~(EPOLLET | EPOLLONESHOT | EPOLLEXCLUSIVE | EPOLLWAKEUP);
+
+    // The kernel reads poll32_events as two little endian halfwords
+#if __BYTE_ORDER == __BIG_ENDIAN
+    return (mask << 16) | (mask >> 16);
+#else
+    return mask;
+#endif
+}
+
+template<typename T>
+T* at_offset(void* base, uint32_t offset)
+{
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+}
+
+usc::IoUringEventLoopBackend::IoUringEventLoopBackend(std::function<void()> const& wake_up)
+    : wake_up{wake_up}
+{
+    io_uring_params params{};
+    ring_fd = mir::Fd{static_cast<int>(syscall(__NR_io_uring_setup, ring_entries, &params))};
+    if (ring_fd == -1)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "io_uring_setup"));
+    }
+
+    uint32_t const required_features =
+        IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & required_features) != required_features)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(EOPNOTSUPP, std::system_category(), "io_uring features"));
+    }
+
+    ring_size = std::max(
+        params.sq_off.array + params.sq_entries * sizeof(unsigned),
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ring = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(errno, std::system_category(), "mmap io_uring"));
+    }
+
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    auto const sqes_map = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes_map == MAP_FAILED)
+    {
+        auto const error = errno;
+        munmap(ring, ring_size);
+        BOOST_THROW_EXCEPTION(
+            std::system_error(error, std::system_category(), "mmap io_uring"));
+    }
+    sqes = static_cast<io_uring_sqe*>(sqes_map);
+
+    sq_head = at_offset<unsigned>(ring, params.sq_off.head);
+    sq_tail = at_offset<unsigned>(ring, params.sq_off.tail);
+    sq_mask = *at_offset<unsigned>(ring, params.sq_off.ring_mask);
+    sq_entries = params.sq_entries;
+    sq_array = at_offset<unsigned>(ring, params.sq_off.array);
+    cq_head = at_offset<unsigned>(ring, params.cq_off.head);
+    cq_tail = at_offset<unsigned>(ring, params.cq_off.tail);
+    cq_mask = *at_offset<unsigned>(ring, params.cq_off.ring_mask);
+    cqes = at_offset<io_uring_cqe>(ring, params.cq_off.cqes);
+}
+
+usc::IoUringEventLoopBackend::~IoUringEventLoopBackend()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        cancel_all_requests();
+    }
+
+    munmap(sqes, sqes_size);
+    munmap(ring, ring_size);
+}
+
+void usc::IoUringEventLoopBackend::add_counter_fd(int fd)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& state = state_for(fd);
+    state.registered = true;
+    state.counter = true;
+    state.events = EPOLLIN;
+    state.counter_value.reset(new uint64_t{0});
+    ++state.generation;
+    mark_dirty(fd, state);
+    request_changes_applied();
+}
+
+bool usc::IoUringEventLoopBackend::add(int fd, uint32_t events)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& state = state_for(fd);
+    state.registered = true;
+    state.counter = false;
+    state.events = events;
+    ++state.generation;
+    mark_dirty(fd, state);
+    request_changes_applied();
+
+    return true;
+}
+
+void usc::IoUringEventLoopBackend::modify(int fd, uint32_t events)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& state = state_for(fd);
+
+    // Unlike EPOLL_CTL_MOD, re-setting the same events is free
+    if (!state.registered || state.events == events)
+        return;
+
+    state.events = events;
+    ++state.generation;
+    mark_dirty(fd, state);
+    request_changes_applied();
+}
+
+void usc::IoUringEventLoopBackend::remove(int fd)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto& state = state_for(fd);
+    if (!state.registered)
+        return;
+
+    state.registered = false;
+    ++state.generation;
+    mark_dirty(fd, state);
+    request_changes_applied();
+}
+
+int usc::IoUringEventLoopBackend::wait(epoll_event* events, int max_events, int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock{mutex};
+
+    submit_changes();
+
+    // Completions left over from the last wait are returned without a
+    // syscall. Any queued submissions go in with the next one.
+    auto n = reap_completions(events, max_events);
+    if (n > 0)
+        return n;
+
+    waiting = true;
+    lock.unlock();
+
+    auto const result = enter(timeout_ms == 0 ? 0 : 1, timeout_ms);
+    auto const error = errno;
+
+    lock.lock();
+    waiting = false;
+
+    n = reap_completions(events, max_events);
+    if (n == 0 && result == -1 && error == EINTR)
+    {
+        errno = EINTR;
+        return -1;
+    }
+
+    return n;
+}
+
+void usc::IoUringEventLoopBackend::stop_waiting()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    // Completions are delivered through the thread that submitted the
+    // requests. Once it has exited they are only picked up by a kernel
+    // fallback worker a few milliseconds later, so cancel now while that's
+    // still quick.
+    cancel_all_requests();
+}
+
+void usc::IoUringEventLoopBackend::cancel_all_requests()
+{
+    for (size_t fd = 0; fd < fd_states.size(); ++fd)
+    {
+        auto& state = fd_states[fd];
+        if (!state.armed)
+            continue;
+
+        auto const sqe = next_sqe(1);
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = state.armed;
+        sqe->user_data = user_data_for(cancel_request, 0, 0);
+
+        // Re-armed if there is another wait()
+        state.armed = 0;
+        mark_dirty(fd, state);
+    }
+
+    // Counter reads write into memory we own, so wait for every request to
+    // finish before it can go away
+    while (requests_in_flight > 0)
+    {
+        if (enter(1, -1) == -1 && errno != EINTR)
+            break;
+
+        unsigned const head = *cq_head;
+        unsigned const tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        requests_in_flight -= tail - head;
+        __atomic_store_n(cq_head, tail, __ATOMIC_RELEASE);
+    }
+}
+
+usc::IoUringEventLoopBackend::FdState& usc::IoUringEventLoopBackend::state_for(int fd)
+{
+    if (static_cast<size_t>(fd) >= fd_states.size())
+        fd_states.resize(fd + 1);
+
+    return fd_states[fd];
+}
+
+void usc::IoUringEventLoopBackend::mark_dirty(int fd, FdState& state)
+{
+    if (!state.dirty)
+    {
+        state.dirty = true;
+        dirty_fds.push_back(fd);
+    }
+}
+
+void usc::IoUringEventLoopBackend::request_changes_applied()
+{
+    // The loop thread submits changes itself on its next wait(), so only
+    // changes made from other threads while it's blocked need a wake up
+    if (waiting && wake_up)
+        wake_up();
+}
+
+void usc::IoUringEventLoopBackend::submit_changes()
+{
+    for (auto const fd : dirty_fds)
+    {
+        auto& state = fd_states[fd];
+        state.dirty = false;
+
+        if (state.armed && (!state.registered || generation_of(state.armed) != state.generation))
+        {
+            auto const sqe = next_sqe(1);
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = state.armed;
+            sqe->user_data = user_data_for(cancel_request, 0, 0);
+            state.armed = 0;
+        }
+
+        if (state.armed || !state.registered)
+            continue;
+
+        if (state.counter)
+        {
+            // Read the counter as soon as it becomes readable. The fd is
+            // non-blocking, so a read without the poll would just fail.
+            auto const poll_sqe = next_sqe(2);
+            poll_sqe->opcode = IORING_OP_POLL_ADD;
+            poll_sqe->fd = fd;
+            poll_sqe->poll32_events = poll_mask_for(EPOLLIN);
+            poll_sqe->flags = IOSQE_IO_LINK;
+            poll_sqe->user_data = user_data_for(counter_poll_request, state.generation, fd);
+
+            auto const read_sqe = next_sqe(1);
+            read_sqe->opcode = IORING_OP_READ;
+            read_sqe->fd = fd;
+            read_sqe->addr = reinterpret_cast<uint64_t>(state.counter_value.get());
+            read_sqe->len = sizeof(uint64_t);
+            read_sqe->user_data = user_data_for(counter_read_request, state.generation, fd);
+
+            state.armed = poll_sqe->user_data;
+        }
+        else
+        {
+            auto const sqe = next_sqe(1);
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = fd;
+            sqe->poll32_events = poll_mask_for(state.events);
+            sqe->user_data = user_data_for(poll_request, state.generation, fd);
+
+            state.armed = sqe->user_data;
+        }
+    }
+
+    dirty_fds.clear();
+}
+
+io_uring_sqe* usc::IoUringEventLoopBackend::next_sqe(unsigned needed)
+{
+    // Flush the queue early if it can't take the request (and any requests
+    // linked to it) in one go
+    unsigned const tail = *sq_tail;
+    while (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) + needed > sq_entries)
+    {
+        if (enter(0, 0) == -1 && errno != EINTR)
+        {
+            BOOST_THROW_EXCEPTION(
+                std::system_error(errno, std::system_category(), "io_uring_enter"));
+        }
+    }
+
+    auto const index = tail & sq_mask;
+    auto const sqe = &sqes[index];
+    memset(sqe, 0, sizeof *sqe);
+    sq_array[index] = index;
+
+    // The kernel only looks at the queue during io_uring_enter(), which is
+    // always called after the request is filled in
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++requests_in_flight;
+
+    return sqe;
+}
+
+int usc::IoUringEventLoopBackend::enter(unsigned min_complete, int timeout_ms)
+{
+    unsigned const to_submit = *sq_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    if (to_submit == 0 && min_complete == 0)
+        return 0;
+
+    unsigned flags{0};
+    io_uring_getevents_arg arg{};
+    __kernel_timespec timeout{};
+
+    if (min_complete > 0)
+    {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        if (timeout_ms >= 0)
+        {
+            timeout.tv_sec = timeout_ms / 1000;
+            timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+            arg.ts = reinterpret_cast<uint64_t>(&timeout);
+        }
+    }
+
+    ++syscall_count;
+    return syscall(
+        __NR_io_uring_enter, static_cast<int>(ring_fd), to_submit, min_complete, flags,
+        (flags & IORING_ENTER_EXT_ARG) ? &arg : nullptr,
+        (flags & IORING_ENTER_EXT_ARG) ? sizeof arg : 0);
+}
+
+int usc::IoUringEventLoopBackend::reap_completions(epoll_event* events, int max_events)
+{
+    unsigned head = *cq_head;
+    unsigned const tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    int n{0};
+
+    while (head != tail && n < max_events)
+    {
+        if (handle_completion(cqes[head & cq_mask], events[n]))
+            ++n;
+        ++head;
+        --requests_in_flight;
+    }
+
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+    return n;
+}
+
+bool usc::IoUringEventLoopBackend::handle_completion(io_uring_cqe const& cqe, epoll_event& event)
+{
+    auto const kind = kind_of(cqe.user_data);
+    auto const fd = fd_of(cqe.user_data);
+
+    if (kind == cancel_request || kind == counter_poll_request ||
+        static_cast<size_t>(fd) >= fd_states.size())
+    {
+        return false;
+    }
+
+    auto& state = fd_states[fd];
+    auto const generation = generation_of(cqe.user_data);
+
+    // Ignore requests that have been cancelled or replaced
+    if (state.armed != user_data_for(
+            kind == counter_read_request ? counter_poll_request : kind, generation, fd))
+    {
+        return false;
+    }
+
+    // One-shot, so re-arm on the next wait()
+    state.armed = 0;
+    mark_dirty(fd, state);
+
+    if (!state.registered || cqe.res == -ECANCELED)
+        return false;
+
+    event.data.fd = fd;
+
+    if (kind == counter_read_request)
+    {
+        // -EAGAIN means something else emptied the counter first
+        event.events = EPOLLIN;
+        return cqe.res == sizeof(uint64_t);
+    }
+
+    event.events = cqe.res < 0 ? EPOLLERR : static_cast<uint32_t>(cqe.res);
+    return true;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_IO_URING_EVENT_LOOP_BACKEND_H_
+#define USC_IO_URING_EVENT_LOOP_BACKEND_H_
+
+#include "dbus_event_loop_backend.h"
+
+#include <mir/fd.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace usc
+{
+
+// Waits for fds with io_uring poll requests, talking to the kernel through
+// the raw syscalls. Interest changes are queued and submitted together with
+// the next wait in a single io_uring_enter(), and counters are read by
+// linked read requests, so a wake up costs one syscall instead of an
+// epoll_wait(), a read() and an epoll_ctl() per changed watch.
+//
+// Polls are one-shot and re-armed on the next wait() after they are
+// reported, which gives level-triggered notifications even for fds added
+// with EPOLLET. DBusEventLoop's edge-triggered mode copes with that, since
+// it only relies on being told again about fds that still have events.
+class IoUringEventLoopBackend : public DBusEventLoopBackend
+{
+public:
+    // Throws std::system_error if the kernel doesn't provide io_uring or
+    // the features we need (Linux 5.11 or later). wake_up is called when
+    // add(), modify() or remove() are called while another thread is in
+    // wait(), to make it return and submit the change.
+    explicit IoUringEventLoopBackend(std::function<void()> const& wake_up);
+    ~IoUringEventLoopBackend();
+
+    void add_counter_fd(int fd) override;
+    bool add(int fd, uint32_t events) override;
+    void modify(int fd, uint32_t events) override;
+    void remove(int fd) override;
+    int wait(epoll_event* events, int max_events, int timeout_ms) override;
+    void stop_waiting() override;
+
+private:
+    struct FdState
+    {
+        uint32_t events{0};
+        bool registered{false};
+        bool counter{false};
+        bool dirty{false};
+        // Bumped whenever the wanted events change, so that completions of
+        // requests submitted for an older interest set are ignored
+        uint32_t generation{0};
+        // The user data of the request in flight for this fd, or 0
+        uint64_t armed{0};
+        // Where counter reads store the value. Heap allocated so it stays
+        // put while fd_states grows.
+        std::unique_ptr<uint64_t> counter_value;
+    };
+
+    FdState& state_for(int fd);
+    void mark_dirty(int fd, FdState& state);
+    void request_changes_applied();
+    void submit_changes();
+    void cancel_all_requests();
+    io_uring_sqe* next_sqe(unsigned needed);
+    int enter(unsigned min_complete, int timeout_ms);
+    int reap_completions(epoll_event* events, int max_events);
+    bool handle_completion(io_uring_cqe const& cqe, epoll_event& event);
+
+    std::function<void()> const wake_up;
+    mir::Fd ring_fd;
+    void* ring{nullptr};
+    size_t ring_size{0};
+    io_uring_sqe* sqes{nullptr};
+    size_t sqes_size{0};
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    io_uring_cqe* cqes;
+
+    std::mutex mutex;
+    std::vector<FdState> fd_states;
+    std::vector<int> dirty_fds;
+    bool waiting{false};
+    size_t requests_in_flight{0};
+};
+
+}
+
+#endif
@@ -49,6 +49,35 @@ struct DeviceObserver : mi::InputDeviceObserver
     {
     }
 };
+
+// Maps a speed in [0, 1] to an acceleration bias in [-1, 1]
+double acceleration_bias_for(double speed)
+{
+    double clamped = speed;
+    if (clamped < 0.0)
+        clamped = 0.0;
+    if (clamped > 1.0)
+        clamped = 1.0;
+    return clamped * 2.0 - 1.0;
+}
+
+double speed_for(double acceleration_bias)
+{
+    return (acceleration_bias + 1.0) / 2.0;
+}
+
+// Button 0 is the primary button of a right handed pointer
+MirPointerHandedness handedness_for(int32_t primary_button)
+{
+    return primary_button == 0 ?
+        mir_pointer_handedness_right :
+        mir_pointer_handedness_left;
+}
+
+int32_t primary_button_for(MirPointerHandedness handedness)
+{
+    return handedness == mir_pointer_handedness_right ? 0 : 1;
+}
 }
 
 
@@ -106,82 +135,205 @@ void usc::MirInputConfiguration::update_mice()
 
 void usc::MirInputConfiguration::set_mouse_primary_button(int32_t button)
 {
-    mouse_pointer_config.handedness(button == 0 ?
-        mir_pointer_handedness_right :
-        mir_pointer_handedness_left);
-    update_mice();
+    InputSettings settings;
+    settings.mouse_primary_button = button;
+    apply_settings(settings);
 }
 
 void usc::MirInputConfiguration::set_mouse_cursor_speed(double speed)
 {
-    double clamped = speed;
-    if (clamped < 0.0)
-        clamped = 0.0;
-    if (clamped > 1.0)
-        clamped = 1.0;
-    mouse_pointer_config.cursor_acceleration_bias(clamped * 2.0 - 1.0);
-    update_mice();
+    InputSettings settings;
+    settings.mouse_cursor_speed = speed;
+    apply_settings(settings);
 }
 
 void usc::MirInputConfiguration::set_mouse_scroll_speed(double speed)
 {
-    mouse_pointer_config.horizontal_scroll_scale(speed);
-    mouse_pointer_config.vertical_scroll_scale(speed);
-    update_mice();
+    InputSettings settings;
+    settings.mouse_scroll_speed = speed;
+    apply_settings(settings);
 }
 
 void usc::MirInputConfiguration::set_touchpad_primary_button(int32_t button)
 {
-    touchpad_pointer_config.handedness(button == 0 ?
-        mir_pointer_handedness_right :
-        mir_pointer_handedness_left);
-    update_touchpads();
+    InputSettings settings;
+    settings.touchpad_primary_button = button;
+    apply_settings(settings);
 }
 
 void usc::MirInputConfiguration::set_touchpad_cursor_speed(double speed)
 {
-    double clamped = speed;
-    if (clamped < 0.0)
-        clamped = 0.0;
-    if (clamped > 1.0)
-        clamped = 1.0;
-    touchpad_pointer_config.cursor_acceleration_bias(clamped * 2.0 - 1.0);
-    update_touchpads();
+    InputSettings settings;
+    settings.touchpad_cursor_speed = speed;
+    apply_settings(settings);
 }
 
 void usc::MirInputConfiguration::set_touchpad_scroll_speed(double speed)
 {
-    touchpad_pointer_config.horizontal_scroll_scale(speed);
-    touchpad_pointer_config.vertical_scroll_scale(speed);
-    update_touchpads();
+    InputSettings settings;
+    settings.touchpad_scroll_speed = speed;
+    apply_settings(settings);
 }
 
 void usc::MirInputConfiguration::set_two_finger_scroll(bool enable)
 {
-    MirTouchpadScrollModes current = touchpad_config.scroll_mode();
-    if (enable)
-        current |= mir_touchpad_scroll_mode_two_finger_scroll;
-    else
-        current &= ~mir_touchpad_scroll_mode_two_finger_scroll;
-    touchpad_config.scroll_mode(current);
-    update_touchpads();
+    InputSettings settings;
+    settings.two_finger_scroll = enable;
+    apply_settings(settings);
 }
 
 void usc::MirInputConfiguration::set_tap_to_click(bool enable)
 {
-    touchpad_config.tap_to_click(enable);
-    update_touchpads();
+    InputSettings settings;
+    settings.tap_to_click = enable;
+    apply_settings(settings);
 }
 
 void usc::MirInputConfiguration::set_disable_touchpad_while_typing(bool enable)
 {
-    touchpad_config.disable_while_typing(enable);
-    update_touchpads();
+    InputSettings settings;
+    settings.disable_touchpad_while_typing = enable;
+    apply_settings(settings);
 }
 
 void usc::MirInputConfiguration::set_disable_touchpad_with_mouse(bool enable)
 {
-    touchpad_config.disable_with_mouse(enable);
-    update_touchpads();
+    InputSettings settings;
+    settings.disable_touchpad_with_mouse = enable;
+    apply_settings(settings);
+}
+
+void usc::MirInputConfiguration::apply_settings(InputSettings const& settings)
+{
+    std::lock_guard<decltype(devices_lock)> lock(devices_lock);
+
+    // Only reconfigure devices whose configuration actually changes, so
+    // that clients re-sending their settings cost nothing
+    bool mice_changed{false};
+    bool touchpads_changed{false};
+
+    if (settings.mouse_primary_button)
+    {
+        auto const handedness = handedness_for(*settings.mouse_primary_button);
+        if (handedness != mouse_pointer_config.handedness())
+        {
+            mouse_pointer_config.handedness(handedness);
+            mice_changed = true;
+        }
+    }
+
+    if (settings.mouse_cursor_speed)
+    {
+        auto const bias = acceleration_bias_for(*settings.mouse_cursor_speed);
+        if (bias != mouse_pointer_config.cursor_acceleration_bias())
+        {
+            mouse_pointer_config.cursor_acceleration_bias(bias);
+            mice_changed = true;
+        }
+    }
+
+    if (settings.mouse_scroll_speed)
+    {
+        auto const scale = *settings.mouse_scroll_speed;
+        if (scale != mouse_pointer_config.horizontal_scroll_scale() ||
+            scale != mouse_pointer_config.vertical_scroll_scale())
+        {
+            mouse_pointer_config.horizontal_scroll_scale(scale);
+            mouse_pointer_config.vertical_scroll_scale(scale);
+            mice_changed = true;
+        }
+    }
+
+    if (settings.touchpad_primary_button)
+    {
+        auto const handedness = handedness_for(*settings.touchpad_primary_button);
+        if (handedness != touchpad_pointer_config.handedness())
+        {
+            touchpad_pointer_config.handedness(handedness);
+            touchpads_changed = true;
+        }
+    }
+
+    if (settings.touchpad_cursor_speed)
+    {
+        auto const bias = acceleration_bias_for(*settings.touchpad_cursor_speed);
+        if (bias != touchpad_pointer_config.cursor_acceleration_bias())
+        {
+            touchpad_pointer_config.cursor_acceleration_bias(bias);
+            touchpads_changed = true;
+        }
+    }
+
+    if (settings.touchpad_scroll_speed)
+    {
+        auto const scale = *settings.touchpad_scroll_speed;
+        if (scale != touchpad_pointer_config.horizontal_scroll_scale() ||
+            scale != touchpad_pointer_config.vertical_scroll_scale())
+        {
+            touchpad_pointer_config.horizontal_scroll_scale(scale);
+            touchpad_pointer_config.vertical_scroll_scale(scale);
+            touchpads_changed = true;
+        }
+    }
+
+    if (settings.two_finger_scroll)
+    {
+        MirTouchpadScrollModes current = touchpad_config.scroll_mode();
+        if (*settings.two_finger_scroll)
+            current |= mir_touchpad_scroll_mode_two_finger_scroll;
+        else
+            current &= ~mir_touchpad_scroll_mode_two_finger_scroll;
+
+        if (current != touchpad_config.scroll_mode())
+        {
+            touchpad_config.scroll_mode(current);
+            touchpads_changed = true;
+        }
+    }
+
+    if (settings.tap_to_click &&
+        *settings.tap_to_click != touchpad_config.tap_to_click())
+    {
+        touchpad_config.tap_to_click(*settings.tap_to_click);
+        touchpads_changed = true;
+    }
+
+    if (settings.disable_touchpad_while_typing &&
+        *settings.disable_touchpad_while_typing != touchpad_config.disable_while_typing())
+    {
+        touchpad_config.disable_while_typing(*settings.disable_touchpad_while_typing);
+        touchpads_changed = true;
+    }
+
+    if (settings.disable_touchpad_with_mouse &&
+        *settings.disable_touchpad_with_mouse != touchpad_config.disable_with_mouse())
+    {
+        touchpad_config.disable_with_mouse(*settings.disable_touchpad_with_mouse);
+        touchpads_changed = true;
+    }
+
+    if (mice_changed)
+        update_mice();
+    if (touchpads_changed)
+        update_touchpads();
 }
 
+usc::InputSettings usc::MirInputConfiguration::current_settings()
+{
+    std::lock_guard<decltype(devices_lock)> lock(devices_lock);
+
+    InputSettings settings;
+    settings.mouse_primary_button = primary_button_for(mouse_pointer_config.handedness());
+    settings.mouse_cursor_speed = speed_for(mouse_pointer_config.cursor_acceleration_bias());
+    settings.mouse_scroll_speed = mouse_pointer_config.vertical_scroll_scale();
+    settings.touchpad_primary_button = primary_button_for(touchpad_pointer_config.handedness());
+    settings.touchpad_cursor_speed = speed_for(touchpad_pointer_config.cursor_acceleration_bias());
+    settings.touchpad_scroll_speed = touchpad_pointer_config.vertical_scroll_scale();
+    settings.two_finger_scroll =
+        (touchpad_config.scroll_mode() & mir_touchpad_scroll_mode_two_finger_scroll) != 0;
+    settings.tap_to_click = touchpad_config.tap_to_click();
+    settings.disable_touchpad_while_typing = touchpad_config.disable_while_typing();
+    settings.disable_touchpad_with_mouse = touchpad_config.disable_with_mouse();
+
+    return settings;
+}
@@ -54,12 +54,15 @@ public:
     void set_tap_to_click(bool enable) override;
     void set_disable_touchpad_while_typing(bool enable) override;
     void set_disable_touchpad_with_mouse(bool enable) override;
+    void apply_settings(InputSettings const& settings) override;
+    InputSettings current_settings() override;
 
     void device_added(std::shared_ptr<mir::input::Device> const& device);
     void device_removed(std::shared_ptr<mir::input::Device> const& device);
 private:
     void configure_mouse(mir::input::Device& dev);
     void configure_touchpad(mir::input::Device& dev);
+    // Called with devices_lock held
     void update_touchpads();
     void update_mice();
 
@@ -25,6 +25,7 @@
 #include <mir/log.h>
 #include <mir/report_exception.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <sstream>
 
@@ -86,6 +87,39 @@ usc::ActiveOutputs count_active_outputs(
     return active_outputs;
 }
 
+std::vector<usc::OutputState> connected_output_states(
+    mir::graphics::DisplayConfiguration const& display_configuration)
+{
+    std::vector<usc::OutputState> output_states;
+
+    display_configuration.for_each_output(
+        [&output_states](mir::graphics::DisplayConfigurationOutput const& output)
+        {
+            if (!output.connected)
+                return;
+
+            usc::OutputState state;
+            state.id = output.id.as_value();
+            state.external = is_external(output.type);
+            state.power_mode = output.power_mode;
+
+            if (output.current_mode_index < output.modes.size())
+            {
+                auto const& mode = output.modes[output.current_mode_index];
+                state.width = mode.size.width.as_int();
+                state.height = mode.size.height.as_int();
+                state.refresh_rate = mode.vrefresh_hz;
+            }
+
+            output_states.push_back(state);
+        });
+
+    std::sort(output_states.begin(), output_states.end(),
+        [](usc::OutputState const& a, usc::OutputState const& b) { return a.id < b.id; });
+
+    return output_states;
+}
+
 bool has_active_outputs(
     mir::graphics::DisplayConfiguration const& display_configuration)
 {
@@ -149,7 +183,9 @@ usc::MirScreen::MirScreen(
         // We can be constructed after the initial_configuration() event.
         // Count active outputs based on current configuration so that we have
         // the correct info from the begining.
-        active_outputs = count_active_outputs(*display->configuration());
+        auto const display_configuration = display->configuration();
+        active_outputs = count_active_outputs(*display_configuration);
+        output_states = connected_output_states(*display_configuration);
     }
     catch(...)
     {
@@ -173,6 +209,28 @@ void usc::MirScreen::turn_off(OutputFilter output_filter)
     set_power_mode(MirPowerMode::mir_power_mode_off, filter_func);
 }
 
+void usc::MirScreen::turn_on_outputs(std::vector<int32_t> const& output_ids)
+{
+    set_power_mode(
+        MirPowerMode::mir_power_mode_on,
+        [&output_ids](mg::UserDisplayConfigurationOutput const& output)
+        {
+            return output.power_mode != MirPowerMode::mir_power_mode_on &&
+                   std::find(output_ids.begin(), output_ids.end(), output.id.as_value()) != output_ids.end();
+        });
+}
+
+void usc::MirScreen::turn_off_outputs(std::vector<int32_t> const& output_ids)
+{
+    set_power_mode(
+        MirPowerMode::mir_power_mode_off,
+        [&output_ids](mg::UserDisplayConfigurationOutput const& output)
+        {
+            return output.power_mode != MirPowerMode::mir_power_mode_off &&
+                   std::find(output_ids.begin(), output_ids.end(), output.id.as_value()) != output_ids.end();
+        });
+}
+
 void usc::MirScreen::register_active_outputs_handler(
     void * ownerKey, ActiveOutputsHandler const& handler)
 {
@@ -193,22 +251,45 @@ void usc::MirScreen::unregister_active_outputs_handler(
     active_outputs_handlers.erase(ownerKey);
 }
 
+void usc::MirScreen::register_output_states_handler(
+    void * ownerKey, OutputStatesHandler const& handler)
+{
+    // Under lock for the same reason as the active outputs handlers
+    std::lock_guard<std::mutex> lock{active_outputs_mutex};
+    output_states_handlers[ownerKey] = handler;
+    handler(output_states);
+}
+
+void usc::MirScreen::unregister_output_states_handler(
+    void * ownerKey)
+{
+    std::lock_guard<std::mutex> lock{active_outputs_mutex};
+    output_states_handlers.erase(ownerKey);
+}
+
 void usc::MirScreen::initial_configuration(
     std::shared_ptr<mir::graphics::DisplayConfiguration const> const& display_configuration)
 {
-    std::lock_guard<std::mutex> lock{active_outputs_mutex};
-    active_outputs = count_active_outputs(*display_configuration);
-    for (auto const& pair: active_outputs_handlers)
-        pair.second(active_outputs);
+    update_outputs(*display_configuration);
 }
 
 void usc::MirScreen::configuration_applied(
     std::shared_ptr<mir::graphics::DisplayConfiguration const> const& display_configuration)
+{
+    update_outputs(*display_configuration);
+}
+
+void usc::MirScreen::update_outputs(
+    mir::graphics::DisplayConfiguration const& display_configuration)
 {
     std::lock_guard<std::mutex> lock{active_outputs_mutex};
-    active_outputs = count_active_outputs(*display_configuration);
+    active_outputs = count_active_outputs(display_configuration);
     for (auto const& pair: active_outputs_handlers)
         pair.second(active_outputs);
+
+    output_states = connected_output_states(display_configuration);
+    for (auto const& pair: output_states_handlers)
+        pair.second(output_states);
 }
 
 void usc::MirScreen::base_configuration_updated(
@@ -259,6 +340,7 @@ void usc::MirScreen::set_power_mode(MirPowerMode mode, SetPowerModeFilter const&
 try
 {
     std::shared_ptr<mg::DisplayConfiguration> displayConfig = display->configuration();
+    bool any_output_changed{false};
 
     displayConfig->for_each_output(
         [&](const mg::UserDisplayConfigurationOutput displayConfigOutput) {
@@ -267,10 +349,16 @@ try
                 filter(displayConfigOutput))
             {
                 displayConfigOutput.power_mode = mode;
+                any_output_changed = true;
             }
         }
     );
 
+    // Reconfiguring stops the compositor for every output, so don't do it
+    // for nothing
+    if (!any_output_changed)
+        return;
+
     compositor->stop();
 
     display->configure(*displayConfig.get());
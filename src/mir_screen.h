@@ -24,6 +24,7 @@
 #include "screen.h"
 
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <map>
@@ -47,8 +48,12 @@ public:
     // From Screen
     void turn_on(OutputFilter output_filter) override;
     void turn_off(OutputFilter output_filter) override;
+    void turn_on_outputs(std::vector<int32_t> const& output_ids) override;
+    void turn_off_outputs(std::vector<int32_t> const& output_ids) override;
     void register_active_outputs_handler(void * ownerKey, ActiveOutputsHandler const& handler) override;
     void unregister_active_outputs_handler(void * ownerKey) override;
+    void register_output_states_handler(void * ownerKey, OutputStatesHandler const& handler) override;
+    void unregister_output_states_handler(void * ownerKey) override;
 
     // From DisplayConfigurationObserver
     void initial_configuration(
@@ -85,8 +90,9 @@ public:
 #endif
 
 private:
-    using SetPowerModeFilter = bool(*)(mir::graphics::UserDisplayConfigurationOutput const&);
+    using SetPowerModeFilter = std::function<bool(mir::graphics::UserDisplayConfigurationOutput const&)>;
     void set_power_mode(MirPowerMode mode, SetPowerModeFilter const& filter);
+    void update_outputs(mir::graphics::DisplayConfiguration const& display_configuration);
 
     std::shared_ptr<mir::compositor::Compositor> const compositor;
     std::shared_ptr<mir::graphics::Display> const display;
@@ -94,6 +100,8 @@ private:
     std::mutex active_outputs_mutex;
     std::map<void *, ActiveOutputsHandler> active_outputs_handlers;
     ActiveOutputs active_outputs;
+    std::map<void *, OutputStatesHandler> output_states_handlers;
+    std::vector<OutputState> output_states;
 };
 
 }
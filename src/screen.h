@@ -20,7 +20,9 @@
 #define USC_SCREEN_H_
 
 #include <mir_toolkit/common.h>
+#include <cstdint>
 #include <functional>
+#include <vector>
 
 namespace usc
 {
@@ -42,6 +44,31 @@ struct ActiveOutputs
 
 using ActiveOutputsHandler = std::function<void(ActiveOutputs const&)>;
 
+// The state of one connected output
+struct OutputState
+{
+    bool operator==(OutputState const& other) const
+    {
+        return id == other.id &&
+               external == other.external &&
+               power_mode == other.power_mode &&
+               width == other.width &&
+               height == other.height &&
+               refresh_rate == other.refresh_rate;
+    }
+
+    int32_t id{0};
+    bool external{false};
+    MirPowerMode power_mode{mir_power_mode_off};
+    // Of the current mode, or zero if there is none
+    int32_t width{0};
+    int32_t height{0};
+    double refresh_rate{0.0};
+};
+
+// Called with all the connected outputs, in id order
+using OutputStatesHandler = std::function<void(std::vector<OutputState> const&)>;
+
 enum class OutputFilter { all, internal, external };
 
 class Screen
@@ -51,10 +78,18 @@ public:
 
     virtual void turn_on(OutputFilter filter) = 0;
     virtual void turn_off(OutputFilter filter) = 0;
+    // Only the listed outputs are changed; outputs already in the mode
+    // are left alone
+    virtual void turn_on_outputs(std::vector<int32_t> const& output_ids) = 0;
+    virtual void turn_off_outputs(std::vector<int32_t> const& output_ids) = 0;
     virtual void register_active_outputs_handler(
         void * ownerKey, ActiveOutputsHandler const& handler) = 0;
     virtual void unregister_active_outputs_handler(
         void * ownerKey) = 0;
+    virtual void register_output_states_handler(
+        void * ownerKey, OutputStatesHandler const& handler) = 0;
+    virtual void unregister_output_states_handler(
+        void * ownerKey) = 0;
 
 protected:
     Screen() = default;
@@ -29,11 +29,16 @@
 #include "mir_input_configuration.h"
 #include "screen_event_handler.h"
 #include "unity_display_service.h"
+#include "unity_debug_service.h"
 #include "unity_input_service.h"
 #include "unity_power_button_event_sink.h"
 #include "unity_user_activity_event_sink.h"
+#include "dbus_connection_handle.h"
 #include "dbus_connection_thread.h"
 #include "dbus_event_loop.h"
+#include "dbus_event_loop_pool.h"
+#include "dbus_peer_server.h"
+#include "dbus_rate_limiter.h"
 #include "display_configuration_policy.h"
 #include "steady_clock.h"
 
@@ -49,7 +54,9 @@
 
 #include <boost/exception/all.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 
 namespace msh = mir::shell;
 namespace ms = mir::scene;
@@ -150,6 +157,56 @@ const char* const dm_from_fd = "from-dm-fd";
 const char* const dm_to_fd = "to-dm-fd";
 const char* const dm_stub = "debug-without-dm";
 const char* const dm_stub_active = "debug-active-session-name";
+const char* const dbus_max_events_per_wakeup = "dbus-max-events-per-wakeup";
+const char* const dbus_edge_triggered = "dbus-edge-triggered";
+const char* const dbus_event_loops = "dbus-event-loops";
+const char* const dbus_instrumentation = "dbus-instrumentation";
+const char* const dbus_io_uring = "dbus-io-uring";
+const char* const dbus_shared_connection = "dbus-shared-connection";
+const char* const dbus_rate_limit = "dbus-rate-limit";
+const char* const dbus_rate_limit_burst = "dbus-rate-limit-burst";
+const char* const dbus_peer_address = "dbus-peer-address";
+const char* const dbus_peer_uids = "dbus-peer-uids";
+int const default_dbus_max_events_per_wakeup = 16;
+int const default_dbus_event_loops = 2;
+const char* const dbus_display_service = "com.canonical.Unity.Display";
+const char* const dbus_input_service = "com.canonical.Unity.Input";
+const char* const dbus_debug_service = "com.canonical.Unity.Debug";
+// The loop key for the shared connection
+const char* const dbus_shared_connection_services = "com.canonical.Unity";
+
+usc::DBusRateLimiter::Limits dbus_rate_limits(mir::options::Option const& options)
+{
+    return {
+        static_cast<double>(options.get(
+            dbus_rate_limit, static_cast<int>(usc::DBusRateLimiter::default_limits.calls_per_second))),
+        options.get(dbus_rate_limit_burst, usc::DBusRateLimiter::default_limits.burst)};
+}
+
+std::vector<uid_t> uids_from_string(std::string const& uids_str)
+{
+    std::vector<uid_t> uids;
+    std::istringstream stream{uids_str};
+    std::string uid;
+
+    while (std::getline(stream, uid, ','))
+    {
+        try
+        {
+            size_t end{0};
+            uids.push_back(std::stoul(uid, &end));
+            if (end != uid.size())
+                throw std::invalid_argument{uid};
+        }
+        catch (std::logic_error const&)
+        {
+            BOOST_THROW_EXCEPTION(
+                mir::AbnormalExit("Invalid uid in --" + std::string{dbus_peer_uids} + ": " + uid));
+        }
+    }
+
+    return uids;
+}
 }
 
 usc::Server::Server(int argc, char** argv)
@@ -165,6 +222,16 @@ usc::Server::Server(int argc, char** argv)
     add_configuration_option("spinner", "Path to spinner executable",  mir::OptionType::string);
     add_configuration_option("public-socket", "Make the socket file publicly writable",  mir::OptionType::boolean);
     add_configuration_option("enable-hardware-cursor", "Enable the hardware cursor (disabled by default)",  mir::OptionType::boolean);
+    add_configuration_option(dbus_max_events_per_wakeup, "Maximum number of events the D-Bus loop handles per wakeup [int]", default_dbus_max_events_per_wakeup);
+    add_configuration_option(dbus_edge_triggered, "Use edge-triggered notifications in the D-Bus loop",  mir::OptionType::boolean);
+    add_configuration_option(dbus_event_loops, "Number of D-Bus loop threads the D-Bus services are spread across [int]", default_dbus_event_loops);
+    add_configuration_option(dbus_io_uring, "Use io_uring instead of epoll in the D-Bus loops, if the kernel supports it",  mir::OptionType::boolean);
+    add_configuration_option(dbus_shared_connection, "Own all the D-Bus names on one bus connection, served by one D-Bus loop",  mir::OptionType::boolean);
+    add_configuration_option(dbus_rate_limit, "Calls per second each D-Bus client may make to the display power and input setting methods, or 0 for no limit [int]", static_cast<int>(DBusRateLimiter::default_limits.calls_per_second));
+    add_configuration_option(dbus_rate_limit_burst, "Calls each D-Bus client may make at once before the rate limit applies [int]", DBusRateLimiter::default_limits.burst);
+    add_configuration_option(dbus_peer_address, "Also serve the Display, Input, PowerButton and UserActivity interfaces directly to peers connecting to this D-Bus address, e.g. unix:path=/run/usc-dbus",  mir::OptionType::string);
+    add_configuration_option(dbus_peer_uids, "Comma separated uids, besides USC's own, allowed to connect to --dbus-peer-address",  mir::OptionType::string);
+    add_configuration_option(dbus_instrumentation, "Collect D-Bus loop latency statistics from startup (they can also be enabled at runtime over com.canonical.Unity.Debug)",  mir::OptionType::boolean);
     add_display_configuration_options_to(*this);
 
     set_command_line(argc, const_cast<char const **>(argv));
@@ -329,14 +396,33 @@ std::shared_ptr<usc::Clock> usc::Server::the_clock()
         });
 }
 
-std::shared_ptr<usc::DBusEventLoop> usc::Server::the_dbus_event_loop()
+std::shared_ptr<usc::DBusEventLoopPool> usc::Server::the_dbus_event_loop_pool()
 {
-    return dbus_loop(
+    return dbus_loop_pool(
         [this]
         {
-            return std::make_shared<DBusEventLoop>();
-        });
+            auto const trigger = the_options()->get(dbus_edge_triggered, false) ?
+                DBusEventLoop::Trigger::edge : DBusEventLoop::Trigger::level;
+            auto const backend = the_options()->get(dbus_io_uring, false) ?
+                DBusEventLoop::Backend::io_uring : DBusEventLoop::Backend::epoll;
+            auto const num_loops =
+                std::max(the_options()->get(dbus_event_loops, default_dbus_event_loops), 1);
+
+            std::vector<std::shared_ptr<DBusEventLoop>> loops;
+            for (int i = 0; i < num_loops; ++i)
+            {
+                loops.push_back(
+                    std::make_shared<DBusEventLoop>(
+                        the_options()->get(dbus_max_events_per_wakeup, default_dbus_max_events_per_wakeup),
+                        trigger,
+                        the_clock(),
+                        backend));
+                loops.back()->set_instrumentation_enabled(
+                    the_options()->get(dbus_instrumentation, false));
+            }
 
+            return std::make_shared<DBusEventLoopPool>(loops);
+        });
 }
 
 std::shared_ptr<usc::DBusConnectionThread> usc::Server::the_dbus_connection_thread()
@@ -344,19 +430,106 @@ std::shared_ptr<usc::DBusConnectionThread> usc::Server::the_dbus_connection_thre
     return dbus_thread(
         [this]
         {
-            return std::make_shared<DBusConnectionThread>(the_dbus_event_loop());
+            return std::make_shared<DBusConnectionThread>(the_dbus_event_loop_pool());
+        });
+}
+
+std::shared_ptr<usc::DBusConnectionHandle> usc::Server::the_shared_dbus_connection()
+{
+    if (!the_options()->get(dbus_shared_connection, false))
+        return {};
+
+    return shared_dbus_connection(
+        [this]
+        {
+            auto const connection = new_dbus_connection();
+
+            // The event sinks only send, but incoming messages still need
+            // to be read from the connection
+            the_dbus_event_loop_for(dbus_shared_connection_services)->add_connection(connection);
+            return connection;
+        });
+}
+
+std::shared_ptr<usc::DBusPeerServer> usc::Server::the_dbus_peer_server()
+{
+    if (!the_options()->is_set(dbus_peer_address))
+        return {};
+
+    return dbus_peer_server(
+        [this]
+        {
+            auto const options = the_options();
+            auto const allowed_uids = options->is_set(dbus_peer_uids) ?
+                uids_from_string(options->get<std::string>(dbus_peer_uids)) :
+                std::vector<uid_t>{};
+
+            return std::make_shared<DBusPeerServer>(
+                the_dbus_event_loop_for(dbus_shared_connection_services),
+                options->get<std::string>(dbus_peer_address),
+                allowed_uids);
         });
 }
 
+std::shared_ptr<usc::DBusConnectionHandle> usc::Server::dbus_connection()
+{
+    if (auto const connection = the_shared_dbus_connection())
+        return connection;
+
+    return new_dbus_connection();
+}
+
+std::shared_ptr<usc::DBusConnectionHandle> usc::Server::new_dbus_connection()
+{
+    if (dbus_registration_finished)
+        return std::make_shared<DBusConnectionHandle>(dbus_bus_address());
+
+    auto const connection = std::make_shared<DBusConnectionHandle>(
+        dbus_bus_address(), DBusConnectionHandle::Registration::pipelined);
+    unregistered_dbus_connections.push_back(connection);
+    return connection;
+}
+
+void usc::Server::finish_dbus_registration()
+{
+    dbus_registration_finished = true;
+
+    auto const connections = std::move(unregistered_dbus_connections);
+    unregistered_dbus_connections.clear();
+
+    for (auto const& connection : connections)
+        connection->finish_registration();
+}
+
+std::shared_ptr<usc::DBusEventLoop> usc::Server::the_dbus_event_loop_for(char const* service)
+{
+    // A connection is served by one loop, so sharing it, or serving peers
+    // that call all the services over one connection, puts all the
+    // services on that loop
+    if (the_options()->get(dbus_shared_connection, false) ||
+        the_options()->is_set(dbus_peer_address))
+    {
+        service = dbus_shared_connection_services;
+    }
+
+    return the_dbus_event_loop_pool()->loop_for(service);
+}
+
 std::shared_ptr<usc::UnityDisplayService> usc::Server::the_unity_display_service()
 {
     return unity_display_service(
         [this]
         {
-            return std::make_shared<UnityDisplayService>(
-                    the_dbus_event_loop(),
-                    dbus_bus_address(),
-                    the_screen());
+            auto const service = std::make_shared<UnityDisplayService>(
+                    the_dbus_event_loop_for(dbus_display_service),
+                    dbus_connection(),
+                    the_screen(),
+                    dbus_rate_limits(*the_options()));
+
+            if (auto const peer_server = the_dbus_peer_server())
+                service->serve_peers(peer_server);
+
+            return service;
         });
 }
 
@@ -365,7 +538,17 @@ std::shared_ptr<usc::PowerButtonEventSink> usc::Server::the_power_button_event_s
     return power_button_event_sink(
         [this]
         {
-            return std::make_shared<UnityPowerButtonEventSink>(dbus_bus_address());
+            auto const shared_connection = the_shared_dbus_connection();
+            auto const sink = shared_connection ?
+                std::make_shared<UnityPowerButtonEventSink>(
+                    shared_connection,
+                    the_dbus_event_loop_for(dbus_shared_connection_services)) :
+                std::make_shared<UnityPowerButtonEventSink>(new_dbus_connection());
+
+            if (auto const peer_server = the_dbus_peer_server())
+                sink->serve_peers(peer_server);
+
+            return sink;
         });
 }
 
@@ -374,7 +557,17 @@ std::shared_ptr<usc::UserActivityEventSink> usc::Server::the_user_activity_event
     return user_activity_event_sink(
         [this]
         {
-            return std::make_shared<UnityUserActivityEventSink>(dbus_bus_address());
+            auto const shared_connection = the_shared_dbus_connection();
+            auto const sink = shared_connection ?
+                std::make_shared<UnityUserActivityEventSink>(
+                    shared_connection,
+                    the_dbus_event_loop_for(dbus_shared_connection_services)) :
+                std::make_shared<UnityUserActivityEventSink>(new_dbus_connection());
+
+            if (auto const peer_server = the_dbus_peer_server())
+                sink->serve_peers(peer_server);
+
+            return sink;
         });
 }
 
@@ -383,10 +576,28 @@ std::shared_ptr<usc::UnityInputService> usc::Server::the_unity_input_service()
     return unity_input_service(
         [this]
         {
-            return std::make_shared<UnityInputService>(
-                    the_dbus_event_loop(),
-                    dbus_bus_address(),
-                    the_input_configuration());
+            auto const service = std::make_shared<UnityInputService>(
+                    the_dbus_event_loop_for(dbus_input_service),
+                    dbus_connection(),
+                    the_input_configuration(),
+                    dbus_rate_limits(*the_options()));
+
+            if (auto const peer_server = the_dbus_peer_server())
+                service->serve_peers(peer_server);
+
+            return service;
+        });
+}
+
+std::shared_ptr<usc::UnityDebugService> usc::Server::the_unity_debug_service()
+{
+    return unity_debug_service(
+        [this]
+        {
+            return std::make_shared<UnityDebugService>(
+                    the_dbus_event_loop_for(dbus_debug_service),
+                    dbus_connection(),
+                    the_dbus_event_loop_pool());
         });
 }
 
@@ -24,6 +24,7 @@
 #include <mir/options/option.h>
 
 #include <chrono>
+#include <vector>
 
 namespace mir
 {
@@ -45,8 +46,12 @@ class PowerButtonEventSink;
 class UserActivityEventSink;
 class InputConfiguration;
 class UnityInputService;
+class UnityDebugService;
+class DBusConnectionHandle;
 class DBusConnectionThread;
 class DBusEventLoop;
+class DBusEventLoopPool;
+class DBusPeerServer;
 class Clock;
 
 class Server : private mir::Server
@@ -70,12 +75,19 @@ public:
     virtual std::shared_ptr<mir::input::EventFilter> the_screen_event_handler();
     virtual std::shared_ptr<UnityDisplayService> the_unity_display_service();
     virtual std::shared_ptr<UnityInputService> the_unity_input_service();
+    virtual std::shared_ptr<UnityDebugService> the_unity_debug_service();
     virtual std::shared_ptr<PowerButtonEventSink> the_power_button_event_sink();
     virtual std::shared_ptr<UserActivityEventSink> the_user_activity_event_sink();
-    virtual std::shared_ptr<DBusEventLoop> the_dbus_event_loop();
+    virtual std::shared_ptr<DBusEventLoopPool> the_dbus_event_loop_pool();
     virtual std::shared_ptr<DBusConnectionThread> the_dbus_connection_thread();
     virtual std::shared_ptr<Clock> the_clock();
 
+    // The D-Bus connections of the services and event sinks send Hello and
+    // RequestName without waiting for the replies. This waits for all of
+    // them together, and must be called before the D-Bus loops start.
+    // Connections opened afterwards register with the bus straight away.
+    void finish_dbus_registration();
+
     bool show_version()
     {
         return the_options()->is_set("version");
@@ -118,6 +130,17 @@ private:
 
     virtual std::shared_ptr<SessionSwitcher> the_session_switcher();
     std::string dbus_bus_address();
+    // With --dbus-shared-connection all the services and event sinks own
+    // their names on one connection, served by one loop. Otherwise each
+    // opens its own, and the_shared_dbus_connection() returns null.
+    std::shared_ptr<DBusConnectionHandle> the_shared_dbus_connection();
+    // With --dbus-peer-address the services and event sinks are also served
+    // directly to trusted peers. Otherwise returns null.
+    std::shared_ptr<DBusPeerServer> the_dbus_peer_server();
+    // The shared connection, or a new one
+    std::shared_ptr<DBusConnectionHandle> dbus_connection();
+    std::shared_ptr<DBusConnectionHandle> new_dbus_connection();
+    std::shared_ptr<DBusEventLoop> the_dbus_event_loop_for(char const* service);
 
     mir::CachedPtr<Spinner> spinner;
     mir::CachedPtr<DMConnection> dm_connection;
@@ -126,12 +149,17 @@ private:
     mir::CachedPtr<InputConfiguration> input_configuration;
     mir::CachedPtr<mir::input::EventFilter> screen_event_handler;
     mir::CachedPtr<DBusConnectionThread> dbus_thread;
-    mir::CachedPtr<DBusEventLoop> dbus_loop;
+    mir::CachedPtr<DBusEventLoopPool> dbus_loop_pool;
+    mir::CachedPtr<DBusConnectionHandle> shared_dbus_connection;
     mir::CachedPtr<UnityDisplayService> unity_display_service;
     mir::CachedPtr<PowerButtonEventSink> power_button_event_sink;
     mir::CachedPtr<UserActivityEventSink> user_activity_event_sink;
     mir::CachedPtr<UnityInputService> unity_input_service;
+    mir::CachedPtr<UnityDebugService> unity_debug_service;
     mir::CachedPtr<Clock> clock;
+    mir::CachedPtr<DBusPeerServer> dbus_peer_server;
+    std::vector<std::shared_ptr<DBusConnectionHandle>> unregistered_dbus_connections;
+    bool dbus_registration_finished{false};
 };
 
 }
@@ -121,6 +121,8 @@ void usc::SystemCompositor::run()
             composite_filter->append(screen_event_handler);
 
             unity_input_service = server->the_unity_input_service();
+            unity_debug_service = server->the_unity_debug_service();
+            server->finish_dbus_registration();
             dbus_service_thread = server->the_dbus_connection_thread();
         });
 
@@ -40,6 +40,7 @@ class ScreenEventHandler;
 class Screen;
 class UnityDisplayService;
 class UnityInputService;
+class UnityDebugService;
 class DBusConnectionThread;
 
 class SystemCompositor
@@ -56,6 +57,7 @@ private:
     std::shared_ptr<mir::input::EventFilter> screen_event_handler;
     std::shared_ptr<UnityDisplayService> unity_display_service;
     std::shared_ptr<UnityInputService> unity_input_service;
+    std::shared_ptr<UnityDebugService> unity_debug_service;
     std::shared_ptr<DBusConnectionThread> dbus_service_thread;
 };
 
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_TASK_H_
+#define USC_TASK_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace usc
+{
+
+// A move-only void() callable. Callables that fit in the inline buffer
+// (most lambdas capturing a few pointers and values) are stored without
+// any heap allocation; larger ones fall back to the heap.
+class Task
+{
+public:
+    static size_t const inline_size = 6 * sizeof(void*);
+
+    Task() noexcept : ops{nullptr} {}
+
+    template<typename F,
+             typename = typename std::enable_if<
+                 !std::is_same<typename std::decay<F>::type, Task>::value>::type>
+    Task(F&& f)
+        : ops{ops_for<typename std::decay<F>::type>()}
+    {
+        OpsImpl<typename std::decay<F>::type>::construct(&storage, std::forward<F>(f));
+    }
+
+    Task(Task&& other) noexcept
+        : ops{other.ops}
+    {
+        if (ops)
+        {
+            ops->move(&other.storage, &storage);
+            other.ops = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            if (other.ops)
+            {
+                ops = other.ops;
+                ops->move(&other.storage, &storage);
+                other.ops = nullptr;
+            }
+        }
+
+        return *this;
+    }
+
+    ~Task()
+    {
+        reset();
+    }
+
+    void operator()()
+    {
+        ops->invoke(&storage);
+    }
+
+    explicit operator bool() const
+    {
+        return ops != nullptr;
+    }
+
+    void reset() noexcept
+    {
+        if (ops)
+        {
+            ops->destroy(&storage);
+            ops = nullptr;
+        }
+    }
+
+    template<typename F>
+    static constexpr bool is_inline()
+    {
+        return sizeof(F) <= inline_size &&
+               alignof(F) <= alignof(Storage) &&
+               std::is_nothrow_move_constructible<F>::value;
+    }
+
+private:
+    Task(Task const&) = delete;
+    Task& operator=(Task const&) = delete;
+
+    using Storage = typename std::aligned_storage<inline_size, alignof(std::max_align_t)>::type;
+
+    struct Ops
+    {
+        void (*invoke)(void* storage);
+        void (*move)(void* from, void* to) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename F>
+    struct InlineOps
+    {
+        template<typename G>
+        static void construct(void* storage, G&& g) { new (storage) F(std::forward<G>(g)); }
+        static void invoke(void* storage) { (*static_cast<F*>(storage))(); }
+        static void move(void* from, void* to) noexcept
+        {
+            new (to) F(std::move(*static_cast<F*>(from)));
+            static_cast<F*>(from)->~F();
+        }
+        static void destroy(void* storage) noexcept { static_cast<F*>(storage)->~F(); }
+    };
+
+    template<typename F>
+    struct HeapOps
+    {
+        static F*& ptr(void* storage) { return *static_cast<F**>(storage); }
+        template<typename G>
+        static void construct(void* storage, G&& g) { ptr(storage) = new F(std::forward<G>(g)); }
+        static void invoke(void* storage) { (*ptr(storage))(); }
+        static void move(void* from, void* to) noexcept { ptr(to) = ptr(from); }
+        static void destroy(void* storage) noexcept { delete ptr(storage); }
+    };
+
+    template<typename F>
+    using OpsImpl = typename std::conditional<
+        is_inline<F>(), InlineOps<F>, HeapOps<F>>::type;
+
+    template<typename F>
+    static Ops const* ops_for()
+    {
+        static Ops const ops{
+            &OpsImpl<F>::invoke, &OpsImpl<F>::move, &OpsImpl<F>::destroy};
+        return &ops;
+    }
+
+    Storage storage;
+    Ops const* ops;
+};
+
+}
+
+#endif
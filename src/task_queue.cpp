@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "task_queue.h"
+
+namespace
+{
+
+size_t round_up_to_power_of_two(size_t n)
+{
+    size_t p{2};
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+}
+
+usc::TaskQueue::TaskQueue(size_t capacity)
+    : mask{round_up_to_power_of_two(capacity) - 1},
+      slots{new Slot[mask + 1]},
+      enqueue_position{0},
+      dequeue_position{0},
+      overflowing{false},
+      overflow_to_run_index{0}
+{
+    for (size_t i = 0; i <= mask; ++i)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+usc::TaskQueue::~TaskQueue() = default;
+
+void usc::TaskQueue::push(Task&& task)
+{
+    if (!overflowing.load(std::memory_order_acquire) && try_push_to_ring(task))
+        return;
+
+    std::lock_guard<std::mutex> lock{overflow_mutex};
+    overflow.push_back(std::move(task));
+    overflowing.store(true, std::memory_order_release);
+}
+
+bool usc::TaskQueue::try_push_to_ring(Task& task)
+{
+    auto position = enqueue_position.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        auto& slot = slots[position & mask];
+        auto const sequence = slot.sequence.load(std::memory_order_acquire);
+        auto const difference =
+            static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+        if (difference == 0)
+        {
+            if (enqueue_position.compare_exchange_weak(
+                    position, position + 1, std::memory_order_relaxed))
+            {
+                slot.task = std::move(task);
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The slot still holds a task from the previous lap: full
+            return false;
+        }
+        else
+        {
+            position = enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool usc::TaskQueue::try_pop_from_ring(size_t end_position, Task& task)
+{
+    if (dequeue_position == end_position)
+        return false;
+
+    auto& slot = slots[dequeue_position & mask];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeue_position + 1)
+    {
+        // Claimed but not yet published. The producer wakes the consumer
+        // up again after publishing, so we'll get to it then.
+        return false;
+    }
+
+    task = std::move(slot.task);
+    slot.sequence.store(dequeue_position + mask + 1, std::memory_order_release);
+    ++dequeue_position;
+
+    return true;
+}
+
+size_t usc::TaskQueue::run_pending(size_t max_tasks)
+{
+    size_t run{0};
+    Task task;
+
+    auto const run_ring_tasks_until =
+        [&] (size_t end_position)
+        {
+            while (run < max_tasks && try_pop_from_ring(end_position, task))
+            {
+                task();
+                task.reset();
+                ++run;
+            }
+        };
+
+    // Overflow tasks left over from a previous call were pushed before
+    // anything now in the ring
+    run_overflow_tasks(max_tasks, run);
+    if (!overflow_to_run.empty())
+        return run;
+
+    run_ring_tasks_until(enqueue_position.load(std::memory_order_acquire));
+
+    if (run < max_tasks && overflowing.load(std::memory_order_acquire))
+    {
+        // Overflow tasks were pushed after everything in the ring, so the
+        // ring has to be empty before we can run them
+        run_ring_tasks_until(enqueue_position.load(std::memory_order_acquire));
+        if (dequeue_position != enqueue_position.load(std::memory_order_acquire))
+            return run;
+
+        {
+            std::lock_guard<std::mutex> lock{overflow_mutex};
+            overflow_to_run.swap(overflow);
+            overflowing.store(false, std::memory_order_release);
+        }
+
+        run_overflow_tasks(max_tasks, run);
+    }
+
+    return run;
+}
+
+void usc::TaskQueue::run_overflow_tasks(size_t max_tasks, size_t& run)
+{
+    while (run < max_tasks && overflow_to_run_index < overflow_to_run.size())
+    {
+        auto task = std::move(overflow_to_run[overflow_to_run_index++]);
+        task();
+        ++run;
+    }
+
+    if (overflow_to_run_index == overflow_to_run.size())
+    {
+        overflow_to_run.clear();
+        overflow_to_run_index = 0;
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_TASK_QUEUE_H_
+#define USC_TASK_QUEUE_H_
+
+#include "task.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace usc
+{
+
+// A multi-producer, single-consumer queue of tasks.
+//
+// Producers claim slots in a fixed size ring buffer with a single atomic
+// compare-and-swap, so pushing neither blocks nor allocates. Only when the
+// ring is full do producers fall back to a mutex protected overflow list;
+// while that list is in use all producers go through it, so tasks pushed
+// by the same thread are always consumed in order.
+class TaskQueue
+{
+public:
+    explicit TaskQueue(size_t capacity = 1024);
+    ~TaskQueue();
+
+    void push(Task&& task);
+
+    // Runs, in the consumer thread, up to max_tasks of the tasks that were
+    // pushed before this call. Returns the number of tasks run.
+    size_t run_pending(size_t max_tasks = SIZE_MAX);
+
+private:
+    TaskQueue(TaskQueue const&) = delete;
+    TaskQueue& operator=(TaskQueue const&) = delete;
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        Task task;
+    };
+
+    bool try_push_to_ring(Task& task);
+    bool try_pop_from_ring(size_t end_position, Task& task);
+    void run_overflow_tasks(size_t max_tasks, size_t& run);
+
+    size_t const mask;
+    std::unique_ptr<Slot[]> const slots;
+    std::atomic<size_t> enqueue_position;
+    size_t dequeue_position;
+
+    std::atomic<bool> overflowing;
+    std::mutex overflow_mutex;
+    std::vector<Task> overflow;
+
+    // Overflow tasks taken by the consumer but not yet run
+    std::vector<Task> overflow_to_run;
+    size_t overflow_to_run_index;
+};
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timer_queue.h"
+
+#include <algorithm>
+
+usc::TimerQueue::TimerQueue()
+    : next_id{1}
+{
+}
+
+usc::TimerQueue::Id usc::TimerQueue::add(TimePoint deadline, Task task)
+{
+    auto const id = next_id++;
+
+    tasks.emplace(id, std::move(task));
+    heap.push_back(Entry{deadline, id});
+    std::push_heap(heap.begin(), heap.end(), Later{});
+
+    return id;
+}
+
+bool usc::TimerQueue::cancel(Id id)
+{
+    if (tasks.erase(id) == 0)
+        return false;
+
+    compact_if_needed();
+    return true;
+}
+
+bool usc::TimerQueue::is_pending(Id id) const
+{
+    return tasks.find(id) != tasks.end();
+}
+
+bool usc::TimerQueue::next_deadline(TimePoint& deadline)
+{
+    drop_cancelled_top();
+
+    if (heap.empty())
+        return false;
+
+    deadline = heap.front().deadline;
+    return true;
+}
+
+size_t usc::TimerQueue::take_due(TimePoint now, std::vector<Task>& due)
+{
+    size_t taken{0};
+
+    for (drop_cancelled_top();
+         !heap.empty() && heap.front().deadline <= now;
+         drop_cancelled_top())
+    {
+        auto const iter = tasks.find(heap.front().id);
+        due.push_back(std::move(iter->second));
+        tasks.erase(iter);
+
+        std::pop_heap(heap.begin(), heap.end(), Later{});
+        heap.pop_back();
+        ++taken;
+    }
+
+    return taken;
+}
+
+size_t usc::TimerQueue::size() const
+{
+    return tasks.size();
+}
+
+void usc::TimerQueue::drop_cancelled_top()
+{
+    while (!heap.empty() && tasks.find(heap.front().id) == tasks.end())
+    {
+        std::pop_heap(heap.begin(), heap.end(), Later{});
+        heap.pop_back();
+    }
+}
+
+void usc::TimerQueue::compact_if_needed()
+{
+    static size_t const min_size_to_compact = 64;
+
+    if (heap.size() < min_size_to_compact || heap.size() < 2 * tasks.size())
+        return;
+
+    heap.erase(
+        std::remove_if(heap.begin(), heap.end(),
+            [this] (Entry const& e) { return tasks.find(e.id) == tasks.end(); }),
+        heap.end());
+    std::make_heap(heap.begin(), heap.end(), Later{});
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_TIMER_QUEUE_H_
+#define USC_TIMER_QUEUE_H_
+
+#include "task.h"
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace usc
+{
+
+// A min-heap of tasks keyed on their deadline. Cancelled entries are
+// dropped lazily when they reach the top of the heap, and the heap is
+// compacted if they start to dominate it. Not thread-safe.
+class TimerQueue
+{
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+    using Id = uint64_t;
+
+    TimerQueue();
+
+    Id add(TimePoint deadline, Task task);
+    bool cancel(Id id);
+    bool is_pending(Id id) const;
+
+    // Gets the earliest pending deadline, returns false if there is none
+    bool next_deadline(TimePoint& deadline);
+
+    // Moves the tasks whose deadline is not after now into due, in
+    // deadline order, and returns how many there were
+    size_t take_due(TimePoint now, std::vector<Task>& due);
+
+    size_t size() const;
+
+private:
+    struct Entry
+    {
+        TimePoint deadline;
+        Id id;
+    };
+
+    struct Later
+    {
+        bool operator()(Entry const& a, Entry const& b) const
+        {
+            return a.deadline > b.deadline ||
+                   (a.deadline == b.deadline && a.id > b.id);
+        }
+    };
+
+    void drop_cancelled_top();
+    void compact_if_needed();
+
+    Id next_id;
+    std::vector<Entry> heap;
+    std::unordered_map<Id, Task> tasks;
+};
+
+}
+
+#endif
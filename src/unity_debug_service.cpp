@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "unity_debug_service.h"
+#include "dbus_event_loop.h"
+#include "dbus_event_loop_pool.h"
+#include "dbus_message_handle.h"
+
+#include "unity_debug_service_introspection.h" // autogenerated
+
+namespace
+{
+
+char const* const dbus_debug_path = "/com/canonical/Unity/Debug";
+char const* const dbus_debug_service_name = "com.canonical.Unity.Debug";
+
+}
+
+usc::UnityDebugService::UnityDebugService(
+    std::shared_ptr<usc::DBusEventLoop> const& loop,
+    std::string const& address,
+    std::shared_ptr<usc::DBusEventLoopPool> const& pool)
+    : UnityDebugService{loop, std::make_shared<DBusConnectionHandle>(address.c_str()), pool}
+{
+}
+
+usc::UnityDebugService::UnityDebugService(
+    std::shared_ptr<usc::DBusEventLoop> const& loop,
+    std::shared_ptr<usc::DBusConnectionHandle> const& connection,
+    std::shared_ptr<usc::DBusEventLoopPool> const& pool)
+    : loop{loop},
+      connection{connection},
+      pool{pool},
+      introspection_reply{
+          DBusMessageTemplate::method_return(
+              DBUS_TYPE_STRING, &unity_debug_service_introspection,
+              DBUS_TYPE_INVALID)}
+{
+    methods.add(
+        "org.freedesktop.DBus.Introspectable", "Introspect",
+        [this] (DBusMessage* message) { handle_Introspect(message); });
+    add_dbus_methods(methods, loop, connection);
+    loop->stats().add_methods(methods);
+    methods.register_object_path(*connection, dbus_debug_path);
+
+    loop->add_connection(connection);
+    connection->request_name(dbus_debug_service_name);
+}
+
+void usc::UnityDebugService::handle_Introspect(DBusMessage* message)
+{
+    introspection_reply.send_reply(*connection, message);
+}
+
+void usc::UnityDebugService::dbus_SetDBusInstrumentation(bool enabled)
+{
+    for (auto const& pool_loop : pool->loops())
+        pool_loop->set_instrumentation_enabled(enabled);
+}
+
+std::string usc::UnityDebugService::dbus_GetDBusStats()
+{
+    std::string stats;
+    auto const& loops = pool->loops();
+
+    for (size_t i = 0; i < loops.size(); ++i)
+    {
+        stats += "USC/DBus-" + std::to_string(i) + ":\n";
+        stats += loops[i]->stats().report();
+    }
+
+    return stats;
+}
+
+void usc::UnityDebugService::dbus_ResetDBusStats()
+{
+    for (auto const& pool_loop : pool->loops())
+        pool_loop->stats().reset();
+}
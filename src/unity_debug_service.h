@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USC_UNITY_DEBUG_SERVICE_H_
+#define USC_UNITY_DEBUG_SERVICE_H_
+
+#include "dbus_connection_handle.h"
+#include "dbus_message_template.h"
+#include "dbus_method_table.h"
+
+#include <memory>
+#include <string>
+
+#include "unity_debug_service_stubs.h" // autogenerated
+
+namespace usc
+{
+class DBusEventLoop;
+class DBusEventLoopPool;
+
+// Lets the D-Bus loop instrumentation be switched on and queried at
+// runtime, over com.canonical.Unity.Debug
+class UnityDebugService : public UnityDebugServiceStubs
+{
+public:
+    UnityDebugService(
+        std::shared_ptr<usc::DBusEventLoop> const& loop,
+        std::string const& address,
+        std::shared_ptr<usc::DBusEventLoopPool> const& pool);
+    // Serves on connection, which may be shared with other services on loop
+    UnityDebugService(
+        std::shared_ptr<usc::DBusEventLoop> const& loop,
+        std::shared_ptr<usc::DBusConnectionHandle> const& connection,
+        std::shared_ptr<usc::DBusEventLoopPool> const& pool);
+
+private:
+    void handle_Introspect(DBusMessage* message);
+
+    void dbus_SetDBusInstrumentation(bool enabled) override;
+    std::string dbus_GetDBusStats() override;
+    void dbus_ResetDBusStats() override;
+
+    std::shared_ptr<DBusEventLoop> const loop;
+    std::shared_ptr<DBusConnectionHandle> connection;
+    std::shared_ptr<DBusEventLoopPool> const pool;
+    DBusMessageTemplate const introspection_reply;
+    DBusMethodTable methods;
+};
+
+}
+
+#endif
@@ -19,61 +19,55 @@
  */
 
 #include "unity_display_service.h"
+#include "dbus_peer_server.h"
 #include "screen.h"
 #include "dbus_message_handle.h"
 #include "dbus_event_loop.h"
 #include "dbus_connection_handle.h"
-#include "scoped_dbus_error.h"
 
 #include "unity_display_service_introspection.h" // autogenerated
 
+#include <algorithm>
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+
 namespace
 {
 
-char const* const dbus_display_interface = "com.canonical.Unity.Display";
 char const* const dbus_display_path = "/com/canonical/Unity/Display";
 char const* const dbus_display_service_name = "com.canonical.Unity.Display";
+char const* const dbus_display_interface = "com.canonical.Unity.Display";
+// Display power requests must not wait behind a busy input settings client
+int const dbus_display_dispatch_priority = 4;
 
-void usc_dbus_message_iter_append_active_outputs_variant(
-    DBusMessageIter* iter, usc::ActiveOutputs const& active_outputs)
+usc::OutputFilter output_filter_from_string(std::string const& filter_str)
 {
-    DBusMessageIter iter_variant;
-    dbus_message_iter_open_container(iter, DBUS_TYPE_VARIANT, "(ii)", &iter_variant);
-
-    {
-        DBusMessageIter iter_struct;
-        dbus_message_iter_open_container(&iter_variant, DBUS_TYPE_STRUCT, nullptr, &iter_struct);
-
-        dbus_message_iter_append_basic(&iter_struct, DBUS_TYPE_INT32, &active_outputs.internal);
-        dbus_message_iter_append_basic(&iter_struct, DBUS_TYPE_INT32, &active_outputs.external);
-
-        dbus_message_iter_close_container(&iter_variant, &iter_struct);
-    }
+    if (filter_str == "internal")
+        return usc::OutputFilter::internal;
+    else if (filter_str == "external")
+        return usc::OutputFilter::external;
 
-    dbus_message_iter_close_container(iter, &iter_variant);
+    return usc::OutputFilter::all;
 }
 
-void usc_dbus_message_iter_append_active_outputs_dict_entry(
-    DBusMessageIter* iter, usc::ActiveOutputs const& active_outputs)
+char const* power_mode_name(MirPowerMode power_mode)
 {
-    char const* key = "ActiveOutputs";
-    DBusMessageIter iter_entry;
-    dbus_message_iter_open_container(iter, DBUS_TYPE_DICT_ENTRY, nullptr, &iter_entry);
-
-    dbus_message_iter_append_basic(&iter_entry, DBUS_TYPE_STRING, &key);
-    usc_dbus_message_iter_append_active_outputs_variant(&iter_entry, active_outputs);
-
-    dbus_message_iter_close_container(iter, &iter_entry);
+    switch (power_mode)
+    {
+        case mir_power_mode_on: return "on";
+        case mir_power_mode_standby: return "standby";
+        case mir_power_mode_suspend: return "suspend";
+        default: return "off";
+    }
 }
 
-usc::OutputFilter output_filter_from_string(std::string const& filter_str)
+usc::OutputState const* find_output_state(
+    std::vector<usc::OutputState> const& output_states, int32_t id)
 {
-    if (filter_str == "internal")
-        return usc::OutputFilter::internal;
-    else if (filter_str == "external")
-        return usc::OutputFilter::external;
+    auto const iter = std::find_if(output_states.begin(), output_states.end(),
+        [id] (usc::OutputState const& state) { return state.id == id; });
 
-    return usc::OutputFilter::all;
+    return iter == output_states.end() ? nullptr : &*iter;
 }
 
 }
@@ -81,201 +75,300 @@ usc::OutputFilter output_filter_from_string(std::string const& filter_str)
 usc::UnityDisplayService::UnityDisplayService(
     std::shared_ptr<usc::DBusEventLoop> const& loop,
     std::string const& address,
-    std::shared_ptr<usc::Screen> const& screen)
+    std::shared_ptr<usc::Screen> const& screen,
+    DBusRateLimiter::Limits const& rate_limits)
+    : UnityDisplayService{
+          loop, std::make_shared<DBusConnectionHandle>(address.c_str()), screen, rate_limits}
+{
+}
+
+usc::UnityDisplayService::UnityDisplayService(
+    std::shared_ptr<usc::DBusEventLoop> const& loop,
+    std::shared_ptr<usc::DBusConnectionHandle> const& connection,
+    std::shared_ptr<usc::Screen> const& screen,
+    DBusRateLimiter::Limits const& rate_limits)
     : screen{screen},
       loop{loop},
-      connection{std::make_shared<DBusConnectionHandle>(address.c_str())}
+      connection{connection},
+      active_outputs_window_open{false},
+      active_outputs_changes_pending{0},
+      active_outputs_emitted{0},
+      active_outputs_suppressed{0},
+      output_states_emission_pending{false},
+      introspection_reply{
+          DBusMessageTemplate::method_return(
+              DBUS_TYPE_STRING, &unity_display_service_introspection,
+              DBUS_TYPE_INVALID)},
+      rate_limiter{loop, connection, rate_limits},
+      power_worker{1}
 {
-    loop->add_connection(connection);
+    methods.add(
+        "org.freedesktop.DBus.Introspectable", "Introspect",
+        [this] (DBusMessage* message) { handle_Introspect(message); });
+    add_dbus_methods(methods, loop, connection);
+
+    // Every power call reconfigures the display in turn, so a client
+    // calling too often gets an error rather than delaying everyone
+    // else's, powerd's included
+    for (auto const method : {"TurnOn", "TurnOff", "TurnOnOutputs", "TurnOffOutputs"})
+        rate_limiter.limit(methods, dbus_display_interface, method, DBusRateLimiter::Excess::reject);
+    loop->stats().add_methods(methods);
+    methods.register_object_path(*connection, dbus_display_path);
+
+    loop->add_connection(connection, dbus_display_dispatch_priority);
     connection->request_name(dbus_display_service_name);
-    connection->add_filter(handle_dbus_message_thunk, this);
 
     screen->register_active_outputs_handler(this,
         [this] (ActiveOutputs const& active_outputs_arg)
         {
             this->loop->enqueue(
-                [this, active_outputs_arg]
-                {
-                    active_outputs = active_outputs_arg;
-                    dbus_emit_ActiveOutputs();
-                });
+                DBusEventLoop::ActionPriority::urgent,
+                [this, active_outputs_arg] { update_active_outputs(active_outputs_arg); });
+        });
+
+    screen->register_output_states_handler(this,
+        [this] (std::vector<OutputState> const& output_states_arg)
+        {
+            this->loop->enqueue(
+                DBusEventLoop::ActionPriority::urgent,
+                [this, output_states_arg] { update_output_states(output_states_arg); });
         });
 }
 
 usc::UnityDisplayService::~UnityDisplayService()
 {
     screen->unregister_active_outputs_handler(this);
+    screen->unregister_output_states_handler(this);
+    active_outputs_emission.cancel();
+    output_states_emission.cancel();
 }
 
-::DBusHandlerResult usc::UnityDisplayService::handle_dbus_message_thunk(
-    ::DBusConnection* connection, DBusMessage* message, void* user_data)
+std::chrono::milliseconds const usc::UnityDisplayService::active_outputs_coalescing_window{20};
+
+uint64_t usc::UnityDisplayService::active_outputs_signals_emitted() const
 {
-    auto const dbus_display_service = static_cast<usc::UnityDisplayService*>(user_data);
-    return dbus_display_service->handle_dbus_message(connection, message, user_data);
+    return active_outputs_emitted;
 }
 
-DBusHandlerResult usc::UnityDisplayService::handle_dbus_message(
-    ::DBusConnection* connection, DBusMessage* message, void* user_data)
+uint64_t usc::UnityDisplayService::active_outputs_signals_suppressed() const
 {
-    ScopedDBusError args_error;
+    return active_outputs_suppressed;
+}
 
-    if (dbus_message_is_method_call(message, "org.freedesktop.DBus.Introspectable", "Introspect"))
+void usc::UnityDisplayService::update_active_outputs(ActiveOutputs const& new_active_outputs)
+{
+    // Get replies with the new value straight away, only the signal waits
+    if (!(new_active_outputs == active_outputs))
     {
-        DBusMessageHandle reply{
-            dbus_message_new_method_return(message),
-            DBUS_TYPE_STRING, &unity_display_service_introspection,
-            DBUS_TYPE_INVALID};
-
-        dbus_connection_send(connection, reply, nullptr);
+        active_outputs = new_active_outputs;
+        dbus_properties_changed();
     }
-    else if (dbus_message_is_method_call(message, dbus_display_interface, "TurnOn"))
-    {
-        char const* filter{""};
-        dbus_message_get_args(
-            message, &args_error,
-            DBUS_TYPE_STRING, &filter,
-            DBUS_TYPE_INVALID);
 
-        // For backward compatibility
-        if (args_error)
-            filter = "all";
+    // A lone change, such as the screen waking up, is signalled straight
+    // away. Mir applies several configurations in a row when outputs change
+    // or the power mode is set, so the changes that follow wait for the
+    // dust to settle, and only the latest of them is signalled.
+    ++active_outputs_changes_pending;
+    if (!active_outputs_window_open)
+        emit_active_outputs();
+}
 
-        dbus_TurnOn(filter);
+void usc::UnityDisplayService::emit_active_outputs()
+{
+    auto const changes = active_outputs_changes_pending;
+    active_outputs_changes_pending = 0;
 
-        DBusMessageHandle reply{dbus_message_new_method_return(message)};
-        dbus_connection_send(connection, reply, nullptr);
-    }
-    else if (dbus_message_is_method_call(message, dbus_display_interface, "TurnOff"))
+    if (active_outputs == signalled_active_outputs)
     {
-        char const* filter{""};
-
-        dbus_message_get_args(
-            message, &args_error,
-            DBUS_TYPE_STRING, &filter,
-            DBUS_TYPE_INVALID);
-
-        // For backward compatibility
-        if (args_error)
-            filter = "all";
-
-        dbus_TurnOff(filter);
-
-        DBusMessageHandle reply{dbus_message_new_method_return(message)};
-        dbus_connection_send(connection, reply, nullptr);
+        active_outputs_suppressed += changes;
+        return;
     }
-    else if (dbus_message_is_method_call(message, "org.freedesktop.DBus.Properties", "Get"))
-    {
-        char const* interface{""};
-        char const* property{""};
-        dbus_message_get_args(
-            message, &args_error,
-            DBUS_TYPE_STRING, &interface,
-            DBUS_TYPE_STRING, &property,
-            DBUS_TYPE_INVALID);
 
-        DBusMessageHandle reply{dbus_message_new_method_return(message)};
+    signalled_active_outputs = active_outputs;
+    ++active_outputs_emitted;
+    active_outputs_suppressed += changes - 1;
+    dbus_emit_ActiveOutputs();
 
-        if (!args_error && std::string{interface} == dbus_display_interface)
-            dbus_properties_Get(reply, property);
+    active_outputs_window_open = true;
+    active_outputs_emission = loop->enqueue_after(
+        active_outputs_coalescing_window,
+        [this]
+        {
+            active_outputs_window_open = false;
 
-        dbus_connection_send(connection, reply, nullptr);
-    }
-    else if (dbus_message_is_method_call(message, "org.freedesktop.DBus.Properties", "GetAll"))
-    {
-        char const* interface{""};
-        dbus_message_get_args(
-            message, &args_error,
-            DBUS_TYPE_STRING, &interface,
-            DBUS_TYPE_INVALID);
+            if (active_outputs_changes_pending > 0)
+                emit_active_outputs();
+        });
+}
 
-        DBusMessageHandle reply{dbus_message_new_method_return(message)};
+void usc::UnityDisplayService::serve_peers(std::shared_ptr<DBusPeerServer> const& peer_server)
+{
+    peer_server->serve(loop,
+        [this] (std::shared_ptr<DBusConnectionHandle> const& peer) -> std::shared_ptr<void>
+        {
+            // Peers are let in by uid, and have no sender to limit, so
+            // their calls aren't rate limited
+            auto const peer_methods = std::make_shared<DBusMethodTable>();
+            DBusConnection* const peer_connection = *peer;
+
+            peer_methods->add(
+                "org.freedesktop.DBus.Introspectable", "Introspect",
+                [this, peer_connection] (DBusMessage* message)
+                {
+                    introspection_reply.send_reply(peer_connection, message);
+                });
+            add_dbus_methods(*peer_methods, loop, peer);
+            peer_methods->register_object_path(*peer, dbus_display_path);
 
-        if (!args_error && std::string{interface} == dbus_display_interface)
-            dbus_properties_GetAll(reply);
+            return peer_methods;
+        });
 
-        dbus_connection_send(connection, reply, nullptr);
-    }
-    else if (dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_METHOD_CALL)
-    {
-         DBusMessageHandle reply{
-             dbus_message_new_error(message, DBUS_ERROR_FAILED, "Not supported")};
+    this->peer_server = peer_server;
+}
 
-        dbus_connection_send(connection, reply, nullptr);
-    }
+void usc::UnityDisplayService::handle_Introspect(DBusMessage* message)
+{
+    introspection_reply.send_reply(*connection, message);
+}
 
-    if (args_error)
-    {
-         DBusMessageHandle reply{
-             dbus_message_new_error(message, DBUS_ERROR_FAILED, "Invalid arguments")};
+void usc::UnityDisplayService::send_signal(DBusMessage* signal)
+{
+    dbus_connection_send(*connection, signal, nullptr);
 
-        dbus_connection_send(connection, reply, nullptr);
-    }
+    if (peer_server)
+        peer_server->send_to_peers(signal);
+}
 
-    return DBUS_HANDLER_RESULT_HANDLED;
+void usc::UnityDisplayService::dbus_TurnOn(std::string const& filter, DBusDeferredReply const& reply)
+{
+    auto const output_filter = output_filter_from_string(filter);
+
+    power_worker.enqueue(
+        [this, output_filter, reply]
+        {
+            screen->turn_on(output_filter);
+            reply.send_return(DBUS_TYPE_INVALID);
+        });
 }
 
-void usc::UnityDisplayService::dbus_TurnOn(std::string const& filter)
+void usc::UnityDisplayService::dbus_TurnOff(std::string const& filter, DBusDeferredReply const& reply)
 {
-    screen->turn_on(output_filter_from_string(filter));
+    auto const output_filter = output_filter_from_string(filter);
+
+    power_worker.enqueue(
+        [this, output_filter, reply]
+        {
+            screen->turn_off(output_filter);
+            reply.send_return(DBUS_TYPE_INVALID);
+        });
 }
 
-void usc::UnityDisplayService::dbus_TurnOff(std::string const& filter)
+std::tuple<int32_t, int32_t> usc::UnityDisplayService::dbus_get_ActiveOutputs()
 {
-    screen->turn_off(output_filter_from_string(filter));
+    return std::make_tuple(active_outputs.internal, active_outputs.external);
 }
 
 void usc::UnityDisplayService::dbus_emit_ActiveOutputs()
 {
-    DBusMessageHandle signal{
-        dbus_message_new_signal(
-            dbus_display_path,
-            "org.freedesktop.DBus.Properties",
-            "PropertiesChanged")};
+    auto const signal =
+        dbus_ActiveOutputs_changed_signal(dbus_display_path, dbus_get_ActiveOutputs());
 
-    DBusMessageIter iter;
-    dbus_message_iter_init_append(signal, &iter);
+    send_signal(signal);
+}
 
-    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &dbus_display_interface);
+std::vector<std::tuple<int32_t, std::string, std::string, int32_t, int32_t, double>>
+    usc::UnityDisplayService::dbus_GetOutputs()
+{
+    std::vector<std::tuple<int32_t, std::string, std::string, int32_t, int32_t, double>> outputs;
 
+    for (auto const& state : output_states)
     {
-        DBusMessageIter iter_dict;
-        dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &iter_dict);
+        outputs.emplace_back(
+            state.id, state.external ? "external" : "internal", power_mode_name(state.power_mode),
+            state.width, state.height, state.refresh_rate);
+    }
 
-        usc_dbus_message_iter_append_active_outputs_dict_entry(&iter_dict, active_outputs);
+    return outputs;
+}
 
-        dbus_message_iter_close_container(&iter, &iter_dict);
-    }
+void usc::UnityDisplayService::dbus_TurnOnOutputs(
+    std::vector<int32_t> const& ids, DBusDeferredReply const& reply)
+{
+    check_output_ids(ids);
+
+    power_worker.enqueue(
+        [this, ids, reply]
+        {
+            screen->turn_on_outputs(ids);
+            reply.send_return(DBUS_TYPE_INVALID);
+        });
+}
+
+void usc::UnityDisplayService::dbus_TurnOffOutputs(
+    std::vector<int32_t> const& ids, DBusDeferredReply const& reply)
+{
+    check_output_ids(ids);
+
+    power_worker.enqueue(
+        [this, ids, reply]
+        {
+            screen->turn_off_outputs(ids);
+            reply.send_return(DBUS_TYPE_INVALID);
+        });
+}
 
+void usc::UnityDisplayService::check_output_ids(std::vector<int32_t> const& ids) const
+{
+    for (auto const id : ids)
     {
-        DBusMessageIter iter_array;
-        dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "s", &iter_array);
-        dbus_message_iter_close_container(&iter, &iter_array);
+        if (!find_output_state(output_states, id))
+        {
+            BOOST_THROW_EXCEPTION(
+                std::invalid_argument("Unknown output: " + std::to_string(id)));
+        }
     }
-
-    dbus_connection_send(*connection, signal, nullptr);
-    dbus_connection_flush(*connection);
 }
 
-void usc::UnityDisplayService::dbus_properties_Get(DBusMessage* reply, std::string const& property)
+void usc::UnityDisplayService::update_output_states(std::vector<OutputState> const& new_output_states)
 {
-    DBusMessageIter iter;
-    dbus_message_iter_init_append(reply, &iter);
+    output_states = new_output_states;
 
-    if (property == "ActiveOutputs")
-        usc_dbus_message_iter_append_active_outputs_variant(&iter, active_outputs);
+    if (output_states_emission_pending)
+        return;
+
+    output_states_emission_pending = true;
+    output_states_emission = loop->enqueue_after(
+        active_outputs_coalescing_window,
+        [this]
+        {
+            output_states_emission_pending = false;
+            emit_output_changes();
+        });
 }
 
-void usc::UnityDisplayService::dbus_properties_GetAll(DBusMessage* reply)
+void usc::UnityDisplayService::emit_output_changes()
 {
-    DBusMessageIter iter;
-    dbus_message_iter_init_append(reply, &iter);
-
+    for (auto const& state : output_states)
     {
-        DBusMessageIter iter_dict;
-        dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &iter_dict);
+        auto const signalled = find_output_state(signalled_output_states, state.id);
+        if (signalled && *signalled == state)
+            continue;
+
+        auto const signal = dbus_OutputChanged_signal(
+            dbus_display_path, state.id, state.external ? "external" : "internal",
+            power_mode_name(state.power_mode), state.width, state.height, state.refresh_rate);
+
+        send_signal(signal);
+    }
 
-        usc_dbus_message_iter_append_active_outputs_dict_entry(&iter_dict, active_outputs);
+    for (auto const& signalled : signalled_output_states)
+    {
+        if (find_output_state(output_states, signalled.id))
+            continue;
 
-        dbus_message_iter_close_container(&iter, &iter_dict);
+        auto const signal = dbus_OutputRemoved_signal(dbus_display_path, signalled.id);
+        send_signal(signal);
     }
+
+    signalled_output_states = output_states;
 }
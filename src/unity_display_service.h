@@ -20,41 +20,104 @@
 #define USC_UNITY_DISPLAY_SERVICE_H_
 
 #include "dbus_connection_handle.h"
+#include "dbus_event_loop.h"
+#include "dbus_message_template.h"
+#include "dbus_method_table.h"
+#include "dbus_rate_limiter.h"
+#include "dbus_worker_pool.h"
 #include "screen.h"
 
+#include "unity_display_service_stubs.h" // autogenerated
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <vector>
 
 namespace usc
 {
+class DBusPeerServer;
 class Screen;
-class DBusEventLoop;
 
-class UnityDisplayService
+class UnityDisplayService : public UnityDisplayServiceStubs
 {
 public:
     UnityDisplayService(
         std::shared_ptr<usc::DBusEventLoop> const& loop,
         std::string const& address,
-        std::shared_ptr<usc::Screen> const& screen);
+        std::shared_ptr<usc::Screen> const& screen,
+        DBusRateLimiter::Limits const& rate_limits = DBusRateLimiter::default_limits);
+    // Serves on connection, which may be shared with other services on loop
+    UnityDisplayService(
+        std::shared_ptr<usc::DBusEventLoop> const& loop,
+        std::shared_ptr<usc::DBusConnectionHandle> const& connection,
+        std::shared_ptr<usc::Screen> const& screen,
+        DBusRateLimiter::Limits const& rate_limits = DBusRateLimiter::default_limits);
     ~UnityDisplayService();
 
+    // Also serves the display interface to the peers of peer_server, and
+    // sends them its signals. Must be called before the loop starts.
+    void serve_peers(std::shared_ptr<DBusPeerServer> const& peer_server);
+
+    // An ActiveOutputs change is signalled straight away, and the changes
+    // within a window of that signal together once the window ends, with
+    // the latest value. Nothing is signalled if the value is the one last
+    // signalled. Every change counts as either emitted or suppressed.
+    static std::chrono::milliseconds const active_outputs_coalescing_window;
+
+    uint64_t active_outputs_signals_emitted() const;
+    uint64_t active_outputs_signals_suppressed() const;
+
+    // OutputChanged and OutputRemoved are sent after the same window, for
+    // the outputs that differ from what was last signalled
+
 private:
-    static ::DBusHandlerResult handle_dbus_message_thunk(
-        DBusConnection* connection, DBusMessage* message, void* user_data);
-    ::DBusHandlerResult handle_dbus_message(
-        DBusConnection* connection, DBusMessage* message, void* user_data);
+    void handle_Introspect(DBusMessage* message);
+    void send_signal(DBusMessage* signal);
 
-    void dbus_TurnOn(std::string const& filter);
-    void dbus_TurnOff(std::string const& filter);
+    void dbus_TurnOn(std::string const& filter, DBusDeferredReply const& reply) override;
+    void dbus_TurnOff(std::string const& filter, DBusDeferredReply const& reply) override;
+    std::tuple<int32_t, int32_t> dbus_get_ActiveOutputs() override;
+    void update_active_outputs(ActiveOutputs const& new_active_outputs);
+    void emit_active_outputs();
     void dbus_emit_ActiveOutputs();
-    void dbus_properties_Get(DBusMessage* reply, std::string const& property);
-    void dbus_properties_GetAll(DBusMessage* reply);
+
+    std::vector<std::tuple<int32_t, std::string, std::string, int32_t, int32_t, double>>
+        dbus_GetOutputs() override;
+    void dbus_TurnOnOutputs(std::vector<int32_t> const& ids, DBusDeferredReply const& reply) override;
+    void dbus_TurnOffOutputs(std::vector<int32_t> const& ids, DBusDeferredReply const& reply) override;
+    void check_output_ids(std::vector<int32_t> const& ids) const;
+    void update_output_states(std::vector<OutputState> const& new_output_states);
+    void emit_output_changes();
 
     std::shared_ptr<usc::Screen> const screen;
     std::shared_ptr<DBusEventLoop> const loop;
     std::shared_ptr<DBusConnectionHandle> connection;
+    std::shared_ptr<DBusPeerServer> peer_server;
+    // Only used on the loop thread
     ActiveOutputs active_outputs;
+    ActiveOutputs signalled_active_outputs;
+    // Open for a window after each ActiveOutputs signal
+    bool active_outputs_window_open;
+    uint64_t active_outputs_changes_pending;
+    DBusEventLoop::DelayedAction active_outputs_emission;
+    std::atomic<uint64_t> active_outputs_emitted;
+    std::atomic<uint64_t> active_outputs_suppressed;
+    std::vector<OutputState> output_states;
+    std::vector<OutputState> signalled_output_states;
+    bool output_states_emission_pending;
+    DBusEventLoop::DelayedAction output_states_emission;
+    DBusMessageTemplate const introspection_reply;
+    DBusMethodTable methods;
+    // Per client limits on the power methods
+    DBusRateLimiter rate_limiter;
+    // Power mode changes reconfigure the display, which can take a while,
+    // so they run here in the order they were called. Last, so that it
+    // stops before the rest of the service goes away.
+    DBusWorkerPool power_worker;
 };
 
 }
@@ -19,134 +19,333 @@
 #include "unity_input_service.h"
 #include "input_configuration.h"
 #include "dbus_message_handle.h"
+#include "dbus_marshalling.h"
 #include "dbus_event_loop.h"
-#include "scoped_dbus_error.h"
+#include "dbus_peer_server.h"
 
 #include "unity_input_service_introspection.h" // autogenerated
 
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+
 namespace
 {
 
-char const* const dbus_input_interface = "com.canonical.Unity.Input";
 char const* const dbus_input_path = "/com/canonical/Unity/Input";
 char const* const dbus_input_service_name = "com.canonical.Unity.Input";
+char const* const dbus_input_interface = "com.canonical.Unity.Input";
+
+char const* const setters[] = {
+    "setMousePrimaryButton",
+    "setMouseCursorSpeed",
+    "setMouseScrollSpeed",
+    "setTouchpadPrimaryButton",
+    "setTouchpadCursorSpeed",
+    "setTouchpadScrollSpeed",
+    "setTouchpadDisableWhileTyping",
+    "setTouchpadTapToClick",
+    "setTouchpadTwoFingerScroll",
+    "setTouchpadDisableWithMouse",
+};
+
+// Calls f(property name, setting) for each of the settings
+template<typename F>
+void for_each_setting(F const& f)
+{
+    f("MousePrimaryButton", &usc::InputSettings::mouse_primary_button);
+    f("MouseCursorSpeed", &usc::InputSettings::mouse_cursor_speed);
+    f("MouseScrollSpeed", &usc::InputSettings::mouse_scroll_speed);
+    f("TouchpadPrimaryButton", &usc::InputSettings::touchpad_primary_button);
+    f("TouchpadCursorSpeed", &usc::InputSettings::touchpad_cursor_speed);
+    f("TouchpadScrollSpeed", &usc::InputSettings::touchpad_scroll_speed);
+    f("TouchpadDisableWhileTyping", &usc::InputSettings::disable_touchpad_while_typing);
+    f("TouchpadTapToClick", &usc::InputSettings::tap_to_click);
+    f("TouchpadTwoFingerScroll", &usc::InputSettings::two_finger_scroll);
+    f("TouchpadDisableWithMouse", &usc::InputSettings::disable_touchpad_with_mouse);
+}
+
+template<typename T>
+bool read_value(DBusMessageIter* value, boost::optional<T>& setting)
+{
+    T read;
+    if (!usc::DBusMarshal<T>::read(value, read))
+        return false;
+
+    setting = read;
+    return true;
+}
+
+// Returns false if the name is unknown or the value has the wrong type
+bool read_setting(std::string const& name, DBusMessageIter* value, usc::InputSettings& settings)
+{
+    bool known{false};
+    bool valid{false};
+
+    for_each_setting(
+        [&] (char const* setting_name, auto setting)
+        {
+            if (known || name != setting_name)
+                return;
+
+            known = true;
+            valid = read_value(value, settings.*setting);
+        });
+
+    return valid;
+}
 
 }
 
 usc::UnityInputService::UnityInputService(std::shared_ptr<usc::DBusEventLoop> const& loop,
                                           std::string const& address,
-                                          std::shared_ptr<usc::InputConfiguration> const& input_config)
-    : loop{loop}, connection{std::make_shared<DBusConnectionHandle>(address.c_str())}, input_config{input_config}
+                                          std::shared_ptr<usc::InputConfiguration> const& input_config,
+                                          DBusRateLimiter::Limits const& rate_limits)
+    : UnityInputService{
+          loop, std::make_shared<DBusConnectionHandle>(address.c_str()), input_config, rate_limits}
+{
+}
+
+usc::UnityInputService::UnityInputService(std::shared_ptr<usc::DBusEventLoop> const& loop,
+                                          std::shared_ptr<usc::DBusConnectionHandle> const& connection,
+                                          std::shared_ptr<usc::InputConfiguration> const& input_config,
+                                          DBusRateLimiter::Limits const& rate_limits)
+    : loop{loop},
+      connection{connection},
+      input_config{input_config},
+      settings{input_config->current_settings()},
+      introspection_reply{
+          DBusMessageTemplate::method_return(
+              DBUS_TYPE_STRING, &unity_input_service_introspection,
+              DBUS_TYPE_INVALID)},
+      rate_limiter{loop, connection, rate_limits}
 {
+    methods.add(
+        "org.freedesktop.DBus.Introspectable", "Introspect",
+        [this] (DBusMessage* message) { handle_Introspect(message); });
+    add_dbus_methods(methods, loop, connection);
+
+    // Each setter sets one value, so a client setting it faster than its
+    // limit (a slider, say) only needs the latest value applied. A partial
+    // configuration can't stand in for an earlier one, so it isn't merged.
+    for (auto const setter : setters)
+        rate_limiter.limit(methods, dbus_input_interface, setter, DBusRateLimiter::Excess::coalesce);
+    rate_limiter.limit(
+        methods, dbus_input_interface, "SetConfiguration", DBusRateLimiter::Excess::reject);
+    loop->stats().add_methods(methods);
+    methods.register_object_path(*connection, dbus_input_path);
+
     loop->add_connection(connection);
     connection->request_name(dbus_input_service_name);
-    connection->add_filter(handle_dbus_message_thunk, this);
 }
 
-::DBusHandlerResult usc::UnityInputService::handle_dbus_message_thunk(
-    ::DBusConnection* connection, DBusMessage* message, void* user_data)
+void usc::UnityInputService::serve_peers(std::shared_ptr<DBusPeerServer> const& peer_server)
 {
-    auto const dbus_input_service = static_cast<usc::UnityInputService*>(user_data);
-    return dbus_input_service->handle_dbus_message(connection, message, user_data);
+    peer_server->serve(loop,
+        [this] (std::shared_ptr<DBusConnectionHandle> const& peer) -> std::shared_ptr<void>
+        {
+            // Peers are let in by uid, and have no sender to limit, so
+            // their calls aren't rate limited
+            auto const peer_methods = std::make_shared<DBusMethodTable>();
+            DBusConnection* const peer_connection = *peer;
+
+            peer_methods->add(
+                "org.freedesktop.DBus.Introspectable", "Introspect",
+                [this, peer_connection] (DBusMessage* message)
+                {
+                    introspection_reply.send_reply(peer_connection, message);
+                });
+            add_dbus_methods(*peer_methods, loop, peer);
+            peer_methods->register_object_path(*peer, dbus_input_path);
+
+            return peer_methods;
+        });
+
+    this->peer_server = peer_server;
 }
 
-void usc::UnityInputService::handle_message(DBusMessage* message, void (usc::InputConfiguration::* method)(bool))
+void usc::UnityInputService::handle_Introspect(DBusMessage* message)
 {
-    ScopedDBusError args_error;
-    dbus_bool_t flag{true};
-    dbus_message_get_args(
-        message, &args_error, DBUS_TYPE_BOOLEAN, &flag, DBUS_TYPE_INVALID);
+    introspection_reply.send_reply(*connection, message);
+}
 
-    if (!args_error)
-    {
-        (input_config.get()->*method)(flag);
+void usc::UnityInputService::send_signal(DBusMessage* signal)
+{
+    dbus_connection_send(*connection, signal, nullptr);
 
-        DBusMessageHandle reply{dbus_message_new_method_return(message)};
-        dbus_connection_send(*connection, reply, nullptr);
-    }
+    if (peer_server)
+        peer_server->send_to_peers(signal);
 }
 
-void usc::UnityInputService::handle_message(DBusMessage* message, void (usc::InputConfiguration::* method)(double))
+void usc::UnityInputService::dbus_setMousePrimaryButton(int32_t button)
 {
-    ScopedDBusError args_error;
-    double value{true};
-    dbus_message_get_args(
-        message, &args_error, DBUS_TYPE_DOUBLE, &value, DBUS_TYPE_INVALID);
+    input_config->set_mouse_primary_button(button);
+    update_settings();
+}
 
-    if (!args_error)
-    {
-        (input_config.get()->*method)(value);
+void usc::UnityInputService::dbus_setMouseCursorSpeed(double speed)
+{
+    input_config->set_mouse_cursor_speed(speed);
+    update_settings();
+}
 
-        DBusMessageHandle reply{dbus_message_new_method_return(message)};
-        dbus_connection_send(*connection, reply, nullptr);
-    }
+void usc::UnityInputService::dbus_setMouseScrollSpeed(double speed)
+{
+    input_config->set_mouse_scroll_speed(speed);
+    update_settings();
 }
 
-void usc::UnityInputService::handle_message(DBusMessage* message, void (usc::InputConfiguration::* method)(int32_t))
+void usc::UnityInputService::dbus_setTouchpadPrimaryButton(int32_t button)
 {
-    ScopedDBusError args_error;
-    int32_t value{true};
-    dbus_message_get_args(
-        message, &args_error, DBUS_TYPE_INT32, &value, DBUS_TYPE_INVALID);
+    input_config->set_touchpad_primary_button(button);
+    update_settings();
+}
 
-    if (!args_error)
-    {
-        (input_config.get()->*method)(value);
+void usc::UnityInputService::dbus_setTouchpadCursorSpeed(double speed)
+{
+    input_config->set_touchpad_cursor_speed(speed);
+    update_settings();
+}
 
-        DBusMessageHandle reply{dbus_message_new_method_return(message)};
-        dbus_connection_send(*connection, reply, nullptr);
-    }
+void usc::UnityInputService::dbus_setTouchpadScrollSpeed(double speed)
+{
+    input_config->set_touchpad_scroll_speed(speed);
+    update_settings();
 }
 
-DBusHandlerResult usc::UnityInputService::handle_dbus_message(
-    ::DBusConnection* connection, DBusMessage* message, void* user_data)
+void usc::UnityInputService::dbus_setTouchpadDisableWhileTyping(bool enable)
 {
-    ScopedDBusError args_error;
+    input_config->set_disable_touchpad_while_typing(enable);
+    update_settings();
+}
 
-    if (dbus_message_is_method_call(message, "org.freedesktop.DBus.Introspectable", "Introspect"))
-    {
-        DBusMessageHandle reply{
-            dbus_message_new_method_return(message),
-            DBUS_TYPE_STRING, &unity_input_service_introspection,
-            DBUS_TYPE_INVALID};
+void usc::UnityInputService::dbus_setTouchpadTapToClick(bool enable)
+{
+    input_config->set_tap_to_click(enable);
+    update_settings();
+}
 
-        dbus_connection_send(connection, reply, nullptr);
-    }
-    else if (dbus_message_is_method_call(message, dbus_input_interface, "setMousePrimaryButton"))
-        handle_message(message, &InputConfiguration::set_mouse_primary_button);
-    else if (dbus_message_is_method_call(message, dbus_input_interface, "setMouseCursorSpeed"))
-        handle_message(message, &InputConfiguration::set_mouse_cursor_speed);
-    else if (dbus_message_is_method_call(message, dbus_input_interface, "setMouseScrollSpeed"))
-        handle_message(message, &InputConfiguration::set_mouse_scroll_speed);
-    else if (dbus_message_is_method_call(message, dbus_input_interface, "setTouchpadPrimaryButton"))
-        handle_message(message, &InputConfiguration::set_touchpad_primary_button);
-    else if (dbus_message_is_method_call(message, dbus_input_interface, "setTouchpadCursorSpeed"))
-        handle_message(message, &InputConfiguration::set_touchpad_cursor_speed);
-    else if (dbus_message_is_method_call(message, dbus_input_interface, "setTouchpadScrollSpeed"))
-        handle_message(message, &InputConfiguration::set_touchpad_scroll_speed);
-    else if (dbus_message_is_method_call(message, dbus_input_interface, "setTouchpadDisableWhileTyping"))
-        handle_message(message, &InputConfiguration::set_disable_touchpad_while_typing);
-    else if (dbus_message_is_method_call(message, dbus_input_interface, "setTouchpadTapToClick"))
-        handle_message(message, &InputConfiguration::set_tap_to_click);
-    else if (dbus_message_is_method_call(message, dbus_input_interface, "setTouchpadTwoFingerScroll"))
-        handle_message(message, &InputConfiguration::set_two_finger_scroll);
-    else if (dbus_message_is_method_call(message, dbus_input_interface, "setTouchpadDisableWithMouse"))
-        handle_message(message, &InputConfiguration::set_disable_touchpad_with_mouse);
-    else if (dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_METHOD_CALL)
-    {
-         DBusMessageHandle reply{
-             dbus_message_new_error(message, DBUS_ERROR_FAILED, "Not supported")};
+void usc::UnityInputService::dbus_setTouchpadTwoFingerScroll(bool enable)
+{
+    input_config->set_two_finger_scroll(enable);
+    update_settings();
+}
 
-        dbus_connection_send(connection, reply, nullptr);
-    }
+void usc::UnityInputService::dbus_setTouchpadDisableWithMouse(bool enable)
+{
+    input_config->set_disable_touchpad_with_mouse(enable);
+    update_settings();
+}
 
-    if (args_error)
-    {
-         DBusMessageHandle reply{
-             dbus_message_new_error(message, DBUS_ERROR_FAILED, "Invalid arguments")};
+void usc::UnityInputService::dbus_SetConfiguration(DBusVariantDict const& configuration)
+{
+    InputSettings settings;
+    std::string invalid_setting;
+
+    // Read everything before changing anything
+    auto const valid = configuration.for_each(
+        [&] (char const* name, DBusMessageIter* value)
+        {
+            if (read_setting(name, value, settings))
+                return true;
+
+            invalid_setting = name;
+            return false;
+        });
 
-        dbus_connection_send(connection, reply, nullptr);
+    if (!valid)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::invalid_argument("Unknown setting or wrong type: " + invalid_setting));
     }
 
-    return DBUS_HANDLER_RESULT_HANDLED;
+    input_config->apply_settings(settings);
+    update_settings();
+}
+
+int32_t usc::UnityInputService::dbus_get_MousePrimaryButton()
+{
+    return settings.mouse_primary_button.value_or(0);
+}
+
+double usc::UnityInputService::dbus_get_MouseCursorSpeed()
+{
+    return settings.mouse_cursor_speed.value_or(0.0);
+}
+
+double usc::UnityInputService::dbus_get_MouseScrollSpeed()
+{
+    return settings.mouse_scroll_speed.value_or(0.0);
+}
+
+int32_t usc::UnityInputService::dbus_get_TouchpadPrimaryButton()
+{
+    return settings.touchpad_primary_button.value_or(0);
+}
+
+double usc::UnityInputService::dbus_get_TouchpadCursorSpeed()
+{
+    return settings.touchpad_cursor_speed.value_or(0.0);
+}
+
+double usc::UnityInputService::dbus_get_TouchpadScrollSpeed()
+{
+    return settings.touchpad_scroll_speed.value_or(0.0);
+}
+
+bool usc::UnityInputService::dbus_get_TouchpadDisableWhileTyping()
+{
+    return settings.disable_touchpad_while_typing.value_or(false);
+}
+
+bool usc::UnityInputService::dbus_get_TouchpadTapToClick()
+{
+    return settings.tap_to_click.value_or(false);
+}
+
+bool usc::UnityInputService::dbus_get_TouchpadTwoFingerScroll()
+{
+    return settings.two_finger_scroll.value_or(false);
+}
+
+bool usc::UnityInputService::dbus_get_TouchpadDisableWithMouse()
+{
+    return settings.disable_touchpad_with_mouse.value_or(false);
+}
+
+void usc::UnityInputService::update_settings()
+{
+    auto const old_settings = settings;
+    settings = input_config->current_settings();
+
+    bool changed{false};
+    for_each_setting(
+        [&] (char const*, auto setting)
+        {
+            if (settings.*setting != old_settings.*setting)
+                changed = true;
+        });
+
+    if (!changed)
+        return;
+
+    dbus_properties_changed();
+
+    // One signal for everything that changed, so that SetConfiguration
+    // doesn't wake listeners once per setting
+    auto const signal =
+        dbus_properties_changed_signal(
+            dbus_input_path, dbus_input_interface,
+            [this, &old_settings] (DBusMessageIter* iter_dict)
+            {
+                for_each_setting(
+                    [&] (char const* name, auto setting)
+                    {
+                        using Setting = typename std::decay_t<decltype(settings.*setting)>::value_type;
+                        auto const& value = settings.*setting;
+                        if (value != old_settings.*setting)
+                            dbus_append_property(iter_dict, name, value.value_or(Setting{}));
+                    });
+            });
+
+    send_signal(signal);
 }
@@ -21,34 +21,78 @@
 
 #include <dbus/dbus.h>
 #include "dbus_connection_handle.h"
+#include "dbus_message_template.h"
+#include "dbus_method_table.h"
+#include "dbus_rate_limiter.h"
+#include "input_configuration.h"
 #include <memory>
 
+#include "unity_input_service_stubs.h" // autogenerated
+
 namespace usc
 {
 class DBusEventLoop;
-class InputConfiguration;
+class DBusPeerServer;
 
-class UnityInputService
+class UnityInputService : public UnityInputServiceStubs
 {
 public:
     UnityInputService(
         std::shared_ptr<usc::DBusEventLoop> const& loop,
         std::string const& address,
-        std::shared_ptr<usc::InputConfiguration> const& input_config);
+        std::shared_ptr<usc::InputConfiguration> const& input_config,
+        DBusRateLimiter::Limits const& rate_limits = DBusRateLimiter::default_limits);
+    // Serves on connection, which may be shared with other services on loop
+    UnityInputService(
+        std::shared_ptr<usc::DBusEventLoop> const& loop,
+        std::shared_ptr<usc::DBusConnectionHandle> const& connection,
+        std::shared_ptr<usc::InputConfiguration> const& input_config,
+        DBusRateLimiter::Limits const& rate_limits = DBusRateLimiter::default_limits);
+
+    // Also serves the input interface to the peers of peer_server, and
+    // sends them its signals. Must be called before the loop starts.
+    void serve_peers(std::shared_ptr<DBusPeerServer> const& peer_server);
 
 private:
-    static ::DBusHandlerResult handle_dbus_message_thunk(
-        DBusConnection* connection, DBusMessage* message, void* user_data);
-    ::DBusHandlerResult handle_dbus_message(
-        DBusConnection* connection, DBusMessage* message, void* user_data);
+    void handle_Introspect(DBusMessage* message);
+    void send_signal(DBusMessage* signal);
+
+    void dbus_setMousePrimaryButton(int32_t button) override;
+    void dbus_setMouseCursorSpeed(double speed) override;
+    void dbus_setMouseScrollSpeed(double speed) override;
+    void dbus_setTouchpadPrimaryButton(int32_t button) override;
+    void dbus_setTouchpadCursorSpeed(double speed) override;
+    void dbus_setTouchpadScrollSpeed(double speed) override;
+    void dbus_setTouchpadDisableWhileTyping(bool enable) override;
+    void dbus_setTouchpadTapToClick(bool enable) override;
+    void dbus_setTouchpadTwoFingerScroll(bool enable) override;
+    void dbus_setTouchpadDisableWithMouse(bool enable) override;
+    void dbus_SetConfiguration(DBusVariantDict const& configuration) override;
+
+    int32_t dbus_get_MousePrimaryButton() override;
+    double dbus_get_MouseCursorSpeed() override;
+    double dbus_get_MouseScrollSpeed() override;
+    int32_t dbus_get_TouchpadPrimaryButton() override;
+    double dbus_get_TouchpadCursorSpeed() override;
+    double dbus_get_TouchpadScrollSpeed() override;
+    bool dbus_get_TouchpadDisableWhileTyping() override;
+    bool dbus_get_TouchpadTapToClick() override;
+    bool dbus_get_TouchpadTwoFingerScroll() override;
+    bool dbus_get_TouchpadDisableWithMouse() override;
 
-    void handle_message(DBusMessage* message, void (usc::InputConfiguration::* method)(bool));
-    void handle_message(DBusMessage* message, void (usc::InputConfiguration::* method)(int32_t));
-    void handle_message(DBusMessage* message, void (usc::InputConfiguration::* method)(double));
+    // Refreshes the cached settings and signals the ones that changed
+    void update_settings();
 
     std::shared_ptr<usc::DBusEventLoop> const loop;
     std::shared_ptr<usc::DBusConnectionHandle> connection;
+    std::shared_ptr<usc::DBusPeerServer> peer_server;
     std::shared_ptr<usc::InputConfiguration> const input_config;
+    // The properties are served from here. Only used on the loop thread.
+    InputSettings settings;
+    DBusMessageTemplate const introspection_reply;
+    DBusMethodTable methods;
+    // Per client limits on the setters
+    DBusRateLimiter rate_limiter;
 };
 
 }
@@ -15,7 +15,9 @@
  */
 
 #include "unity_power_button_event_sink.h"
+#include "dbus_event_loop.h"
 #include "dbus_message_handle.h"
+#include "dbus_peer_server.h"
 
 namespace
 {
@@ -26,31 +28,55 @@ char const* const unity_power_button_iface = "com.canonical.Unity.PowerButton";
 
 usc::UnityPowerButtonEventSink::UnityPowerButtonEventSink(
     std::string const& dbus_address)
-    : dbus_connection{dbus_address}
+    : UnityPowerButtonEventSink{std::make_shared<DBusConnectionHandle>(dbus_address)}
 {
-    dbus_connection.request_name(unity_power_button_name);
 }
 
-void usc::UnityPowerButtonEventSink::notify_press()
+usc::UnityPowerButtonEventSink::UnityPowerButtonEventSink(
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection)
+    : UnityPowerButtonEventSink{dbus_connection, nullptr}
 {
-    DBusMessageHandle signal{
-        dbus_message_new_signal(
-            unity_power_button_path,
-            unity_power_button_iface,
-            "Press")};
+}
 
-    dbus_connection_send(dbus_connection, signal, nullptr);
-    dbus_connection_flush(dbus_connection);
+usc::UnityPowerButtonEventSink::UnityPowerButtonEventSink(
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<DBusEventLoop> const& dbus_loop)
+    : dbus_connection{dbus_connection},
+      dbus_loop{dbus_loop}
+{
+    dbus_connection->request_name(unity_power_button_name);
+}
+
+void usc::UnityPowerButtonEventSink::serve_peers(std::shared_ptr<DBusPeerServer> const& peer_server)
+{
+    this->peer_server = peer_server;
+}
+
+void usc::UnityPowerButtonEventSink::notify_press()
+{
+    send_signal("Press");
 }
 
 void usc::UnityPowerButtonEventSink::notify_release()
+{
+    send_signal("Release");
+}
+
+void usc::UnityPowerButtonEventSink::send_signal(char const* name)
 {
     DBusMessageHandle signal{
         dbus_message_new_signal(
             unity_power_button_path,
             unity_power_button_iface,
-            "Release")};
+            name)};
+
+    dbus_connection_send(*dbus_connection, signal, nullptr);
+
+    // Queuing the signal wakes the loop driving the connection, which
+    // writes it; flushing from this thread would contend with the loop
+    if (!dbus_loop)
+        dbus_connection_flush(*dbus_connection);
 
-    dbus_connection_send(dbus_connection, signal, nullptr);
-    dbus_connection_flush(dbus_connection);
+    if (peer_server)
+        peer_server->send_to_peers(signal);
 }
@@ -20,19 +20,39 @@
 #include "power_button_event_sink.h"
 #include "dbus_connection_handle.h"
 
+#include <memory>
+#include <string>
+
 namespace usc
 {
+class DBusEventLoop;
+class DBusPeerServer;
 
 class UnityPowerButtonEventSink : public PowerButtonEventSink
 {
 public:
     UnityPowerButtonEventSink(std::string const& dbus_address);
+    // Signals on dbus_connection, which the sink has to itself
+    UnityPowerButtonEventSink(std::shared_ptr<DBusConnectionHandle> const& dbus_connection);
+    // Signals on dbus_connection, which dbus_loop drives and may share with
+    // other services. The loop writes the signals out.
+    UnityPowerButtonEventSink(
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<DBusEventLoop> const& dbus_loop);
+
+    // Also signals to the peers of peer_server. Must be called before any
+    // events arrive.
+    void serve_peers(std::shared_ptr<DBusPeerServer> const& peer_server);
 
     void notify_press() override;
     void notify_release() override;
 
 private:
-    DBusConnectionHandle dbus_connection;
+    void send_signal(char const* name);
+
+    std::shared_ptr<DBusConnectionHandle> const dbus_connection;
+    std::shared_ptr<DBusEventLoop> const dbus_loop;
+    std::shared_ptr<DBusPeerServer> peer_server;
 };
 
 }
@@ -16,52 +16,81 @@
 
 #include "unity_user_activity_event_sink.h"
 #include "unity_user_activity_type.h"
+#include "dbus_event_loop.h"
 #include "dbus_message_handle.h"
+#include "dbus_peer_server.h"
 
 namespace
 {
 char const* const unity_user_activity_name = "com.canonical.Unity.UserActivity";
 char const* const unity_user_activity_path = "/com/canonical/Unity/UserActivity";
 char const* const unity_user_activity_iface = "com.canonical.Unity.UserActivity";
+
+usc::DBusMessageTemplate activity_signal(usc::UnityUserActivityType type)
+{
+    int const activity_type = static_cast<int>(type);
+
+    usc::DBusMessageHandle signal{
+        dbus_message_new_signal(
+            unity_user_activity_path,
+            unity_user_activity_iface,
+            "Activity"),
+        DBUS_TYPE_INT32, &activity_type,
+        DBUS_TYPE_INVALID};
+
+    return usc::DBusMessageTemplate{signal};
+}
 }
 
 usc::UnityUserActivityEventSink::UnityUserActivityEventSink(
     std::string const& dbus_address)
-    : dbus_connection{dbus_address}
+    : UnityUserActivityEventSink{std::make_shared<DBusConnectionHandle>(dbus_address)}
 {
-    dbus_connection.request_name(unity_user_activity_name);
 }
 
-void usc::UnityUserActivityEventSink::notify_activity_changing_power_state()
+usc::UnityUserActivityEventSink::UnityUserActivityEventSink(
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection)
+    : UnityUserActivityEventSink{dbus_connection, nullptr}
 {
-    int const changing_power_state =
-        static_cast<int>(UnityUserActivityType::changing_power_state);
+}
 
-    DBusMessageHandle signal{
-        dbus_message_new_signal(
-            unity_user_activity_path,
-            unity_user_activity_iface,
-            "Activity"),
-        DBUS_TYPE_INT32, &changing_power_state,
-        DBUS_TYPE_INVALID};
+usc::UnityUserActivityEventSink::UnityUserActivityEventSink(
+    std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+    std::shared_ptr<DBusEventLoop> const& dbus_loop)
+    : dbus_connection{dbus_connection},
+      dbus_loop{dbus_loop},
+      changing_power_state_signal{activity_signal(UnityUserActivityType::changing_power_state)},
+      extending_power_state_signal{activity_signal(UnityUserActivityType::extending_power_state)}
+{
+    dbus_connection->request_name(unity_user_activity_name);
+}
 
-    dbus_connection_send(dbus_connection, signal, nullptr);
-    dbus_connection_flush(dbus_connection);
+void usc::UnityUserActivityEventSink::serve_peers(std::shared_ptr<DBusPeerServer> const& peer_server)
+{
+    this->peer_server = peer_server;
+}
+
+void usc::UnityUserActivityEventSink::notify_activity_changing_power_state()
+{
+    send_signal(changing_power_state_signal);
 }
 
 void usc::UnityUserActivityEventSink::notify_activity_extending_power_state()
 {
-    int const extending_power_state =
-        static_cast<int>(UnityUserActivityType::extending_power_state);
+    send_signal(extending_power_state_signal);
+}
 
-    DBusMessageHandle signal{
-        dbus_message_new_signal(
-            unity_user_activity_path,
-            unity_user_activity_iface,
-            "Activity"),
-        DBUS_TYPE_INT32, &extending_power_state,
-        DBUS_TYPE_INVALID};
+void usc::UnityUserActivityEventSink::send_signal(DBusMessageTemplate const& signal_template)
+{
+    auto const signal = signal_template.instantiate();
+
+    dbus_connection_send(*dbus_connection, signal, nullptr);
+
+    // Queuing the signal wakes the loop driving the connection, which
+    // writes it; flushing from this thread would contend with the loop
+    if (!dbus_loop)
+        dbus_connection_flush(*dbus_connection);
 
-    dbus_connection_send(dbus_connection, signal, nullptr);
-    dbus_connection_flush(dbus_connection);
+    if (peer_server)
+        peer_server->send_to_peers(signal);
 }
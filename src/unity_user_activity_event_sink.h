@@ -19,20 +19,43 @@
 
 #include "user_activity_event_sink.h"
 #include "dbus_connection_handle.h"
+#include "dbus_message_template.h"
+
+#include <memory>
+#include <string>
 
 namespace usc
 {
+class DBusEventLoop;
+class DBusPeerServer;
 
 class UnityUserActivityEventSink : public UserActivityEventSink
 {
 public:
     UnityUserActivityEventSink(std::string const& dbus_address);
+    // Signals on dbus_connection, which the sink has to itself
+    UnityUserActivityEventSink(std::shared_ptr<DBusConnectionHandle> const& dbus_connection);
+    // Signals on dbus_connection, which dbus_loop drives and may share with
+    // other services. The loop writes the signals out.
+    UnityUserActivityEventSink(
+        std::shared_ptr<DBusConnectionHandle> const& dbus_connection,
+        std::shared_ptr<DBusEventLoop> const& dbus_loop);
+
+    // Also signals to the peers of peer_server. Must be called before any
+    // events arrive.
+    void serve_peers(std::shared_ptr<DBusPeerServer> const& peer_server);
 
     void notify_activity_changing_power_state() override;
     void notify_activity_extending_power_state() override;
 
 private:
-    DBusConnectionHandle dbus_connection;
+    void send_signal(DBusMessageTemplate const& signal_template);
+
+    std::shared_ptr<DBusConnectionHandle> const dbus_connection;
+    std::shared_ptr<DBusEventLoop> const dbus_loop;
+    std::shared_ptr<DBusPeerServer> peer_server;
+    DBusMessageTemplate const changing_power_state_signal;
+    DBusMessageTemplate const extending_power_state_signal;
 };
 
 }
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/epoll_event_loop_backend.h"
+#include "src/io_uring_event_loop_backend.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+
+struct RoundTrips
+{
+    int count;
+    uint64_t backend_syscalls;
+    std::chrono::nanoseconds duration;
+};
+
+// Replays what DBusEventLoop asks of its backend for a method call: a
+// client wakes the loop through the eventfd (an enqueued action) and sends
+// a request; the loop reads it, enables its write watch, writes the reply
+// once the socket is writable, and disables the write watch again.
+RoundTrips time_round_trips(usc::DBusEventLoopBackend& backend, int count)
+{
+    int sockets[2];
+    EXPECT_THAT(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sockets), testing::Eq(0));
+    int const wake_up_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    int const loop_socket = sockets[0];
+    int const client_socket = sockets[1];
+
+    backend.add_counter_fd(wake_up_fd);
+    backend.add(loop_socket, EPOLLIN);
+
+    std::thread client{
+        [&]
+        {
+            char byte{0};
+            uint64_t const one{1};
+
+            for (int i = 0; i < count; ++i)
+            {
+                if (write(wake_up_fd, &one, sizeof one));
+                if (write(client_socket, &byte, 1));
+
+                while (read(client_socket, &byte, 1) != 1)
+                    std::this_thread::yield();
+            }
+        }};
+
+    auto const syscalls_before = backend.syscalls();
+    auto const start = std::chrono::steady_clock::now();
+
+    epoll_event events[4];
+    int replies{0};
+    bool reply_pending{false};
+
+    while (replies < count)
+    {
+        int const n = backend.wait(events, 4, -1);
+
+        for (int i = 0; i < n; ++i)
+        {
+            if (events[i].data.fd != loop_socket)
+                continue;
+
+            char byte;
+            if ((events[i].events & EPOLLIN) && read(loop_socket, &byte, 1) == 1)
+            {
+                reply_pending = true;
+                backend.modify(loop_socket, EPOLLIN | EPOLLOUT);
+            }
+            else if ((events[i].events & EPOLLOUT) && reply_pending)
+            {
+                if (write(loop_socket, &byte, 1));
+                reply_pending = false;
+                ++replies;
+                backend.modify(loop_socket, EPOLLIN);
+            }
+        }
+    }
+
+    auto const duration = std::chrono::steady_clock::now() - start;
+    auto const syscalls = backend.syscalls() - syscalls_before;
+
+    client.join();
+    backend.remove(loop_socket);
+    backend.stop_waiting();
+    close(sockets[0]);
+    close(sockets[1]);
+    close(wake_up_fd);
+
+    return {count, syscalls, duration};
+}
+
+void report(char const* name, RoundTrips const& round_trips)
+{
+    std::cout << "    " << name << ": "
+              << static_cast<double>(round_trips.backend_syscalls) / round_trips.count
+              << " backend syscalls/round trip, "
+              << round_trips.duration.count() / round_trips.count << " ns/round trip"
+              << std::endl;
+}
+
+}
+
+TEST(DBusEventLoopBackendBenchmark, syscalls_per_round_trip_with_epoll_versus_io_uring)
+{
+    int const round_trips = 20000;
+
+    usc::EpollEventLoopBackend epoll_backend;
+    report("epoll   ", time_round_trips(epoll_backend, round_trips));
+
+    std::unique_ptr<usc::IoUringEventLoopBackend> io_uring_backend;
+    try
+    {
+        io_uring_backend.reset(new usc::IoUringEventLoopBackend{nullptr});
+    }
+    catch (std::system_error const& error)
+    {
+        std::cout << "    io_uring: not supported (" << error.what() << ")" << std::endl;
+        return;
+    }
+
+    report("io_uring", time_round_trips(*io_uring_backend, round_trips));
+}
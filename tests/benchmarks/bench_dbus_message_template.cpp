@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/dbus_message_template.h"
+#include "src/dbus_message_handle.h"
+#include "src/unity_display_service_introspection.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+namespace
+{
+
+char const* const activity_path = "/com/canonical/Unity/UserActivity";
+char const* const activity_iface = "com.canonical.Unity.UserActivity";
+
+std::chrono::nanoseconds time_messages(
+    int iterations, std::function<usc::DBusMessageHandle()> const& make_message)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        auto const message = make_message();
+        EXPECT_TRUE(message);
+    }
+
+    return std::chrono::steady_clock::now() - start;
+}
+
+void report(char const* name, int iterations, std::chrono::nanoseconds duration)
+{
+    std::cout << "    " << name << ": "
+              << duration.count() / static_cast<double>(iterations) << " ns/message"
+              << std::endl;
+}
+
+}
+
+TEST(DBusMessageTemplateBenchmark, activity_signal_versus_marshalling_per_event)
+{
+    int const iterations = 200000;
+    int32_t const activity{1};
+
+    usc::DBusMessageHandle const signal{
+        dbus_message_new_signal(activity_path, activity_iface, "Activity"),
+        DBUS_TYPE_INT32, &activity,
+        DBUS_TYPE_INVALID};
+    usc::DBusMessageTemplate const signal_template{signal};
+
+    report("marshalled per event", iterations,
+        time_messages(iterations,
+            [&]
+            {
+                return usc::DBusMessageHandle{
+                    dbus_message_new_signal(activity_path, activity_iface, "Activity"),
+                    DBUS_TYPE_INT32, &activity,
+                    DBUS_TYPE_INVALID};
+            }));
+    report("template            ", iterations,
+        time_messages(iterations, [&] { return signal_template.instantiate(); }));
+}
+
+TEST(DBusMessageTemplateBenchmark, introspection_reply_versus_marshalling_per_call)
+{
+    int const iterations = 50000;
+
+    usc::DBusMessageHandle const call{
+        dbus_message_new_method_call(
+            nullptr, "/com/canonical/Unity/Display",
+            "org.freedesktop.DBus.Introspectable", "Introspect")};
+    dbus_message_set_serial(call, 1);
+    dbus_message_set_sender(call, ":1.1");
+
+    auto const reply_template = usc::DBusMessageTemplate::method_return(
+        DBUS_TYPE_STRING, &unity_display_service_introspection,
+        DBUS_TYPE_INVALID);
+
+    report("marshalled per call", iterations,
+        time_messages(iterations,
+            [&]
+            {
+                return usc::DBusMessageHandle{
+                    dbus_message_new_method_return(call),
+                    DBUS_TYPE_STRING, &unity_display_service_introspection,
+                    DBUS_TYPE_INVALID};
+            }));
+    report("template           ", iterations,
+        time_messages(iterations, [&] { return reply_template.instantiate_reply(call); }));
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/dbus_peer_server.h"
+#include "src/unity_display_service.h"
+#include "src/dbus_connection_handle.h"
+#include "src/dbus_connection_thread.h"
+#include "src/dbus_event_loop.h"
+#include "src/dbus_message_handle.h"
+#include "src/scoped_dbus_error.h"
+
+#include "tests/integration-tests/dbus_bus.h"
+#include "usc/test/mock_screen.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+char const* const display_destination = "com.canonical.Unity.Display";
+char const* const display_path = "/com/canonical/Unity/Display";
+char const* const display_interface = "com.canonical.Unity.Display";
+
+// The median round trip of a TurnOn call. Calls to a peer have no
+// destination.
+std::chrono::nanoseconds median_turn_on_time(
+    usc::DBusConnectionHandle const& connection, char const* destination, int calls)
+{
+    std::vector<std::chrono::nanoseconds> times;
+
+    for (int i = 0; i < calls; ++i)
+    {
+        usc::DBusMessageHandle call{
+            dbus_message_new_method_call(
+                destination, display_path, display_interface, "TurnOn")};
+
+        auto const start = std::chrono::steady_clock::now();
+
+        usc::ScopedDBusError error;
+        usc::DBusMessageHandle reply{
+            dbus_connection_send_with_reply_and_block(connection, call, 3000, &error)};
+        if (!reply)
+            throw std::runtime_error("TurnOn: " + error.message_str());
+
+        times.push_back(std::chrono::steady_clock::now() - start);
+    }
+
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+void report(char const* name, std::chrono::nanoseconds duration)
+{
+    std::cout << "    " << name << ": "
+              << std::chrono::duration_cast<std::chrono::microseconds>(duration).count()
+              << " us/call (median)"
+              << std::endl;
+}
+
+}
+
+TEST(DBusPeerServerBenchmark, bus_versus_peer_to_peer_calls)
+{
+    int const calls = 1000;
+    usc::test::DBusBus bus;
+
+    auto const screen = std::make_shared<testing::NiceMock<usc::test::MockScreen>>();
+    auto const loop = std::make_shared<usc::DBusEventLoop>();
+    auto const peer_server = std::make_shared<usc::DBusPeerServer>(
+        loop, "unix:tmpdir=/tmp", std::vector<uid_t>{});
+    // Unlimited, so that the bus and peer calls do the same work
+    usc::UnityDisplayService service{
+        loop, bus.address(), screen, usc::DBusRateLimiter::Limits{0, 0}};
+    service.serve_peers(peer_server);
+    auto const loop_thread = std::make_shared<usc::DBusConnectionThread>(loop);
+
+    usc::DBusConnectionHandle bus_client{bus.address()};
+    usc::DBusConnectionHandle peer_client{
+        peer_server->address(), usc::DBusConnectionHandle::Registration::peer};
+
+    // Warm up both paths
+    median_turn_on_time(bus_client, display_destination, 10);
+    median_turn_on_time(peer_client, nullptr, 10);
+
+    report("through the bus", median_turn_on_time(bus_client, display_destination, calls));
+    report("peer-to-peer   ", median_turn_on_time(peer_client, nullptr, calls));
+}
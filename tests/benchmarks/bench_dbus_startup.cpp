@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/dbus_connection_handle.h"
+
+#include "tests/integration-tests/dbus_bus.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+// The names USC owns at startup
+std::vector<char const*> const service_names{
+    "com.canonical.Unity.Display",
+    "com.canonical.Unity.Input",
+    "com.canonical.Unity.Debug",
+    "com.canonical.Unity.PowerButton",
+    "com.canonical.Unity.UserActivity"};
+
+using Registration = usc::DBusConnectionHandle::Registration;
+
+// Brings up one connection per name, or one for all of them, the way the
+// server does, and tears them down again
+std::chrono::nanoseconds time_startup(
+    std::string const& address, int iterations, Registration registration, bool shared)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        std::vector<std::unique_ptr<usc::DBusConnectionHandle>> connections;
+
+        for (auto const name : service_names)
+        {
+            if (!shared || connections.empty())
+                connections.emplace_back(new usc::DBusConnectionHandle{address, registration});
+
+            connections.back()->request_name(name);
+        }
+
+        for (auto const& connection : connections)
+            connection->finish_registration();
+    }
+
+    return std::chrono::steady_clock::now() - start;
+}
+
+void report(char const* name, int iterations, std::chrono::nanoseconds duration)
+{
+    std::cout << "    " << name << ": "
+              << std::chrono::duration_cast<std::chrono::microseconds>(duration).count() /
+                 static_cast<double>(iterations) << " us/startup"
+              << std::endl;
+}
+
+}
+
+TEST(DBusStartupBenchmark, blocking_versus_pipelined_registration)
+{
+    int const iterations = 100;
+    usc::test::DBusBus bus;
+
+    report("blocking, connection per name ", iterations,
+        time_startup(bus.address(), iterations, Registration::blocking, false));
+    report("pipelined, connection per name", iterations,
+        time_startup(bus.address(), iterations, Registration::pipelined, false));
+    report("pipelined, shared connection  ", iterations,
+        time_startup(bus.address(), iterations, Registration::pipelined, true));
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/task_queue.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// The action queue DBusEventLoop used before TaskQueue: std::function
+// copies appended to a vector under a mutex, swapped out by the consumer.
+class MutexActionQueue
+{
+public:
+    void push(std::function<void()> const& action)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        actions.push_back(action);
+    }
+
+    size_t run_pending()
+    {
+        decltype(actions) actions_to_run;
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            actions.swap(actions_to_run);
+        }
+
+        for (auto const& action : actions_to_run)
+            action();
+
+        return actions_to_run.size();
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::function<void()>> actions;
+};
+
+// A payload similar to what MirScreen's ActiveOutputs handler captures
+struct Payload
+{
+    void* owner;
+    int internal;
+    int external;
+};
+
+template<typename Queue>
+std::chrono::nanoseconds time_contended_pushes(
+    int num_producers, int pushes_per_producer)
+{
+    Queue queue;
+    std::atomic<int> producers_done{0};
+    std::atomic<bool> go{false};
+    long consumed{0};
+    long const total = static_cast<long>(num_producers) * pushes_per_producer;
+    long sink{0};
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p)
+    {
+        producers.emplace_back(
+            [&]
+            {
+                while (!go) {}
+
+                Payload const payload{&queue, 1, 0};
+                for (int i = 0; i < pushes_per_producer; ++i)
+                {
+                    queue.push(
+                        [&sink, payload] { sink += payload.internal + payload.external; });
+                }
+                ++producers_done;
+            });
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    go = true;
+
+    while (producers_done < num_producers || consumed < total)
+        consumed += queue.run_pending();
+
+    auto const end = std::chrono::steady_clock::now();
+
+    for (auto& producer : producers)
+        producer.join();
+
+    EXPECT_THAT(sink, testing::Eq(total));
+
+    return end - start;
+}
+
+void report(char const* name, int num_producers, int pushes, std::chrono::nanoseconds duration)
+{
+    auto const total = static_cast<double>(num_producers) * pushes;
+    std::cout << "    " << name
+              << ": " << num_producers << " producers, "
+              << duration.count() / total << " ns/task" << std::endl;
+}
+
+}
+
+TEST(TaskQueueBenchmark, contended_push_versus_mutex_protected_vector)
+{
+    int const pushes_per_producer = 200000;
+
+    for (int num_producers : {1, 2, 4, 8})
+    {
+        report("MutexActionQueue", num_producers, pushes_per_producer,
+               time_contended_pushes<MutexActionQueue>(num_producers, pushes_per_producer));
+        report("usc::TaskQueue  ", num_producers, pushes_per_producer,
+               time_contended_pushes<usc::TaskQueue>(num_producers, pushes_per_producer));
+    }
+}
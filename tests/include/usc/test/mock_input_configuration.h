@@ -41,6 +41,8 @@ public:
     MOCK_METHOD1(set_tap_to_click, void(bool));
     MOCK_METHOD1(set_disable_touchpad_with_mouse, void(bool));
     MOCK_METHOD1(set_disable_touchpad_while_typing, void(bool));
+    MOCK_METHOD1(apply_settings, void(usc::InputSettings const&));
+    MOCK_METHOD0(current_settings, usc::InputSettings());
 };
 }
 }
@@ -35,8 +35,12 @@ struct MockScreen : usc::Screen
 {
     MOCK_METHOD1(turn_on, void(OutputFilter));
     MOCK_METHOD1(turn_off, void(OutputFilter));
+    MOCK_METHOD1(turn_on_outputs, void(std::vector<int32_t> const&));
+    MOCK_METHOD1(turn_off_outputs, void(std::vector<int32_t> const&));
     MOCK_METHOD2(register_active_outputs_handler, void(void *, ActiveOutputsHandler const&));
     MOCK_METHOD1(unregister_active_outputs_handler, void(void*));
+    MOCK_METHOD2(register_output_states_handler, void(void *, OutputStatesHandler const&));
+    MOCK_METHOD1(unregister_output_states_handler, void(void*));
 };
 
 }
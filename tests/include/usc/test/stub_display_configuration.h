@@ -28,16 +28,24 @@ struct StubDisplayConfiguration : mir::graphics::DisplayConfiguration
 {
     StubDisplayConfiguration()
     {
+        internal_active_conf_output.id = mir::graphics::DisplayConfigurationOutputId{1};
+        internal_active_conf_output.modes = {
+            mir::graphics::DisplayConfigurationMode{mir::geometry::Size{1080, 1920}, 60.0}};
+        internal_active_conf_output.current_mode_index = 0;
         internal_active_conf_output.power_mode = MirPowerMode::mir_power_mode_on;
         internal_active_conf_output.type = mir::graphics::DisplayConfigurationOutputType::lvds;
         internal_active_conf_output.used = true;
         internal_active_conf_output.connected = true;
 
+        external_active_conf_output.id = mir::graphics::DisplayConfigurationOutputId{2};
+        external_active_conf_output.current_mode_index = 0;
         external_active_conf_output.power_mode = MirPowerMode::mir_power_mode_on;
         external_active_conf_output.type = mir::graphics::DisplayConfigurationOutputType::dvid;
         external_active_conf_output.used = true;
         external_active_conf_output.connected = true;
 
+        inactive_conf_output.id = mir::graphics::DisplayConfigurationOutputId{3};
+        inactive_conf_output.current_mode_index = 0;
         inactive_conf_output.power_mode = MirPowerMode::mir_power_mode_off;
         inactive_conf_output.used = false;
         inactive_conf_output.connected = false;
@@ -50,3 +50,13 @@ std::string usc::test::DBusBus::address()
 {
     return address_;
 }
+
+void usc::test::DBusBus::pause()
+{
+    kill(pid, SIGSTOP);
+}
+
+void usc::test::DBusBus::resume()
+{
+    kill(pid, SIGCONT);
+}
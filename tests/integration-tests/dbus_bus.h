@@ -35,6 +35,11 @@ public:
 
     std::string address();
 
+    // Stops and restarts the bus daemon, to simulate a bus that isn't
+    // reading from its clients
+    void pause();
+    void resume();
+
 private:
     std::string address_;
     pid_t pid;
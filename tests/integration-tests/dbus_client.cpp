@@ -129,8 +129,6 @@ void ut::DBusClient::DBusClient::disconnect()
 ::DBusPendingCall* ut::DBusClient::invoke_with_pending(
     char const* interface, char const* method, int first_arg_type, ...)
 {
-    static int const timeout_ms = 5000;
-
     va_list args;
     va_start(args, first_arg_type);
     usc::DBusMessageHandle msg{
@@ -142,6 +140,13 @@ void ut::DBusClient::DBusClient::disconnect()
         first_arg_type, args};
     va_end(args);
 
+    return send_with_pending(msg);
+}
+
+::DBusPendingCall* ut::DBusClient::send_with_pending(::DBusMessage* msg)
+{
+    static int const timeout_ms = 5000;
+
     DBusPendingCall* pending_reply;
     dbus_connection_send_with_reply(
         connection, msg, &pending_reply, timeout_ms);
@@ -101,6 +101,7 @@ public:
 protected:
     DBusPendingCall* invoke_with_pending(
         char const* interface, char const* method, int first_arg_type, ...);
+    DBusPendingCall* send_with_pending(::DBusMessage* msg);
     usc::DBusConnectionHandle connection;
     std::string const destination;
     std::string const path;
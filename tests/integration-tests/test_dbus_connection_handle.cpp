@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/dbus_connection_handle.h"
+#include "src/dbus_message_handle.h"
+
+#include "dbus_bus.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace ut = usc::test;
+using namespace testing;
+
+namespace
+{
+
+char const* const display_name = "com.canonical.Unity.Display";
+char const* const input_name = "com.canonical.Unity.Input";
+
+struct ADBusConnectionHandle : testing::Test
+{
+    std::string name_owner(char const* name)
+    {
+        usc::DBusMessageHandle request{
+            dbus_message_new_method_call(
+                "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                "GetNameOwner"),
+            DBUS_TYPE_STRING, &name,
+            DBUS_TYPE_INVALID};
+
+        usc::DBusMessageHandle reply{
+            dbus_connection_send_with_reply_and_block(observer, request, 3000, nullptr)};
+
+        char const* owner{""};
+        if (reply)
+            dbus_message_get_args(reply, nullptr, DBUS_TYPE_STRING, &owner, DBUS_TYPE_INVALID);
+
+        return owner;
+    }
+
+    ut::DBusBus bus;
+    usc::DBusConnectionHandle observer{bus.address()};
+};
+
+}
+
+TEST_F(ADBusConnectionHandle, owns_names_requested_while_pipelined_once_finished)
+{
+    usc::DBusConnectionHandle connection{
+        bus.address(), usc::DBusConnectionHandle::Registration::pipelined};
+
+    connection.request_name(display_name);
+    connection.request_name(input_name);
+    connection.finish_registration();
+
+    auto const unique_name = dbus_bus_get_unique_name(connection);
+    ASSERT_THAT(unique_name, NotNull());
+    EXPECT_THAT(name_owner(display_name), StrEq(unique_name));
+    EXPECT_THAT(name_owner(input_name), StrEq(unique_name));
+}
+
+TEST_F(ADBusConnectionHandle, reports_pipelined_request_for_taken_name_when_finishing)
+{
+    usc::DBusConnectionHandle owner{bus.address()};
+    owner.request_name(display_name);
+
+    usc::DBusConnectionHandle connection{
+        bus.address(), usc::DBusConnectionHandle::Registration::pipelined};
+    connection.request_name(input_name);
+    connection.request_name(display_name);
+
+    EXPECT_THROW(connection.finish_registration(), std::runtime_error);
+    EXPECT_THAT(name_owner(display_name), StrEq(dbus_bus_get_unique_name(owner)));
+}
+
+TEST_F(ADBusConnectionHandle, finishing_blocking_registration_does_nothing)
+{
+    usc::DBusConnectionHandle connection{bus.address()};
+    connection.request_name(display_name);
+
+    connection.finish_registration();
+
+    EXPECT_THAT(name_owner(display_name), StrEq(dbus_bus_get_unique_name(connection)));
+}
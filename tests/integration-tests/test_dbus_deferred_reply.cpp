@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/dbus_deferred_reply.h"
+#include "src/dbus_worker_pool.h"
+#include "src/dbus_event_loop.h"
+#include "src/dbus_connection_handle.h"
+#include "src/dbus_message_handle.h"
+#include "src/scoped_dbus_error.h"
+#include "dbus_bus.h"
+#include "dbus_client.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace ut = usc::test;
+using namespace testing;
+
+namespace
+{
+
+char const* const test_service_name = "com.TestService";
+char const* const test_service_path = "/com/TestService";
+char const* const test_service_interface = "com.TestService";
+
+std::chrono::milliseconds const slow_call_duration{100};
+
+class TestDBusClient : public ut::DBusClient
+{
+public:
+    TestDBusClient(std::string const& address)
+        : ut::DBusClient{address, test_service_name, test_service_path}
+    {
+    }
+
+    ut::DBusAsyncReplyInt request_slow_double(int32_t a)
+    {
+        return invoke_with_reply<ut::DBusAsyncReplyInt>(
+            test_service_interface, "slow_double",
+            DBUS_TYPE_INT32, &a,
+            DBUS_TYPE_INVALID);
+    }
+
+    ut::DBusAsyncReplyInt request_blocked_double(int32_t a)
+    {
+        return invoke_with_reply<ut::DBusAsyncReplyInt>(
+            test_service_interface, "blocked_double",
+            DBUS_TYPE_INT32, &a,
+            DBUS_TYPE_INVALID);
+    }
+
+    ut::DBusAsyncReplyInt request_double(int32_t a)
+    {
+        return invoke_with_reply<ut::DBusAsyncReplyInt>(
+            test_service_interface, "double",
+            DBUS_TYPE_INT32, &a,
+            DBUS_TYPE_INVALID);
+    }
+
+    ut::DBusAsyncReplyVoid request_forgotten()
+    {
+        return invoke_with_reply<ut::DBusAsyncReplyVoid>(
+            test_service_interface, "forgotten",
+            DBUS_TYPE_INVALID);
+    }
+};
+
+struct ADBusDeferredReply : testing::Test
+{
+    ADBusDeferredReply()
+    {
+        loop->add_connection(connection);
+        connection->request_name(test_service_name);
+        connection->add_filter(handle_dbus_message_thunk, this);
+
+        std::promise<void> event_loop_started;
+        auto event_loop_started_future = event_loop_started.get_future();
+
+        dbus_loop_thread = std::thread(
+            [this,&event_loop_started]
+            {
+                loop->run(event_loop_started);
+            });
+
+        event_loop_started_future.wait();
+    }
+
+    ~ADBusDeferredReply()
+    {
+        unblock();
+        loop->stop();
+        if (dbus_loop_thread.joinable())
+            dbus_loop_thread.join();
+    }
+
+    static ::DBusHandlerResult handle_dbus_message_thunk(
+        ::DBusConnection*, DBusMessage* message, void* user_data)
+    {
+        return static_cast<ADBusDeferredReply*>(user_data)->handle_dbus_message(message);
+    }
+
+    ::DBusHandlerResult handle_dbus_message(DBusMessage* message)
+    {
+        usc::ScopedDBusError args_error;
+        int32_t a{0};
+
+        if (dbus_message_is_method_call(message, test_service_interface, "forgotten"))
+        {
+            usc::DBusDeferredReply{loop, connection, message};
+            return DBUS_HANDLER_RESULT_HANDLED;
+        }
+
+        if (dbus_message_get_type(message) != DBUS_MESSAGE_TYPE_METHOD_CALL ||
+            !dbus_message_get_args(message, &args_error, DBUS_TYPE_INT32, &a, DBUS_TYPE_INVALID))
+        {
+            return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+        }
+
+        auto const send_doubled =
+            [reply = usc::DBusDeferredReply{loop, connection, message}] (int32_t result)
+            {
+                reply.send_return(DBUS_TYPE_INT32, &result, DBUS_TYPE_INVALID);
+            };
+
+        if (dbus_message_is_method_call(message, test_service_interface, "slow_double"))
+        {
+            workers.run_then(
+                loop,
+                [a]
+                {
+                    std::this_thread::sleep_for(slow_call_duration);
+                    return 2 * a;
+                },
+                send_doubled);
+        }
+        else if (dbus_message_is_method_call(message, test_service_interface, "blocked_double"))
+        {
+            workers.run_then(
+                loop,
+                [a, unblocked = unblocked_future]
+                {
+                    unblocked.wait();
+                    return 2 * a;
+                },
+                send_doubled);
+        }
+        else
+        {
+            send_doubled(2 * a);
+        }
+
+        return DBUS_HANDLER_RESULT_HANDLED;
+    }
+
+    void unblock()
+    {
+        if (!unblocked)
+        {
+            unblocked_promise.set_value();
+            unblocked = true;
+        }
+    }
+
+    int const num_workers = 25;
+
+    ut::DBusBus bus;
+    std::shared_ptr<usc::DBusConnectionHandle> const connection{
+        std::make_shared<usc::DBusConnectionHandle>(bus.address())};
+    std::shared_ptr<usc::DBusEventLoop> const loop{std::make_shared<usc::DBusEventLoop>()};
+    std::promise<void> unblocked_promise;
+    std::shared_future<void> const unblocked_future{unblocked_promise.get_future().share()};
+    bool unblocked{false};
+    // Declared after everything the queued work refers to, so that it's
+    // stopped first
+    usc::DBusWorkerPool workers{num_workers};
+    std::thread dbus_loop_thread;
+    TestDBusClient client{bus.address()};
+};
+
+}
+
+TEST_F(ADBusDeferredReply, sends_reply_once_work_on_worker_thread_is_done)
+{
+    auto reply = client.request_slow_double(21);
+
+    EXPECT_THAT(reply.get(), Eq(42));
+}
+
+TEST_F(ADBusDeferredReply, runs_many_slow_calls_in_parallel)
+{
+    int const num_calls = 100;
+
+    auto const start = std::chrono::steady_clock::now();
+
+    std::vector<ut::DBusAsyncReplyInt> replies;
+    for (int i = 0; i < num_calls; ++i)
+        replies.push_back(client.request_slow_double(i));
+
+    for (int i = 0; i < num_calls; ++i)
+        EXPECT_THAT(replies[i].get(), Eq(2 * i));
+
+    auto const duration = std::chrono::steady_clock::now() - start;
+
+    // Serially the calls would take num_calls * slow_call_duration. With
+    // num_workers threads they ideally take a 25th of that; leave plenty
+    // of slack for slow builders.
+    EXPECT_THAT(duration, Lt(num_calls * slow_call_duration / 4));
+}
+
+TEST_F(ADBusDeferredReply, keeps_serving_other_calls_while_replies_are_pending)
+{
+    auto blocked_reply = client.request_blocked_double(1);
+
+    auto reply = client.request_double(2);
+    EXPECT_THAT(reply.get(), Eq(4));
+
+    unblock();
+    EXPECT_THAT(blocked_reply.get(), Eq(2));
+}
+
+TEST_F(ADBusDeferredReply, sends_error_if_dropped_without_reply)
+{
+    auto reply = client.request_forgotten();
+
+    EXPECT_THROW({ reply.get(); }, std::runtime_error);
+}
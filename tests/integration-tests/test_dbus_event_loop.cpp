@@ -20,12 +20,17 @@
 #include "src/dbus_connection_handle.h"
 #include "src/dbus_message_handle.h"
 #include "src/scoped_dbus_error.h"
+#include "src/steady_clock.h"
 #include "dbus_bus.h"
 #include "dbus_client.h"
+#include "spin_wait.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <dirent.h>
+#include <poll.h>
+
 namespace ut = usc::test;
 
 namespace
@@ -38,10 +43,12 @@ char const* const test_service_interface = "com.TestService";
 class TestDBusClient : public ut::DBusClient
 {
 public:
-    TestDBusClient(std::string const& address)
+    TestDBusClient(
+        std::string const& address,
+        std::string const& service_name = test_service_name)
         : ut::DBusClient{
             address,
-            test_service_name,
+            service_name,
             test_service_path}
     {
         std::string const match =
@@ -75,13 +82,55 @@ public:
     }
 };
 
-struct ADBusEventLoop : testing::Test
+::DBusHandlerResult handle_add_method_call(
+    ::DBusConnection* connection, DBusMessage* message, void* /*user_data*/)
+{
+    usc::ScopedDBusError args_error;
+
+    if (dbus_message_is_method_call(message, test_service_interface, "add"))
+    {
+        int32_t a{0};
+        int32_t b{0};
+        dbus_message_get_args(
+            message, &args_error,
+            DBUS_TYPE_INT32, &a,
+            DBUS_TYPE_INT32, &b,
+            DBUS_TYPE_INVALID);
+
+        if (!args_error)
+        {
+            int32_t const result{a + b};
+            usc::DBusMessageHandle reply{
+                dbus_message_new_method_return(message),
+                DBUS_TYPE_INT32, &result,
+                DBUS_TYPE_INVALID};
+
+            dbus_connection_send(connection, reply, nullptr);
+        }
+    }
+
+    return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+bool wait_for_incoming_data(usc::DBusConnectionHandle const& connection)
+{
+    pollfd pfd{};
+    if (!dbus_connection_get_unix_fd(connection, &pfd.fd))
+        return false;
+    pfd.events = POLLIN;
+
+    return poll(&pfd, 1, 3000) == 1;
+}
+
+// Runs each test against both backends. The io_uring one quietly becomes
+// epoll on kernels without io_uring support.
+struct ADBusEventLoop : testing::TestWithParam<usc::DBusEventLoop::Backend>
 {
     ADBusEventLoop()
     {
         dbus_event_loop.add_connection(connection);
         connection->request_name(test_service_name);
-        connection->add_filter(handle_dbus_message_thunk, this);
+        connection->add_filter(handle_add_method_call, this);
 
         std::promise<void> event_loop_started;
         auto event_loop_started_future = event_loop_started.get_future();
@@ -102,55 +151,20 @@ struct ADBusEventLoop : testing::Test
             dbus_loop_thread.join();
     }
 
-    static ::DBusHandlerResult handle_dbus_message_thunk(
-        ::DBusConnection* connection, DBusMessage* message, void* user_data) {
-        auto const a_dbus_event_loop = static_cast<ADBusEventLoop*>(user_data);
-        return a_dbus_event_loop->handle_dbus_message(connection, message, user_data);
-    }
-
-    DBusHandlerResult handle_dbus_message(
-        ::DBusConnection* connection, DBusMessage* message, void* user_data)
-    {
-        usc::ScopedDBusError args_error;
-
-        if (dbus_message_is_method_call(message, test_service_interface, "add"))
-        {
-            int32_t a{0};
-            int32_t b{0};
-            dbus_message_get_args(
-                message, &args_error,
-                DBUS_TYPE_INT32, &a,
-                DBUS_TYPE_INT32, &b,
-                DBUS_TYPE_INVALID);
-
-            if (!args_error)
-            {
-                int32_t const result{a + b};
-                usc::DBusMessageHandle reply{
-                    dbus_message_new_method_return(message),
-                    DBUS_TYPE_INT32, &result,
-                    DBUS_TYPE_INVALID};
-
-                dbus_connection_send(connection, reply, nullptr);
-            }
-        }
-
-        return DBUS_HANDLER_RESULT_HANDLED;
-    }
-
     std::chrono::seconds const default_timeout{3};
 
     ut::DBusBus bus;
 
     std::shared_ptr<usc::DBusConnectionHandle> connection{std::make_shared<usc::DBusConnectionHandle>(bus.address())};
-    usc::DBusEventLoop dbus_event_loop{};
+    usc::DBusEventLoop dbus_event_loop{
+        1, usc::DBusEventLoop::Trigger::level, std::make_shared<usc::SteadyClock>(), GetParam()};
     std::thread dbus_loop_thread;
     TestDBusClient client{bus.address()};
 };
 
 }
 
-TEST_F(ADBusEventLoop, dispatches_received_message)
+TEST_P(ADBusEventLoop, dispatches_received_message)
 {
     using namespace testing;
 
@@ -162,7 +176,7 @@ TEST_F(ADBusEventLoop, dispatches_received_message)
     EXPECT_THAT(reply.get(), expected);
 }
 
-TEST_F(ADBusEventLoop, enqueues_send_requests)
+TEST_P(ADBusEventLoop, enqueues_send_requests)
 {
     dbus_event_loop.enqueue(
         [this]
@@ -192,7 +206,7 @@ void pending_complete(DBusPendingCall* pending, void* user_data)
 
 }
 
-TEST_F(ADBusEventLoop, handles_reply_timeouts)
+TEST_P(ADBusEventLoop, handles_reply_timeouts)
 {
     using namespace testing;
 
@@ -231,3 +245,453 @@ TEST_F(ADBusEventLoop, handles_reply_timeouts)
     EXPECT_THAT(delay, Lt(std::chrono::milliseconds{timeout_ms * 10}));
     EXPECT_THAT(delay, Ge(std::chrono::milliseconds{timeout_ms}));
 }
+
+TEST_P(ADBusEventLoop, coalesces_wake_ups_for_many_enqueued_actions)
+{
+    using namespace testing;
+
+    int const num_threads = 4;
+    int const actions_per_thread = 25000;
+    int const num_actions = num_threads * actions_per_thread;
+    // The loop runs up to 256 normal actions per iteration, so with the
+    // wake ups coalesced the actions take a few hundred iterations
+    uint64_t const max_iterations = 2 * num_actions / 256;
+
+    std::atomic<int> executed{0};
+
+    // Hold the loop while the actions are enqueued, so that how many
+    // iterations they take doesn't depend on how the threads interleave
+    std::promise<void> unblock_promise;
+    std::promise<void> blocked_promise;
+    dbus_event_loop.enqueue(
+        [&unblock_promise,&blocked_promise]
+        {
+            blocked_promise.set_value();
+            unblock_promise.get_future().wait();
+        });
+    blocked_promise.get_future().wait();
+
+    auto const iterations_before = dbus_event_loop.iterations();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back(
+            [this,&executed]
+            {
+                for (int i = 0; i < actions_per_thread; ++i)
+                    dbus_event_loop.enqueue([&executed] { ++executed; });
+            });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    unblock_promise.set_value();
+
+    ut::spin_wait_for_condition_or_timeout(
+        [&executed] { return executed == num_actions; },
+        default_timeout);
+
+    EXPECT_THAT(executed.load(), Eq(num_actions));
+    EXPECT_THAT(dbus_event_loop.iterations() - iterations_before, Lt(max_iterations));
+}
+
+TEST_P(ADBusEventLoop, keeps_running_actions_while_the_bus_is_not_reading)
+{
+    using namespace testing;
+
+    int const num_signals = 100;
+    std::string const payload(64 * 1024, 'x');
+
+    bus.pause();
+
+    // Queue up more data than the socket buffer can take
+    std::promise<void> sent_promise;
+    dbus_event_loop.enqueue(
+        [this,&payload,&sent_promise]
+        {
+            for (int i = 0; i < num_signals; ++i)
+            {
+                auto const payload_cstr = payload.c_str();
+                usc::DBusMessageHandle msg{
+                    dbus_message_new_signal(
+                        test_service_path,
+                        test_service_interface,
+                        "signal"),
+                    DBUS_TYPE_STRING, &payload_cstr,
+                    DBUS_TYPE_INVALID};
+
+                dbus_connection_send(*connection, msg, nullptr);
+            }
+            sent_promise.set_value();
+        });
+    sent_promise.get_future().wait();
+
+    std::promise<void> action_promise;
+    auto action_future = action_promise.get_future();
+    dbus_event_loop.enqueue([&action_promise] { action_promise.set_value(); });
+
+    auto const status = action_future.wait_for(default_timeout);
+
+    bus.resume();
+
+    EXPECT_THAT(status, Eq(std::future_status::ready));
+}
+
+TEST_P(ADBusEventLoop, runs_urgent_actions_before_pending_normal_ones)
+{
+    using namespace testing;
+
+    std::promise<void> unblock_promise;
+    auto unblock_future = unblock_promise.get_future().share();
+    std::promise<void> done_promise;
+    std::vector<std::string> order;
+
+    // Keep the loop busy while the other actions are queued up
+    std::promise<void> blocked_promise;
+    dbus_event_loop.enqueue(
+        [unblock_future,&blocked_promise]
+        {
+            blocked_promise.set_value();
+            unblock_future.wait();
+        });
+    blocked_promise.get_future().wait();
+
+    for (int i = 0; i < 100; ++i)
+        dbus_event_loop.enqueue([&order] { order.push_back("normal"); });
+    dbus_event_loop.enqueue(
+        usc::DBusEventLoop::ActionPriority::urgent,
+        [&order] { order.push_back("urgent"); });
+    dbus_event_loop.enqueue([&done_promise] { done_promise.set_value(); });
+
+    unblock_promise.set_value();
+    done_promise.get_future().wait();
+
+    ASSERT_THAT(order.size(), Eq(101u));
+    EXPECT_THAT(order.front(), Eq("urgent"));
+}
+
+TEST_P(ADBusEventLoop, counts_actions_that_miss_their_deadline)
+{
+    using namespace testing;
+
+    std::promise<void> unblock_promise;
+    auto unblock_future = unblock_promise.get_future().share();
+    std::promise<void> done_promise;
+
+    dbus_event_loop.enqueue([unblock_future] { unblock_future.wait(); });
+
+    dbus_event_loop.enqueue(
+        usc::DBusEventLoop::ActionPriority::urgent, std::chrono::nanoseconds{0}, []{});
+    dbus_event_loop.enqueue(
+        usc::DBusEventLoop::ActionPriority::normal, std::chrono::hours{1}, []{});
+    dbus_event_loop.enqueue([&done_promise] { done_promise.set_value(); });
+
+    unblock_promise.set_value();
+    done_promise.get_future().wait();
+
+    EXPECT_THAT(dbus_event_loop.deadline_misses(), Eq(1u));
+}
+
+namespace
+{
+
+void count_pending_complete(DBusPendingCall* pending, void* user_data)
+{
+    auto const completed = static_cast<std::atomic<int>*>(user_data);
+    ++*completed;
+    dbus_pending_call_unref(pending);
+}
+
+}
+
+TEST_P(ADBusEventLoop, handles_many_concurrent_reply_timeouts)
+{
+    using namespace testing;
+
+    int const num_calls = 200;
+    static int const timeout_ms = 100;
+    std::atomic<int> completed{0};
+
+    dbus_event_loop.enqueue(
+        [this,&completed]
+        {
+            for (int i = 0; i < num_calls; ++i)
+            {
+                usc::DBusMessageHandle msg{
+                    dbus_message_new_signal(
+                        test_service_path,
+                        test_service_interface,
+                        "signal")};
+
+                DBusPendingCall* pending{nullptr};
+                dbus_connection_send_with_reply(
+                    *connection, msg, &pending, timeout_ms);
+                dbus_pending_call_set_notify(
+                    pending, &count_pending_complete, &completed, nullptr);
+            }
+        });
+
+    ut::spin_wait_for_condition_or_timeout(
+        [&completed] { return completed == num_calls; },
+        default_timeout);
+
+    EXPECT_THAT(completed.load(), Eq(num_calls));
+}
+
+namespace
+{
+
+int count_open_fds()
+{
+    int count{0};
+
+    if (auto const dir = opendir("/proc/self/fd"))
+    {
+        while (readdir(dir))
+            ++count;
+        closedir(dir);
+    }
+
+    return count;
+}
+
+}
+
+TEST_P(ADBusEventLoop, uses_a_constant_number_of_fds_for_many_reply_timeouts)
+{
+    using namespace testing;
+
+    int const num_calls = 200;
+    static int const timeout_ms = 10000;
+    std::vector<DBusPendingCall*> pending_calls;
+
+    auto const fds_before = count_open_fds();
+
+    std::promise<void> sent_promise;
+    dbus_event_loop.enqueue(
+        [this,&pending_calls,&sent_promise]
+        {
+            for (int i = 0; i < num_calls; ++i)
+            {
+                usc::DBusMessageHandle msg{
+                    dbus_message_new_signal(
+                        test_service_path,
+                        test_service_interface,
+                        "signal")};
+
+                DBusPendingCall* pending{nullptr};
+                dbus_connection_send_with_reply(
+                    *connection, msg, &pending, timeout_ms);
+                pending_calls.push_back(pending);
+            }
+            sent_promise.set_value();
+        });
+    sent_promise.get_future().wait();
+
+    EXPECT_THAT(count_open_fds(), Eq(fds_before));
+
+    std::promise<void> cancelled_promise;
+    dbus_event_loop.enqueue(
+        [&pending_calls,&cancelled_promise]
+        {
+            for (auto const pending : pending_calls)
+            {
+                dbus_pending_call_cancel(pending);
+                dbus_pending_call_unref(pending);
+            }
+            cancelled_promise.set_value();
+        });
+    cancelled_promise.get_future().wait();
+}
+
+namespace
+{
+
+// Prepares a backlog of ready fds (several connections with pending method
+// calls, plus the wake up fd) before the loop starts, and returns how many
+// loop iterations it took to handle all of it.
+uint64_t iterations_to_handle_backlog(
+    int max_events_per_wakeup,
+    usc::DBusEventLoop::Trigger trigger,
+    usc::DBusEventLoop::Backend backend)
+{
+    int const num_connections = 4;
+
+    ut::DBusBus bus;
+    usc::DBusEventLoop loop{
+        max_events_per_wakeup, trigger, std::make_shared<usc::SteadyClock>(), backend};
+    std::vector<std::shared_ptr<usc::DBusConnectionHandle>> connections;
+    std::vector<std::unique_ptr<TestDBusClient>> clients;
+    std::vector<ut::DBusAsyncReplyInt> replies;
+
+    for (int i = 0; i < num_connections; ++i)
+    {
+        auto const name = std::string{test_service_name} + std::to_string(i);
+        auto const connection =
+            std::make_shared<usc::DBusConnectionHandle>(bus.address());
+        loop.add_connection(connection);
+        connection->request_name(name.c_str());
+        connection->add_filter(handle_add_method_call, nullptr);
+        connections.push_back(connection);
+        clients.push_back(std::make_unique<TestDBusClient>(bus.address(), name));
+    }
+
+    for (auto const& client : clients)
+        replies.push_back(client->request_add(1, 2));
+
+    for (auto const& connection : connections)
+        EXPECT_TRUE(wait_for_incoming_data(*connection));
+
+    std::promise<void> action_done;
+    loop.enqueue([&action_done] { action_done.set_value(); });
+
+    std::promise<void> started;
+    std::thread loop_thread{[&] { loop.run(started); }};
+
+    for (auto& reply : replies)
+        EXPECT_THAT(reply.get(), testing::Eq(3));
+    action_done.get_future().wait();
+
+    auto const iterations = loop.iterations();
+
+    loop.stop();
+    loop_thread.join();
+
+    return iterations;
+}
+
+struct ADBusEventLoopIteration : testing::TestWithParam<usc::DBusEventLoop::Backend>
+{
+};
+
+}
+
+TEST_P(ADBusEventLoopIteration, handles_several_ready_fds_per_iteration_in_batched_mode)
+{
+    using namespace testing;
+
+    auto const single_event_iterations =
+        iterations_to_handle_backlog(1, usc::DBusEventLoop::Trigger::level, GetParam());
+    auto const batched_iterations =
+        iterations_to_handle_backlog(16, usc::DBusEventLoop::Trigger::level, GetParam());
+
+    EXPECT_THAT(batched_iterations, Lt(single_event_iterations));
+}
+
+TEST_P(ADBusEventLoopIteration, handles_several_ready_fds_per_iteration_in_edge_triggered_mode)
+{
+    using namespace testing;
+
+    auto const single_event_iterations =
+        iterations_to_handle_backlog(1, usc::DBusEventLoop::Trigger::level, GetParam());
+    auto const edge_triggered_iterations =
+        iterations_to_handle_backlog(16, usc::DBusEventLoop::Trigger::edge, GetParam());
+
+    EXPECT_THAT(edge_triggered_iterations, Lt(single_event_iterations));
+}
+
+TEST_P(ADBusEventLoopIteration, drains_all_pending_requests_in_edge_triggered_mode)
+{
+    using namespace testing;
+
+    int const num_requests = 500;
+
+    ut::DBusBus bus;
+    usc::DBusEventLoop loop{
+        16, usc::DBusEventLoop::Trigger::edge, std::make_shared<usc::SteadyClock>(), GetParam()};
+    auto const connection =
+        std::make_shared<usc::DBusConnectionHandle>(bus.address());
+    loop.add_connection(connection);
+    connection->request_name(test_service_name);
+    connection->add_filter(handle_add_method_call, nullptr);
+
+    std::promise<void> started;
+    std::thread loop_thread{[&] { loop.run(started); }};
+    started.get_future().wait();
+
+    TestDBusClient client{bus.address()};
+    std::vector<ut::DBusAsyncReplyInt> replies;
+
+    for (int i = 0; i < num_requests; ++i)
+        replies.push_back(client.request_add(i, 1));
+
+    for (int i = 0; i < num_requests; ++i)
+        EXPECT_THAT(replies[i].get(), Eq(i + 1));
+
+    loop.stop();
+    loop_thread.join();
+}
+
+TEST_P(ADBusEventLoopIteration, waits_for_a_stalled_reader_in_edge_triggered_mode)
+{
+    using namespace testing;
+
+    int const num_signals = 200;
+    std::string const payload(64 * 1024, 'x');
+    auto const stall = std::chrono::milliseconds{200};
+    uint64_t const max_stalled_iterations = 50;
+
+    ut::DBusBus bus;
+    usc::DBusEventLoop loop{
+        16, usc::DBusEventLoop::Trigger::edge, std::make_shared<usc::SteadyClock>(), GetParam()};
+    auto const connection =
+        std::make_shared<usc::DBusConnectionHandle>(bus.address());
+    loop.add_connection(connection);
+
+    std::promise<void> started;
+    std::thread loop_thread{[&] { loop.run(started); }};
+    started.get_future().wait();
+
+    // Queue up more data than the bus can read at once, so that the loop is
+    // writing as the socket reports it writable when the bus stalls
+    std::promise<void> sent_promise;
+    loop.enqueue(
+        [&]
+        {
+            for (int i = 0; i < num_signals; ++i)
+            {
+                auto const payload_cstr = payload.c_str();
+                usc::DBusMessageHandle msg{
+                    dbus_message_new_signal(
+                        test_service_path,
+                        test_service_interface,
+                        "signal"),
+                    DBUS_TYPE_STRING, &payload_cstr,
+                    DBUS_TYPE_INVALID};
+
+                dbus_connection_send(*connection, msg, nullptr);
+            }
+            sent_promise.set_value();
+        });
+    sent_promise.get_future().wait();
+
+    bus.pause();
+
+    // Let the loop fill the socket before counting
+    std::this_thread::sleep_for(stall);
+    auto const iterations_before = loop.iterations();
+    std::this_thread::sleep_for(stall);
+    auto const stalled_iterations = loop.iterations() - iterations_before;
+
+    bus.resume();
+
+    auto const all_sent = ut::spin_wait_for_condition_or_timeout(
+        [&] { return !dbus_connection_has_messages_to_send(*connection); },
+        std::chrono::seconds{3});
+
+    loop.stop();
+    loop_thread.join();
+
+    EXPECT_THAT(stalled_iterations, Lt(max_stalled_iterations));
+    EXPECT_TRUE(all_sent);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Backends, ADBusEventLoop,
+    testing::Values(usc::DBusEventLoop::Backend::epoll, usc::DBusEventLoop::Backend::io_uring));
+
+INSTANTIATE_TEST_CASE_P(
+    Backends, ADBusEventLoopIteration,
+    testing::Values(usc::DBusEventLoop::Backend::epoll, usc::DBusEventLoop::Backend::io_uring));
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/dbus_event_loop_pool.h"
+#include "src/dbus_connection_thread.h"
+#include "src/dbus_event_loop.h"
+#include "src/unity_display_service.h"
+#include "src/unity_input_service.h"
+
+#include "dbus_bus.h"
+#include "unity_input_dbus_client.h"
+
+#include "usc/test/mock_input_configuration.h"
+#include "usc/test/mock_screen.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <pthread.h>
+
+namespace ut = usc::test;
+using namespace testing;
+
+namespace
+{
+
+char const* const display_service_name = "com.canonical.Unity.Display";
+char const* const input_service_name = "com.canonical.Unity.Input";
+
+std::shared_ptr<usc::DBusEventLoopPool> make_pool(int num_loops)
+{
+    std::vector<std::shared_ptr<usc::DBusEventLoop>> loops;
+    for (int i = 0; i < num_loops; ++i)
+        loops.push_back(std::make_shared<usc::DBusEventLoop>());
+
+    return std::make_shared<usc::DBusEventLoopPool>(loops);
+}
+
+struct ADBusEventLoopPool : testing::Test
+{
+    std::chrono::seconds const default_timeout{3};
+    ut::DBusBus bus;
+
+    ut::UnityInputDBusClient input_client{bus.address()};
+    std::shared_ptr<ut::MockScreen> const mock_screen =
+        std::make_shared<testing::NiceMock<ut::MockScreen>>();
+    std::shared_ptr<ut::MockInputConfiguration> const mock_input_configuration =
+        std::make_shared<testing::NiceMock<ut::MockInputConfiguration>>();
+    std::shared_ptr<usc::DBusEventLoopPool> const pool{make_pool(2)};
+    usc::UnityDisplayService screen_service{
+        pool->loop_for(display_service_name), bus.address(), mock_screen};
+    usc::UnityInputService input_service{
+        pool->loop_for(input_service_name), bus.address(), mock_input_configuration};
+    std::shared_ptr<usc::DBusConnectionThread> const dbus_thread =
+        std::make_shared<usc::DBusConnectionThread>(pool);
+};
+
+}
+
+TEST(ADBusEventLoopPoolAssignment, assigns_services_to_loops_round_robin)
+{
+    auto const pool = make_pool(2);
+    auto const& loops = pool->loops();
+
+    EXPECT_THAT(pool->loop_for("a"), Eq(loops[0]));
+    EXPECT_THAT(pool->loop_for("b"), Eq(loops[1]));
+    EXPECT_THAT(pool->loop_for("c"), Eq(loops[0]));
+    EXPECT_THAT(pool->loop_for("a"), Eq(loops[0]));
+    EXPECT_THAT(pool->loop_for("b"), Eq(loops[1]));
+}
+
+TEST_F(ADBusEventLoopPool, runs_each_loop_on_its_own_named_thread)
+{
+    std::promise<std::string> thread_name_promise;
+
+    pool->enqueue(
+        input_service_name,
+        [&thread_name_promise]
+        {
+            char name[16]{};
+            pthread_getname_np(pthread_self(), name, sizeof name);
+            thread_name_promise.set_value(name);
+        });
+
+    EXPECT_THAT(thread_name_promise.get_future().get(), Eq("USC/DBus-1"));
+}
+
+TEST_F(ADBusEventLoopPool, keeps_serving_other_services_while_one_loop_is_blocked)
+{
+    std::promise<void> unblock_promise;
+    auto unblock_future = unblock_promise.get_future().share();
+    std::promise<void> blocked_promise;
+
+    pool->enqueue(
+        display_service_name,
+        [unblock_future,&blocked_promise]
+        {
+            blocked_promise.set_value();
+            unblock_future.wait();
+        });
+    blocked_promise.get_future().wait();
+
+    EXPECT_CALL(*mock_input_configuration, set_mouse_scroll_speed(1.0));
+
+    auto reply = input_client.request_set_mouse_scroll_speed(1.0);
+    EXPECT_NO_THROW(reply.get());
+
+    unblock_promise.set_value();
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/dbus_peer_server.h"
+#include "src/unity_display_service.h"
+#include "src/unity_input_service.h"
+#include "src/unity_user_activity_event_sink.h"
+#include "src/dbus_connection_handle.h"
+#include "src/dbus_connection_thread.h"
+#include "src/dbus_event_loop.h"
+#include "src/dbus_message_handle.h"
+#include "src/scoped_dbus_error.h"
+#include "src/unity_display_service_introspection.h"
+#include "src/unity_input_service_introspection.h"
+#include "spin_wait.h"
+#include "dbus_bus.h"
+
+#include "usc/test/mock_screen.h"
+#include "usc/test/mock_input_configuration.h"
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ut = usc::test;
+
+namespace
+{
+
+char const* const display_path = "/com/canonical/Unity/Display";
+char const* const display_interface = "com.canonical.Unity.Display";
+char const* const input_path = "/com/canonical/Unity/Input";
+
+struct FakeScreen : ut::MockScreen
+{
+    void register_active_outputs_handler(void*, usc::ActiveOutputsHandler const& handler) override
+    {
+        active_outputs_handler = handler;
+    }
+
+    usc::ActiveOutputsHandler active_outputs_handler{[](usc::ActiveOutputs const&){}};
+};
+
+// Calls a method and waits for the reply. Peers have no bus, so calls to
+// them have no destination.
+usc::DBusMessageHandle call(
+    usc::DBusConnectionHandle const& connection,
+    char const* path,
+    char const* interface,
+    char const* member)
+{
+    usc::DBusMessageHandle call{
+        dbus_message_new_method_call(nullptr, path, interface, member)};
+
+    usc::ScopedDBusError error;
+    usc::DBusMessageHandle reply{
+        dbus_connection_send_with_reply_and_block(connection, call, 3000, &error)};
+
+    if (!reply)
+        throw std::runtime_error("call: " + error.message_str());
+
+    return reply;
+}
+
+std::string introspection_reply(usc::DBusMessageHandle const& reply)
+{
+    char const* xml{""};
+    dbus_message_get_args(reply, nullptr, DBUS_TYPE_STRING, &xml, DBUS_TYPE_INVALID);
+    return xml;
+}
+
+struct ADBusPeerServer : testing::Test
+{
+    ADBusPeerServer()
+    {
+        display_service.serve_peers(peer_server);
+        input_service.serve_peers(peer_server);
+        user_activity_sink.serve_peers(peer_server);
+        dbus_thread = std::make_shared<usc::DBusConnectionThread>(dbus_loop);
+    }
+
+    bool wait_for_peers(size_t peers)
+    {
+        return ut::spin_wait_for_condition_or_timeout(
+            [&] { return peer_server->peers() == peers; },
+            std::chrono::seconds{3});
+    }
+
+    usc::DBusMessageHandle wait_for_signal(
+        usc::DBusConnectionHandle const& connection, char const* interface, char const* member)
+    {
+        auto const timeout = std::chrono::steady_clock::now() + std::chrono::seconds{3};
+
+        while (std::chrono::steady_clock::now() < timeout)
+        {
+            dbus_connection_read_write(connection, 10);
+            usc::DBusMessageHandle message{dbus_connection_pop_message(connection)};
+
+            if (message && dbus_message_is_signal(message, interface, member))
+                return message;
+        }
+
+        return usc::DBusMessageHandle{nullptr};
+    }
+
+    ut::DBusBus bus;
+
+    std::shared_ptr<FakeScreen> const fake_screen =
+        std::make_shared<testing::NiceMock<FakeScreen>>();
+    std::shared_ptr<ut::MockInputConfiguration> const mock_input_configuration =
+        std::make_shared<testing::NiceMock<ut::MockInputConfiguration>>();
+    std::shared_ptr<usc::DBusEventLoop> const dbus_loop =
+        std::make_shared<usc::DBusEventLoop>();
+    std::shared_ptr<usc::DBusPeerServer> const peer_server =
+        std::make_shared<usc::DBusPeerServer>(
+            dbus_loop, "unix:tmpdir=/tmp", std::vector<uid_t>{});
+    usc::UnityDisplayService display_service{dbus_loop, bus.address(), fake_screen};
+    usc::UnityInputService input_service{dbus_loop, bus.address(), mock_input_configuration};
+    usc::UnityUserActivityEventSink user_activity_sink{bus.address()};
+    std::shared_ptr<usc::DBusConnectionThread> dbus_thread;
+
+    usc::DBusConnectionHandle peer{
+        peer_server->address(), usc::DBusConnectionHandle::Registration::peer};
+};
+
+}
+
+TEST_F(ADBusPeerServer, serves_display_methods_to_peers)
+{
+    using namespace testing;
+
+    EXPECT_CALL(*fake_screen, turn_on(usc::OutputFilter::all));
+
+    call(peer, display_path, display_interface, "TurnOn");
+}
+
+TEST_F(ADBusPeerServer, replies_to_peer_introspection_requests)
+{
+    using namespace testing;
+
+    auto const display_reply = call(
+        peer, display_path, DBUS_INTERFACE_INTROSPECTABLE, "Introspect");
+    auto const input_reply = call(
+        peer, input_path, DBUS_INTERFACE_INTROSPECTABLE, "Introspect");
+
+    EXPECT_THAT(introspection_reply(display_reply), Eq(unity_display_service_introspection));
+    EXPECT_THAT(introspection_reply(input_reply), Eq(unity_input_service_introspection));
+}
+
+TEST_F(ADBusPeerServer, sends_signals_to_peers)
+{
+    ASSERT_TRUE(wait_for_peers(1));
+
+    user_activity_sink.notify_activity_changing_power_state();
+    fake_screen->active_outputs_handler({2, 1});
+
+    EXPECT_TRUE(wait_for_signal(peer, "com.canonical.Unity.UserActivity", "Activity"));
+    EXPECT_TRUE(wait_for_signal(peer, DBUS_INTERFACE_PROPERTIES, "PropertiesChanged"));
+}
+
+TEST_F(ADBusPeerServer, numbers_signals_to_peers_with_the_peer_connection_serials)
+{
+    using namespace testing;
+
+    ASSERT_TRUE(wait_for_peers(1));
+
+    // The replies take the first serials of the peer connection, which the
+    // bus connections have also used for their own messages
+    std::vector<dbus_uint32_t> serials;
+    for (int i = 0; i < 5; ++i)
+    {
+        auto const reply = call(peer, display_path, DBUS_INTERFACE_INTROSPECTABLE, "Introspect");
+        serials.push_back(dbus_message_get_serial(reply));
+    }
+
+    user_activity_sink.notify_activity_changing_power_state();
+    auto const activity = wait_for_signal(peer, "com.canonical.Unity.UserActivity", "Activity");
+    ASSERT_TRUE(activity);
+    serials.push_back(dbus_message_get_serial(activity));
+
+    fake_screen->active_outputs_handler({2, 1});
+    auto const properties_changed =
+        wait_for_signal(peer, DBUS_INTERFACE_PROPERTIES, "PropertiesChanged");
+    ASSERT_TRUE(properties_changed);
+    serials.push_back(dbus_message_get_serial(properties_changed));
+
+    EXPECT_THAT(serials, ElementsAre(1u, 2u, 3u, 4u, 5u, 6u, 7u));
+}
+
+TEST_F(ADBusPeerServer, forgets_disconnected_peers)
+{
+    {
+        usc::DBusConnectionHandle other_peer{
+            peer_server->address(), usc::DBusConnectionHandle::Registration::peer};
+
+        EXPECT_TRUE(wait_for_peers(2));
+    }
+
+    EXPECT_TRUE(wait_for_peers(1));
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "src/unity_debug_service.h"
+#include "src/dbus_connection_thread.h"
+#include "src/dbus_event_loop.h"
+#include "src/dbus_event_loop_pool.h"
+#include "src/unity_input_service.h"
+#include "src/unity_debug_service_introspection.h"
+
+#include "dbus_bus.h"
+#include "dbus_client.h"
+#include "spin_wait.h"
+#include "unity_input_dbus_client.h"
+
+#include "usc/test/mock_input_configuration.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace ut = usc::test;
+using namespace testing;
+
+namespace
+{
+
+char const* const unity_debug_interface = "com.canonical.Unity.Debug";
+
+class UnityDebugDBusClient : public ut::DBusClient
+{
+public:
+    UnityDebugDBusClient(std::string const& address)
+        : ut::DBusClient{
+            address,
+            "com.canonical.Unity.Debug",
+            "/com/canonical/Unity/Debug"}
+    {
+    }
+
+    ut::DBusAsyncReplyString request_introspection()
+    {
+        return invoke_with_reply<ut::DBusAsyncReplyString>(
+            "org.freedesktop.DBus.Introspectable", "Introspect",
+            DBUS_TYPE_INVALID);
+    }
+
+    ut::DBusAsyncReplyVoid request_set_dbus_instrumentation(bool enabled)
+    {
+        dbus_bool_t const dbus_enabled{enabled};
+        return invoke_with_reply<ut::DBusAsyncReplyVoid>(
+            unity_debug_interface, "SetDBusInstrumentation",
+            DBUS_TYPE_BOOLEAN, &dbus_enabled,
+            DBUS_TYPE_INVALID);
+    }
+
+    ut::DBusAsyncReplyString request_get_dbus_stats()
+    {
+        return invoke_with_reply<ut::DBusAsyncReplyString>(
+            unity_debug_interface, "GetDBusStats",
+            DBUS_TYPE_INVALID);
+    }
+
+    ut::DBusAsyncReplyVoid request_reset_dbus_stats()
+    {
+        return invoke_with_reply<ut::DBusAsyncReplyVoid>(
+            unity_debug_interface, "ResetDBusStats",
+            DBUS_TYPE_INVALID);
+    }
+};
+
+std::shared_ptr<usc::DBusEventLoopPool> make_pool(int num_loops)
+{
+    std::vector<std::shared_ptr<usc::DBusEventLoop>> loops;
+    for (int i = 0; i < num_loops; ++i)
+        loops.push_back(std::make_shared<usc::DBusEventLoop>());
+
+    return std::make_shared<usc::DBusEventLoopPool>(loops);
+}
+
+struct AUnityDebugService : testing::Test
+{
+    ut::DBusBus bus;
+
+    UnityDebugDBusClient client{bus.address()};
+    ut::UnityInputDBusClient input_client{bus.address()};
+    std::shared_ptr<ut::MockInputConfiguration> const mock_input_configuration =
+        std::make_shared<testing::NiceMock<ut::MockInputConfiguration>>();
+    std::shared_ptr<usc::DBusEventLoopPool> const pool = make_pool(2);
+    usc::UnityDebugService service{
+        pool->loop_for("com.canonical.Unity.Debug"), bus.address(), pool};
+    usc::UnityInputService input_service{
+        pool->loop_for("com.canonical.Unity.Input"), bus.address(), mock_input_configuration};
+    std::shared_ptr<usc::DBusConnectionThread> const dbus_thread =
+        std::make_shared<usc::DBusConnectionThread>(pool);
+
+    std::string const input_method{"com.canonical.Unity.Input.setMousePrimaryButton"};
+
+    // Handler times are recorded after the handler has replied, so the
+    // stats can lag behind the reply
+    bool wait_for_stats_with(std::string const& text)
+    {
+        return ut::spin_wait_for_condition_or_timeout(
+            [&] { return client.request_get_dbus_stats().get().find(text) != std::string::npos; },
+            std::chrono::seconds{5});
+    }
+};
+
+}
+
+TEST_F(AUnityDebugService, replies_to_introspection_request)
+{
+    auto reply = client.request_introspection();
+    EXPECT_THAT(reply.get(), Eq(unity_debug_service_introspection));
+}
+
+TEST_F(AUnityDebugService, enables_instrumentation_on_all_loops)
+{
+    client.request_set_dbus_instrumentation(true).get();
+
+    for (auto const& loop : pool->loops())
+        EXPECT_TRUE(loop->instrumentation_enabled());
+
+    client.request_set_dbus_instrumentation(false).get();
+
+    for (auto const& loop : pool->loops())
+        EXPECT_FALSE(loop->instrumentation_enabled());
+}
+
+TEST_F(AUnityDebugService, reports_handler_times_of_other_services_while_enabled)
+{
+    client.request_set_dbus_instrumentation(true).get();
+    input_client.request_set_mouse_primary_button(1).get();
+
+    EXPECT_TRUE(wait_for_stats_with("method " + input_method + ": calls=1"));
+    auto const stats = client.request_get_dbus_stats().get();
+
+    EXPECT_THAT(stats, HasSubstr("USC/DBus-0:"));
+    EXPECT_THAT(stats, HasSubstr("USC/DBus-1:"));
+    EXPECT_THAT(stats, HasSubstr("method " + input_method + ": calls=1"));
+}
+
+TEST_F(AUnityDebugService, records_nothing_while_disabled)
+{
+    input_client.request_set_mouse_primary_button(1).get();
+
+    auto const stats = client.request_get_dbus_stats().get();
+
+    EXPECT_THAT(stats, Not(HasSubstr(input_method)));
+}
+
+TEST_F(AUnityDebugService, forgets_recorded_stats_on_reset)
+{
+    client.request_set_dbus_instrumentation(true).get();
+    input_client.request_set_mouse_primary_button(1).get();
+    EXPECT_TRUE(wait_for_stats_with(input_method));
+
+    client.request_reset_dbus_stats().get();
+
+    auto const stats = client.request_get_dbus_stats().get();
+    EXPECT_THAT(stats, Not(HasSubstr(input_method)));
+}
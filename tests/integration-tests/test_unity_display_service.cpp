@@ -23,9 +23,12 @@
 #include "src/dbus_connection_thread.h"
 #include "src/dbus_event_loop.h"
 #include "src/dbus_message_handle.h"
+#include "src/dbus_marshalling.h"
 #include "src/screen.h"
+#include "src/clock.h"
 #include "src/unity_display_service_introspection.h"
 #include "wait_condition.h"
+#include "spin_wait.h"
 #include "dbus_bus.h"
 #include "dbus_client.h"
 #include "unity_display_dbus_client.h"
@@ -36,6 +39,9 @@
 
 #include <stdexcept>
 #include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
 
 namespace ut = usc::test;
 
@@ -62,10 +68,88 @@ struct FakeScreen : ut::MockScreen
         active_outputs_handler(active_outputs);
     }
 
+    void register_output_states_handler(void * /*ownerKey*/, usc::OutputStatesHandler const& handler)
+    {
+        std::lock_guard<std::mutex> lock{active_outputs_mutex};
+        output_states_handler = handler;
+    }
+
+    void unregister_output_states_handler(void * /*ownerKey*/)
+    {
+        std::lock_guard<std::mutex> lock{active_outputs_mutex};
+        output_states_handler = [](std::vector<usc::OutputState> const&){};
+    }
+
+    void notify_output_states(std::vector<usc::OutputState> const& output_states)
+    {
+        std::lock_guard<std::mutex> lock{active_outputs_mutex};
+        output_states_handler(output_states);
+    }
+
     std::mutex active_outputs_mutex;
     usc::ActiveOutputsHandler active_outputs_handler{[](usc::ActiveOutputs const&){}};
+    usc::OutputStatesHandler output_states_handler{[](std::vector<usc::OutputState> const&){}};
 };
 
+usc::OutputState output_state(int32_t id, bool external, MirPowerMode power_mode)
+{
+    usc::OutputState state;
+    state.id = id;
+    state.external = external;
+    state.power_mode = power_mode;
+    state.width = 1080;
+    state.height = 1920;
+    state.refresh_rate = 60.0;
+    return state;
+}
+
+using OutputTuple = std::tuple<int32_t, std::string, std::string, int32_t, int32_t, double>;
+
+// Reads the first property of the a{sv} at iter
+usc::ActiveOutputs active_outputs_from_properties(
+    DBusMessageIter* iter, std::string& property_name)
+{
+    DBusMessageIter iter_properties;
+    dbus_message_iter_recurse(iter, &iter_properties);
+    DBusMessageIter iter_property;
+    dbus_message_iter_recurse(&iter_properties, &iter_property);
+
+    char const* property_name_cstr{""};
+    usc::ActiveOutputs active_outputs{-1, -1};
+
+    dbus_message_iter_get_basic(&iter_property, &property_name_cstr);
+    property_name = property_name_cstr;
+
+    dbus_message_iter_next(&iter_property);
+    DBusMessageIter iter_variant;
+    DBusMessageIter iter_values;
+    dbus_message_iter_recurse(&iter_property, &iter_variant);
+    dbus_message_iter_recurse(&iter_variant, &iter_values);
+
+    dbus_message_iter_get_basic(&iter_values, &active_outputs.internal);
+    dbus_message_iter_next(&iter_values);
+    dbus_message_iter_get_basic(&iter_values, &active_outputs.external);
+
+    return active_outputs;
+}
+
+usc::ActiveOutputs active_outputs_from_signal(
+    DBusMessage* message, std::string& property_name)
+{
+    DBusMessageIter iter;
+    dbus_message_iter_init(message, &iter);
+    dbus_message_iter_next(&iter);
+    return active_outputs_from_properties(&iter, property_name);
+}
+
+usc::ActiveOutputs active_outputs_from_all_properties(DBusMessage* message)
+{
+    DBusMessageIter iter;
+    dbus_message_iter_init(message, &iter);
+    std::string property_name;
+    return active_outputs_from_properties(&iter, property_name);
+}
+
 struct AUnityDisplayService : testing::Test
 {
     ut::DBusBus bus;
@@ -80,6 +164,66 @@ struct AUnityDisplayService : testing::Test
         std::make_shared<usc::DBusConnectionThread>(dbus_loop);
 };
 
+struct FrozenClock : usc::Clock
+{
+    mir::time::Timestamp now() const override
+    {
+        return mir::time::Timestamp{};
+    }
+};
+
+struct AUnityDisplayServiceWithFrozenClock : testing::Test
+{
+    ut::DBusBus bus;
+
+    std::shared_ptr<FakeScreen> const fake_screen =
+        std::make_shared<testing::NiceMock<FakeScreen>>();
+    ut::UnityDisplayDBusClient client{bus.address()};
+    std::shared_ptr<usc::DBusEventLoop> const dbus_loop =
+        std::make_shared<usc::DBusEventLoop>(
+            1, usc::DBusEventLoop::Trigger::level, std::make_shared<FrozenClock>());
+    usc::UnityDisplayService service{dbus_loop, bus.address(), fake_screen};
+    std::shared_ptr<usc::DBusConnectionThread> const dbus_thread =
+        std::make_shared<usc::DBusConnectionThread>(dbus_loop);
+};
+
+// Allows two calls at once, and then one a minute
+struct ARateLimitedUnityDisplayService : testing::Test
+{
+    // Returns the number of replies that were errors
+    int error_replies(std::vector<ut::DBusAsyncReplyVoid>& replies)
+    {
+        int errors{0};
+
+        for (auto& reply : replies)
+        {
+            try
+            {
+                reply.get();
+            }
+            catch (std::runtime_error const&)
+            {
+                ++errors;
+            }
+        }
+
+        return errors;
+    }
+
+    ut::DBusBus bus;
+
+    std::shared_ptr<FakeScreen> const fake_screen =
+        std::make_shared<testing::NiceMock<FakeScreen>>();
+    ut::UnityDisplayDBusClient client{bus.address()};
+    ut::UnityDisplayDBusClient other_client{bus.address()};
+    std::shared_ptr<usc::DBusEventLoop> const dbus_loop =
+        std::make_shared<usc::DBusEventLoop>();
+    usc::UnityDisplayService service{
+        dbus_loop, bus.address(), fake_screen, usc::DBusRateLimiter::Limits{1.0 / 60, 2}};
+    std::shared_ptr<usc::DBusConnectionThread> const dbus_thread =
+        std::make_shared<usc::DBusConnectionThread>(dbus_loop);
+};
+
 }
 
 TEST_F(AUnityDisplayService, replies_to_introspection_request)
@@ -118,6 +262,29 @@ TEST_F(AUnityDisplayService, forwards_turn_off_request)
     client.request_turn_off("external");
 }
 
+TEST_F(AUnityDisplayService, replies_to_other_requests_while_turning_on)
+{
+    using namespace testing;
+
+    ut::WaitCondition turn_on_started;
+    ut::WaitCondition turn_on_released;
+
+    EXPECT_CALL(*fake_screen, turn_on(usc::OutputFilter::all))
+        .WillOnce(DoAll(WakeUp(&turn_on_started),
+                        WaitFor(&turn_on_released, std::chrono::seconds{5})));
+
+    auto turn_on_reply = client.request_turn_on("all");
+    turn_on_started.wait_for(std::chrono::seconds{5});
+    EXPECT_TRUE(turn_on_started.woken());
+
+    auto introspection_reply = client.request_introspection();
+    EXPECT_THAT(introspection_reply.get(), Eq(unity_display_service_introspection));
+    EXPECT_FALSE(turn_on_released.woken());
+
+    turn_on_released.wake_up();
+    turn_on_reply.get();
+}
+
 TEST_F(AUnityDisplayService, emits_active_outputs_property_change)
 {
     using namespace testing;
@@ -131,31 +298,64 @@ TEST_F(AUnityDisplayService, emits_active_outputs_property_change)
     // matter that we start listening after the signal has been sent
     auto message = client.listen_for_properties_changed();
 
-    DBusMessageIter iter;
-    dbus_message_iter_init(message, &iter);
-    dbus_message_iter_next(&iter);
-    DBusMessageIter iter_properties;
-    dbus_message_iter_recurse(&iter, &iter_properties);
-    DBusMessageIter iter_property;
-    dbus_message_iter_recurse(&iter_properties, &iter_property);
+    std::string property_name;
+    auto const active_outputs = active_outputs_from_signal(message, property_name);
 
-    char const* property_name{""};
-    usc::ActiveOutputs active_outputs{-1, -1};
+    EXPECT_THAT(property_name, StrEq("ActiveOutputs"));
+    EXPECT_THAT(active_outputs, Eq(expected_active_outputs));
+}
 
-    dbus_message_iter_get_basic(&iter_property, &property_name);
+TEST_F(AUnityDisplayService, emits_only_latest_of_rapid_active_outputs_changes)
+{
+    using namespace testing;
 
-    dbus_message_iter_next(&iter_property);
-    DBusMessageIter iter_variant;
-    DBusMessageIter iter_values;
-    dbus_message_iter_recurse(&iter_property, &iter_variant);
-    dbus_message_iter_recurse(&iter_variant, &iter_values);
+    fake_screen->notify_active_outputs(usc::ActiveOutputs{1, 0});
+    fake_screen->notify_active_outputs(usc::ActiveOutputs{1, 1});
+    fake_screen->notify_active_outputs(usc::ActiveOutputs{2, 1});
 
-    dbus_message_iter_get_basic(&iter_values, &active_outputs.internal);
-    dbus_message_iter_next(&iter_values);
-    dbus_message_iter_get_basic(&iter_values, &active_outputs.external);
+    auto first_message = client.listen_for_properties_changed();
+    auto second_message = client.listen_for_properties_changed();
 
-    EXPECT_THAT(property_name, StrEq("ActiveOutputs"));
-    EXPECT_THAT(active_outputs, Eq(expected_active_outputs));
+    std::string property_name;
+    EXPECT_THAT(active_outputs_from_signal(first_message, property_name), Eq(usc::ActiveOutputs{1, 0}));
+    EXPECT_THAT(active_outputs_from_signal(second_message, property_name), Eq(usc::ActiveOutputs{2, 1}));
+    EXPECT_THAT(service.active_outputs_signals_emitted(), Eq(2u));
+    EXPECT_THAT(service.active_outputs_signals_suppressed(), Eq(1u));
+}
+
+TEST_F(AUnityDisplayServiceWithFrozenClock, emits_lone_active_outputs_change_without_waiting)
+{
+    using namespace testing;
+
+    // The loop's clock never reaches the end of the coalescing window, so
+    // only a signal sent straight away arrives
+    fake_screen->notify_active_outputs(usc::ActiveOutputs{1, 0});
+
+    ASSERT_TRUE(
+        ut::spin_wait_for_condition_or_timeout(
+            [this] { return service.active_outputs_signals_emitted() == 1; },
+            std::chrono::seconds{5}));
+
+    auto message = client.listen_for_properties_changed();
+
+    std::string property_name;
+    EXPECT_THAT(active_outputs_from_signal(message, property_name), Eq(usc::ActiveOutputs{1, 0}));
+}
+
+TEST_F(AUnityDisplayService, does_not_emit_unchanged_active_outputs)
+{
+    using namespace testing;
+
+    fake_screen->notify_active_outputs(usc::ActiveOutputs{1, 0});
+    client.listen_for_properties_changed();
+
+    fake_screen->notify_active_outputs(usc::ActiveOutputs{1, 0});
+
+    EXPECT_TRUE(
+        ut::spin_wait_for_condition_or_timeout(
+            [this] { return service.active_outputs_signals_suppressed() == 1; },
+            std::chrono::seconds{5}));
+    EXPECT_THAT(service.active_outputs_signals_emitted(), Eq(1u));
 }
 
 TEST_F(AUnityDisplayService, returns_active_outputs_property)
@@ -225,6 +425,21 @@ TEST_F(AUnityDisplayService, returns_all_properties)
     EXPECT_THAT(active_outputs, Eq(expected_active_outputs));
 }
 
+TEST_F(AUnityDisplayService, returns_all_properties_with_changed_values)
+{
+    using namespace testing;
+
+    fake_screen->notify_active_outputs(usc::ActiveOutputs{1, 0});
+    client.listen_for_properties_changed();
+    EXPECT_THAT(active_outputs_from_all_properties(client.request_all_properties().get()),
+                Eq(usc::ActiveOutputs{1, 0}));
+
+    fake_screen->notify_active_outputs(usc::ActiveOutputs{1, 1});
+    client.listen_for_properties_changed();
+    EXPECT_THAT(active_outputs_from_all_properties(client.request_all_properties().get()),
+                Eq(usc::ActiveOutputs{1, 1}));
+}
+
 TEST_F(AUnityDisplayService, returns_error_reply_for_unsupported_method)
 {
     using namespace testing;
@@ -235,3 +450,111 @@ TEST_F(AUnityDisplayService, returns_error_reply_for_unsupported_method)
     EXPECT_THAT(dbus_message_get_type(reply_msg), Eq(DBUS_MESSAGE_TYPE_ERROR));
     EXPECT_THAT(dbus_message_get_error_name(reply_msg), StrEq(DBUS_ERROR_FAILED));
 }
+
+TEST_F(AUnityDisplayService, returns_outputs)
+{
+    using namespace testing;
+
+    fake_screen->notify_output_states(
+        {output_state(1, false, mir_power_mode_on), output_state(2, true, mir_power_mode_off)});
+
+    auto const message = client.request_outputs().get();
+
+    std::vector<OutputTuple> outputs;
+    EXPECT_TRUE(usc::dbus_read_args(message, outputs));
+    EXPECT_THAT(outputs, ElementsAre(
+        OutputTuple{1, "internal", "on", 1080, 1920, 60.0},
+        OutputTuple{2, "external", "off", 1080, 1920, 60.0}));
+}
+
+TEST_F(AUnityDisplayService, forwards_per_output_requests)
+{
+    using namespace testing;
+
+    fake_screen->notify_output_states(
+        {output_state(1, false, mir_power_mode_on), output_state(2, true, mir_power_mode_on)});
+
+    InSequence s;
+    EXPECT_CALL(*fake_screen, turn_off_outputs(ElementsAre(2)));
+    EXPECT_CALL(*fake_screen, turn_on_outputs(ElementsAre(1, 2)));
+
+    client.request_turn_off_outputs({2}).get();
+    client.request_turn_on_outputs({1, 2}).get();
+}
+
+TEST_F(AUnityDisplayService, rejects_per_output_requests_for_unknown_outputs)
+{
+    using namespace testing;
+
+    fake_screen->notify_output_states({output_state(1, false, mir_power_mode_on)});
+
+    EXPECT_CALL(*fake_screen, turn_off_outputs(_)).Times(0);
+
+    EXPECT_THROW(client.request_turn_off_outputs({1, 3}).get(), std::runtime_error);
+}
+
+TEST_F(AUnityDisplayService, emits_signals_only_for_changed_outputs)
+{
+    using namespace testing;
+
+    fake_screen->notify_output_states(
+        {output_state(1, false, mir_power_mode_on), output_state(2, true, mir_power_mode_on)});
+    client.listen_for_output_signal();
+    client.listen_for_output_signal();
+
+    fake_screen->notify_output_states(
+        {output_state(1, false, mir_power_mode_on), output_state(2, true, mir_power_mode_off)});
+
+    auto const changed = client.listen_for_output_signal();
+    int32_t id{0};
+    std::string type;
+    std::string power_mode;
+    int32_t width{0};
+    int32_t height{0};
+    double refresh_rate{0.0};
+
+    EXPECT_TRUE(dbus_message_is_signal(changed, client.unity_display_interface, "OutputChanged"));
+    EXPECT_TRUE(usc::dbus_read_args(changed, id, type, power_mode, width, height, refresh_rate));
+    EXPECT_THAT(id, Eq(2));
+    EXPECT_THAT(power_mode, StrEq("off"));
+
+    fake_screen->notify_output_states({output_state(1, false, mir_power_mode_on)});
+
+    auto const removed = client.listen_for_output_signal();
+
+    EXPECT_TRUE(dbus_message_is_signal(removed, client.unity_display_interface, "OutputRemoved"));
+    EXPECT_TRUE(usc::dbus_read_args(removed, id));
+    EXPECT_THAT(id, Eq(2));
+}
+
+TEST_F(ARateLimitedUnityDisplayService, rejects_power_calls_beyond_limit)
+{
+    using namespace testing;
+
+    EXPECT_CALL(*fake_screen, turn_on(usc::OutputFilter::all)).Times(1);
+    EXPECT_CALL(*fake_screen, turn_off(usc::OutputFilter::all)).Times(1);
+
+    std::vector<ut::DBusAsyncReplyVoid> replies;
+    replies.push_back(client.request_turn_on("all"));
+    replies.push_back(client.request_turn_off("all"));
+    replies.push_back(client.request_turn_on("all"));
+    replies.push_back(client.request_turn_off("all"));
+
+    EXPECT_THAT(error_replies(replies), Eq(2));
+}
+
+TEST_F(ARateLimitedUnityDisplayService, limits_each_client_separately)
+{
+    using namespace testing;
+
+    EXPECT_CALL(*fake_screen, turn_on(usc::OutputFilter::all)).Times(3);
+
+    std::vector<ut::DBusAsyncReplyVoid> replies;
+    for (int i = 0; i < 3; ++i)
+        replies.push_back(client.request_turn_on("all"));
+    EXPECT_THAT(error_replies(replies), Eq(1));
+
+    std::vector<ut::DBusAsyncReplyVoid> other_replies;
+    other_replies.push_back(other_client.request_turn_on("all"));
+    EXPECT_THAT(error_replies(other_replies), Eq(0));
+}
@@ -22,6 +22,7 @@
 #include "src/dbus_event_loop.h"
 #include "src/dbus_message_handle.h"
 #include "src/unity_input_service_introspection.h"
+#include "src/dbus_marshalling.h"
 
 #include "wait_condition.h"
 #include "dbus_bus.h"
@@ -30,8 +31,12 @@
 
 #include "usc/test/mock_input_configuration.h"
 
+#include <boost/optional/optional_io.hpp>
+
 #include <stdexcept>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace ut = usc::test;
 
@@ -51,8 +56,86 @@ struct AUnityInputService : testing::Test
     usc::UnityInputService service{dbus_loop, bus.address(), mock_input_configuration};
     std::shared_ptr<usc::DBusConnectionThread> const dbus_thread =
         std::make_shared<usc::DBusConnectionThread>(dbus_loop);
+
+    usc::InputSettings all_settings()
+    {
+        usc::InputSettings settings;
+        settings.mouse_primary_button = 1;
+        settings.mouse_cursor_speed = 0.5;
+        settings.mouse_scroll_speed = 0.25;
+        settings.touchpad_primary_button = 0;
+        settings.touchpad_cursor_speed = 0.75;
+        settings.touchpad_scroll_speed = 0.125;
+        settings.two_finger_scroll = true;
+        settings.tap_to_click = false;
+        settings.disable_touchpad_while_typing = true;
+        settings.disable_touchpad_with_mouse = false;
+        return settings;
+    }
 };
 
+// Allows one call at once, and then one every half second
+struct ARateLimitedUnityInputService : testing::Test
+{
+    ut::DBusBus bus;
+
+    std::shared_ptr<ut::MockInputConfiguration> const mock_input_configuration =
+        std::make_shared<testing::NiceMock<ut::MockInputConfiguration>>();
+    ut::UnityInputDBusClient client{bus.address()};
+    std::shared_ptr<usc::DBusEventLoop> const dbus_loop=
+        std::make_shared<usc::DBusEventLoop>();
+    usc::UnityInputService service{
+        dbus_loop, bus.address(), mock_input_configuration, usc::DBusRateLimiter::Limits{2.0, 1}};
+    std::shared_ptr<usc::DBusConnectionThread> const dbus_thread =
+        std::make_shared<usc::DBusConnectionThread>(dbus_loop);
+};
+
+// The properties dictionary of a GetAll reply or a PropertiesChanged signal
+std::vector<std::string> property_names_in(usc::DBusMessageHandle const& message)
+{
+    DBusMessageIter iter;
+    dbus_message_iter_init(message, &iter);
+    if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_STRING)
+        dbus_message_iter_next(&iter);
+
+    usc::DBusVariantDict properties;
+    std::vector<std::string> names;
+
+    if (usc::DBusMarshal<usc::DBusVariantDict>::read(&iter, properties))
+    {
+        properties.for_each(
+            [&] (char const* name, DBusMessageIter*) { names.push_back(name); return true; });
+    }
+
+    return names;
+}
+
+template<typename T>
+boost::optional<T> property_in(usc::DBusMessageHandle const& message, char const* property_name)
+{
+    DBusMessageIter iter;
+    dbus_message_iter_init(message, &iter);
+    if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_STRING)
+        dbus_message_iter_next(&iter);
+
+    usc::DBusVariantDict properties;
+    boost::optional<T> property;
+
+    if (usc::DBusMarshal<usc::DBusVariantDict>::read(&iter, properties))
+    {
+        properties.for_each(
+            [&] (char const* name, DBusMessageIter* value)
+            {
+                T read;
+                if (name == std::string{property_name} && usc::DBusMarshal<T>::read(value, read))
+                    property = read;
+                return true;
+            });
+    }
+
+    return property;
+}
+
 }
 
 TEST_F(AUnityInputService, replies_to_introspection_request)
@@ -153,3 +236,175 @@ TEST_F(AUnityInputService, forwards_set_touchpad_tap_to_click)
     client.request_set_touchpad_tap_to_click(enable_it);
 }
 
+
+TEST_F(AUnityInputService, applies_configuration_settings_together)
+{
+    using namespace testing;
+
+    usc::InputSettings applied;
+    EXPECT_CALL(*mock_input_configuration, apply_settings(_)).WillOnce(SaveArg<0>(&applied));
+    EXPECT_CALL(*mock_input_configuration, set_mouse_cursor_speed(_)).Times(0);
+
+    client.request_set_configuration(
+        [] (DBusMessageIter* iter_dict)
+        {
+            usc::dbus_append_property(iter_dict, "MouseCursorSpeed", 0.25);
+            usc::dbus_append_property(iter_dict, "TouchpadPrimaryButton", int32_t{1});
+            usc::dbus_append_property(iter_dict, "TouchpadTapToClick", true);
+        }).get();
+
+    EXPECT_THAT(applied.mouse_cursor_speed, Eq(boost::optional<double>{0.25}));
+    EXPECT_THAT(applied.touchpad_primary_button, Eq(boost::optional<int32_t>{1}));
+    EXPECT_THAT(applied.tap_to_click, Eq(boost::optional<bool>{true}));
+    EXPECT_FALSE(applied.mouse_scroll_speed);
+    EXPECT_FALSE(applied.two_finger_scroll);
+}
+
+TEST_F(AUnityInputService, rejects_configuration_with_unknown_setting)
+{
+    using namespace testing;
+
+    EXPECT_CALL(*mock_input_configuration, apply_settings(_)).Times(0);
+
+    auto reply = client.request_set_configuration(
+        [] (DBusMessageIter* iter_dict)
+        {
+            usc::dbus_append_property(iter_dict, "MouseCursorSpeed", 0.25);
+            usc::dbus_append_property(iter_dict, "MouseWheelColour", std::string{"red"});
+        });
+
+    EXPECT_THROW(reply.get(), std::runtime_error);
+}
+
+TEST_F(AUnityInputService, rejects_configuration_with_wrongly_typed_setting)
+{
+    using namespace testing;
+
+    EXPECT_CALL(*mock_input_configuration, apply_settings(_)).Times(0);
+
+    auto reply = client.request_set_configuration(
+        [] (DBusMessageIter* iter_dict)
+        {
+            usc::dbus_append_property(iter_dict, "TouchpadTapToClick", int32_t{1});
+        });
+
+    EXPECT_THROW(reply.get(), std::runtime_error);
+}
+
+TEST_F(AUnityInputService, returns_settings_as_properties)
+{
+    using namespace testing;
+
+    ON_CALL(*mock_input_configuration, current_settings()).WillByDefault(Return(all_settings()));
+    client.request_set_mouse_primary_button(1).get();
+
+    auto const message = client.request_property("MouseCursorSpeed").get();
+
+    DBusMessageIter iter;
+    dbus_message_iter_init(message, &iter);
+    DBusMessageIter iter_variant;
+    dbus_message_iter_recurse(&iter, &iter_variant);
+
+    double speed{0.0};
+    EXPECT_TRUE(usc::DBusMarshal<double>::read(&iter_variant, speed));
+    EXPECT_THAT(speed, Eq(0.5));
+}
+
+TEST_F(AUnityInputService, returns_all_settings_as_properties)
+{
+    using namespace testing;
+
+    ON_CALL(*mock_input_configuration, current_settings()).WillByDefault(Return(all_settings()));
+    client.request_set_mouse_primary_button(1).get();
+
+    auto const message = client.request_all_properties().get();
+
+    EXPECT_THAT(property_names_in(message), SizeIs(10));
+    EXPECT_THAT(property_in<int32_t>(message, "MousePrimaryButton"), Eq(boost::optional<int32_t>{1}));
+    EXPECT_THAT(property_in<double>(message, "TouchpadScrollSpeed"), Eq(boost::optional<double>{0.125}));
+    EXPECT_THAT(property_in<bool>(message, "TouchpadTwoFingerScroll"), Eq(boost::optional<bool>{true}));
+    EXPECT_THAT(property_in<bool>(message, "TouchpadDisableWithMouse"), Eq(boost::optional<bool>{false}));
+}
+
+TEST_F(AUnityInputService, emits_one_properties_changed_for_all_changed_settings)
+{
+    using namespace testing;
+
+    auto settings = all_settings();
+    ON_CALL(*mock_input_configuration, current_settings()).WillByDefault(Return(settings));
+    client.request_set_mouse_primary_button(1).get();
+    client.listen_for_properties_changed();
+
+    settings.mouse_cursor_speed = 0.9;
+    settings.tap_to_click = true;
+    ON_CALL(*mock_input_configuration, current_settings()).WillByDefault(Return(settings));
+
+    client.request_set_configuration(
+        [] (DBusMessageIter* iter_dict)
+        {
+            usc::dbus_append_property(iter_dict, "MouseCursorSpeed", 0.9);
+            usc::dbus_append_property(iter_dict, "MouseScrollSpeed", 0.25);
+            usc::dbus_append_property(iter_dict, "TouchpadTapToClick", true);
+        }).get();
+
+    auto const message = client.listen_for_properties_changed();
+
+    EXPECT_THAT(property_names_in(message), UnorderedElementsAre("MouseCursorSpeed", "TouchpadTapToClick"));
+    EXPECT_THAT(property_in<double>(message, "MouseCursorSpeed"), Eq(boost::optional<double>{0.9}));
+    EXPECT_THAT(property_in<bool>(message, "TouchpadTapToClick"), Eq(boost::optional<bool>{true}));
+}
+
+TEST_F(AUnityInputService, does_not_emit_properties_changed_for_unchanged_settings)
+{
+    using namespace testing;
+
+    auto settings = all_settings();
+    ON_CALL(*mock_input_configuration, current_settings()).WillByDefault(Return(settings));
+    client.request_set_mouse_primary_button(1).get();
+    client.listen_for_properties_changed();
+
+    client.request_set_mouse_scroll_speed(0.25).get();
+
+    settings.touchpad_primary_button = 1;
+    ON_CALL(*mock_input_configuration, current_settings()).WillByDefault(Return(settings));
+    client.request_set_touchpad_primary_button(1).get();
+
+    // Signals arrive in order, so the first one is for the second request
+    auto const message = client.listen_for_properties_changed();
+
+    EXPECT_THAT(property_names_in(message), ElementsAre("TouchpadPrimaryButton"));
+}
+
+TEST_F(ARateLimitedUnityInputService, applies_only_latest_of_setter_calls_beyond_limit)
+{
+    using namespace testing;
+
+    InSequence s;
+    EXPECT_CALL(*mock_input_configuration, set_mouse_cursor_speed(0.1));
+    EXPECT_CALL(*mock_input_configuration, set_mouse_cursor_speed(0.5));
+
+    std::vector<ut::DBusAsyncReplyVoid> replies;
+    for (auto const speed : {0.1, 0.2, 0.3, 0.4, 0.5})
+        replies.push_back(client.request_set_mouse_cursor_speed(speed));
+
+    for (auto& reply : replies)
+        EXPECT_NO_THROW(reply.get());
+}
+
+TEST_F(ARateLimitedUnityInputService, rejects_configuration_calls_beyond_limit)
+{
+    using namespace testing;
+
+    EXPECT_CALL(*mock_input_configuration, apply_settings(_)).Times(1);
+
+    auto const set_speed = [] (DBusMessageIter* iter_dict)
+        {
+            usc::dbus_append_property(iter_dict, "MouseCursorSpeed", 0.9);
+        };
+
+    auto first_reply = client.request_set_configuration(set_speed);
+    auto second_reply = client.request_set_configuration(set_speed);
+
+    EXPECT_NO_THROW(first_reply.get());
+    EXPECT_THROW(second_reply.get(), std::runtime_error);
+}
@@ -21,6 +21,7 @@
 #include "src/dbus_event_loop.h"
 #include "src/dbus_message_handle.h"
 #include "src/unity_display_service.h"
+#include "src/unity_user_activity_event_sink.h"
 #include "src/unity_input_service_introspection.h"
 #include "src/unity_display_service_introspection.h"
 
@@ -33,6 +34,9 @@
 #include "usc/test/mock_input_configuration.h"
 #include "usc/test/mock_screen.h"
 
+#include <atomic>
+#include <string>
+
 namespace ut = usc::test;
 using namespace testing;
 
@@ -41,6 +45,16 @@ namespace
 
 struct UnityServices : testing::Test
 {
+    UnityServices() = default;
+    UnityServices(
+        int max_events_per_wakeup,
+        usc::DBusEventLoop::Trigger trigger,
+        usc::DBusRateLimiter::Limits const& rate_limits)
+        : dbus_loop{std::make_shared<usc::DBusEventLoop>(max_events_per_wakeup, trigger)},
+          rate_limits{rate_limits}
+    {
+    }
+
     std::chrono::seconds const default_timeout{3};
     ut::DBusBus bus;
 
@@ -50,10 +64,72 @@ struct UnityServices : testing::Test
         std::make_shared<testing::NiceMock<ut::MockScreen>>();
     std::shared_ptr<ut::MockInputConfiguration> const mock_input_configuration =
         std::make_shared<testing::NiceMock<ut::MockInputConfiguration>>();
-    std::shared_ptr<usc::DBusEventLoop> const dbus_loop=
-        std::make_shared<usc::DBusEventLoop>();
-    usc::UnityDisplayService screen_service{dbus_loop, bus.address(), mock_screen};
-    usc::UnityInputService input_service{dbus_loop, bus.address(), mock_input_configuration};
+    std::shared_ptr<usc::DBusEventLoop> const dbus_loop{
+        std::make_shared<usc::DBusEventLoop>()};
+    usc::DBusRateLimiter::Limits const rate_limits{usc::DBusRateLimiter::default_limits};
+    usc::UnityDisplayService screen_service{dbus_loop, bus.address(), mock_screen, rate_limits};
+    usc::UnityInputService input_service{
+        dbus_loop, bus.address(), mock_input_configuration, rate_limits};
+    std::shared_ptr<usc::DBusConnectionThread> const dbus_thread =
+        std::make_shared<usc::DBusConnectionThread>(dbus_loop);
+};
+
+// Edge-triggered mode reads as much as possible from each connection per
+// wakeup, so it's where a busy connection has the most messages queued up.
+// Calls aren't rate limited, so that a flood reaches the handlers.
+struct EdgeTriggeredUnityServices : UnityServices
+{
+    EdgeTriggeredUnityServices()
+        : UnityServices{16, usc::DBusEventLoop::Trigger::edge, usc::DBusRateLimiter::Limits{0, 0}}
+    {
+    }
+};
+
+struct RateLimitedUnityServices : UnityServices
+{
+    RateLimitedUnityServices()
+        : UnityServices{16, usc::DBusEventLoop::Trigger::edge, usc::DBusRateLimiter::default_limits}
+    {
+    }
+};
+
+struct UnityServicesOnSharedConnection : testing::Test
+{
+    std::string name_owner(char const* name)
+    {
+        usc::DBusMessageHandle request{
+            dbus_message_new_method_call(
+                "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                "GetNameOwner"),
+            DBUS_TYPE_STRING, &name,
+            DBUS_TYPE_INVALID};
+
+        usc::DBusConnectionHandle connection{bus.address()};
+        usc::DBusMessageHandle reply{
+            dbus_connection_send_with_reply_and_block(connection, request, 3000, nullptr)};
+
+        char const* owner{""};
+        if (reply)
+            dbus_message_get_args(reply, nullptr, DBUS_TYPE_STRING, &owner, DBUS_TYPE_INVALID);
+
+        return owner;
+    }
+
+    ut::DBusBus bus;
+
+    ut::UnityDisplayDBusClient screen_client{bus.address()};
+    ut::UnityInputDBusClient input_client{bus.address()};
+    std::shared_ptr<ut::MockScreen> const mock_screen =
+        std::make_shared<testing::NiceMock<ut::MockScreen>>();
+    std::shared_ptr<ut::MockInputConfiguration> const mock_input_configuration =
+        std::make_shared<testing::NiceMock<ut::MockInputConfiguration>>();
+    std::shared_ptr<usc::DBusEventLoop> const dbus_loop{
+        std::make_shared<usc::DBusEventLoop>()};
+    std::shared_ptr<usc::DBusConnectionHandle> const connection{
+        std::make_shared<usc::DBusConnectionHandle>(bus.address())};
+    usc::UnityDisplayService screen_service{dbus_loop, connection, mock_screen};
+    usc::UnityInputService input_service{dbus_loop, connection, mock_input_configuration};
+    usc::UnityUserActivityEventSink user_activity_sink{connection, dbus_loop};
     std::shared_ptr<usc::DBusConnectionThread> const dbus_thread =
         std::make_shared<usc::DBusConnectionThread>(dbus_loop);
 };
@@ -80,3 +156,111 @@ TEST_F(UnityServices, provides_access_to_input_methods)
 
     input_client.request_set_mouse_scroll_speed(speed);
 }
+
+TEST_F(EdgeTriggeredUnityServices, keep_turn_on_latency_bounded_while_input_service_is_flooded)
+{
+    int const num_flood_requests = 500;
+    auto const flood_handler_duration = std::chrono::milliseconds{1};
+    auto const max_turn_on_latency = std::chrono::milliseconds{100};
+
+    ON_CALL(*mock_input_configuration, set_mouse_scroll_speed(_))
+        .WillByDefault(InvokeWithoutArgs(
+            [flood_handler_duration]
+            {
+                auto const end = std::chrono::steady_clock::now() + flood_handler_duration;
+                while (std::chrono::steady_clock::now() < end);
+            }));
+
+    std::vector<ut::DBusAsyncReplyVoid> flood_replies;
+    for (int i = 0; i < num_flood_requests; ++i)
+        flood_replies.push_back(input_client.request_set_mouse_scroll_speed(1.0));
+
+    // Wait until the service has started working through the flood
+    flood_replies.front().get();
+
+    auto const start = std::chrono::steady_clock::now();
+    screen_client.request_turn_on("all").get();
+    auto const turn_on_latency = std::chrono::steady_clock::now() - start;
+
+    EXPECT_THAT(turn_on_latency, Lt(max_turn_on_latency));
+
+    for (size_t i = 1; i < flood_replies.size(); ++i)
+        flood_replies[i].get();
+}
+
+TEST_F(RateLimitedUnityServices, keep_turn_on_latency_bounded_while_one_client_floods_a_setter)
+{
+    int const num_flood_requests = 500;
+    auto const flood_handler_duration = std::chrono::milliseconds{5};
+    auto const max_turn_on_latency = std::chrono::milliseconds{100};
+    // The burst, and the latest of the held calls as the allowance refills
+    int const max_flood_handler_runs = usc::DBusRateLimiter::default_limits.burst + 10;
+
+    std::atomic<int> flood_handler_runs{0};
+    ON_CALL(*mock_input_configuration, set_mouse_scroll_speed(_))
+        .WillByDefault(InvokeWithoutArgs(
+            [flood_handler_duration, &flood_handler_runs]
+            {
+                ++flood_handler_runs;
+                auto const end = std::chrono::steady_clock::now() + flood_handler_duration;
+                while (std::chrono::steady_clock::now() < end);
+            }));
+
+    std::vector<ut::DBusAsyncReplyVoid> flood_replies;
+    for (int i = 0; i < num_flood_requests; ++i)
+        flood_replies.push_back(input_client.request_set_mouse_scroll_speed(1.0));
+
+    flood_replies.front().get();
+
+    auto const start = std::chrono::steady_clock::now();
+    screen_client.request_turn_on("all").get();
+    auto const turn_on_latency = std::chrono::steady_clock::now() - start;
+
+    for (size_t i = 1; i < flood_replies.size(); ++i)
+        flood_replies[i].get();
+
+    EXPECT_THAT(turn_on_latency, Lt(max_turn_on_latency));
+    EXPECT_THAT(flood_handler_runs.load(), Le(max_flood_handler_runs));
+}
+
+TEST_F(UnityServicesOnSharedConnection, own_all_names_on_one_connection)
+{
+    auto const display_owner = name_owner("com.canonical.Unity.Display");
+
+    EXPECT_THAT(display_owner, StartsWith(":"));
+    EXPECT_THAT(name_owner("com.canonical.Unity.Input"), Eq(display_owner));
+    EXPECT_THAT(name_owner("com.canonical.Unity.UserActivity"), Eq(display_owner));
+}
+
+TEST_F(UnityServicesOnSharedConnection, route_requests_by_object_path)
+{
+    double const speed = 8.0;
+
+    EXPECT_CALL(*mock_input_configuration, set_mouse_scroll_speed(speed));
+    EXPECT_CALL(*mock_screen, turn_on(usc::OutputFilter::all));
+
+    EXPECT_THAT(screen_client.request_introspection().get(), Eq(unity_display_service_introspection));
+    EXPECT_THAT(input_client.request_introspection().get(), Eq(unity_input_service_introspection));
+    input_client.request_set_mouse_scroll_speed(speed).get();
+    screen_client.request_turn_on("all").get();
+}
+
+TEST_F(UnityServicesOnSharedConnection, deliver_event_signals_written_by_the_loop)
+{
+    usc::DBusConnectionHandle listener{bus.address()};
+    listener.add_match("type='signal',interface='com.canonical.Unity.UserActivity'");
+
+    user_activity_sink.notify_activity_changing_power_state();
+
+    auto const timeout = std::chrono::steady_clock::now() + std::chrono::seconds{3};
+    bool received_signal{false};
+    while (!received_signal && std::chrono::steady_clock::now() < timeout)
+    {
+        dbus_connection_read_write(listener, 10);
+        usc::DBusMessageHandle const message{dbus_connection_pop_message(listener)};
+        received_signal =
+            message && dbus_message_is_signal(message, "com.canonical.Unity.UserActivity", "Activity");
+    }
+
+    EXPECT_TRUE(received_signal);
+}
@@ -30,6 +30,9 @@ ut::UnityDisplayDBusClient::UnityDisplayDBusClient(std::string const& address)
         connection.add_match(
             "type='signal',"
             "interface='org.freedesktop.DBus.Properties'");
+        connection.add_match(
+            "type='signal',"
+            "interface='com.canonical.Unity.Display'");
 }
 
 ut::DBusAsyncReplyString ut::UnityDisplayDBusClient::request_introspection()
@@ -99,3 +102,46 @@ usc::DBusMessageHandle ut::UnityDisplayDBusClient::listen_for_properties_changed
         }
     }
 }
+
+ut::DBusAsyncReply ut::UnityDisplayDBusClient::request_outputs()
+{
+    return invoke_with_reply<ut::DBusAsyncReply>(
+        unity_display_interface, "GetOutputs", DBUS_TYPE_INVALID);
+}
+
+ut::DBusAsyncReplyVoid ut::UnityDisplayDBusClient::request_turn_on_outputs(
+    std::vector<int32_t> const& ids)
+{
+    auto const ids_data = ids.data();
+
+    return invoke_with_reply<ut::DBusAsyncReplyVoid>(
+        unity_display_interface, "TurnOnOutputs",
+        DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &ids_data, static_cast<int>(ids.size()),
+        DBUS_TYPE_INVALID);
+}
+
+ut::DBusAsyncReplyVoid ut::UnityDisplayDBusClient::request_turn_off_outputs(
+    std::vector<int32_t> const& ids)
+{
+    auto const ids_data = ids.data();
+
+    return invoke_with_reply<ut::DBusAsyncReplyVoid>(
+        unity_display_interface, "TurnOffOutputs",
+        DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &ids_data, static_cast<int>(ids.size()),
+        DBUS_TYPE_INVALID);
+}
+
+usc::DBusMessageHandle ut::UnityDisplayDBusClient::listen_for_output_signal()
+{
+    while (true)
+    {
+        dbus_connection_read_write(connection, 1);
+        auto msg = usc::DBusMessageHandle{dbus_connection_pop_message(connection)};
+
+        if (msg && (dbus_message_is_signal(msg, unity_display_interface, "OutputChanged") ||
+                    dbus_message_is_signal(msg, unity_display_interface, "OutputRemoved")))
+        {
+            return msg;
+        }
+    }
+}
@@ -21,6 +21,9 @@
 
 #include "dbus_client.h"
 
+#include <cstdint>
+#include <vector>
+
 namespace usc
 {
 namespace test
@@ -37,8 +40,13 @@ public:
     DBusAsyncReply request_active_outputs_property();
     DBusAsyncReply request_all_properties();
     DBusAsyncReply request_invalid_method();
+    DBusAsyncReply request_outputs();
+    DBusAsyncReplyVoid request_turn_on_outputs(std::vector<int32_t> const& ids);
+    DBusAsyncReplyVoid request_turn_off_outputs(std::vector<int32_t> const& ids);
 
     DBusMessageHandle listen_for_properties_changed();
+    // Returns the next OutputChanged or OutputRemoved signal
+    DBusMessageHandle listen_for_output_signal();
 
     char const* const unity_display_interface = "com.canonical.Unity.Display";
 };
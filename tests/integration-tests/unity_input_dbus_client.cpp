@@ -17,6 +17,7 @@
  */
 
 #include "unity_input_dbus_client.h"
+#include "src/dbus_message_handle.h"
 
 namespace ut = usc::test;
 
@@ -26,6 +27,9 @@ ut::UnityInputDBusClient::UnityInputDBusClient(std::string const& address)
         "com.canonical.Unity.Input",
         "/com/canonical/Unity/Input"}
 {
+        connection.add_match(
+            "type='signal',"
+            "interface='org.freedesktop.DBus.Properties'");
 }
 
 ut::DBusAsyncReplyString ut::UnityInputDBusClient::request_introspection()
@@ -111,3 +115,54 @@ ut::DBusAsyncReplyVoid ut::UnityInputDBusClient::request_set_touchpad_disable_wh
 }
 
 
+
+ut::DBusAsyncReplyVoid ut::UnityInputDBusClient::request_set_configuration(
+    std::function<void(DBusMessageIter* iter_dict)> const& append_settings)
+{
+    usc::DBusMessageHandle msg{
+        dbus_message_new_method_call(
+            destination.c_str(),
+            path.c_str(),
+            unity_input_interface,
+            "SetConfiguration")};
+
+    DBusMessageIter iter;
+    dbus_message_iter_init_append(msg, &iter);
+    DBusMessageIter iter_dict;
+    dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &iter_dict);
+    append_settings(&iter_dict);
+    dbus_message_iter_close_container(&iter, &iter_dict);
+
+    return ut::DBusAsyncReplyVoid{send_with_pending(msg)};
+}
+
+ut::DBusAsyncReply ut::UnityInputDBusClient::request_property(char const* name)
+{
+    return invoke_with_reply<ut::DBusAsyncReply>(
+        "org.freedesktop.DBus.Properties", "Get",
+        DBUS_TYPE_STRING, &unity_input_interface,
+        DBUS_TYPE_STRING, &name,
+        DBUS_TYPE_INVALID);
+}
+
+ut::DBusAsyncReply ut::UnityInputDBusClient::request_all_properties()
+{
+    return invoke_with_reply<ut::DBusAsyncReply>(
+        "org.freedesktop.DBus.Properties", "GetAll",
+        DBUS_TYPE_STRING, &unity_input_interface,
+        DBUS_TYPE_INVALID);
+}
+
+usc::DBusMessageHandle ut::UnityInputDBusClient::listen_for_properties_changed()
+{
+    while (true)
+    {
+        dbus_connection_read_write(connection, 1);
+        auto msg = usc::DBusMessageHandle{dbus_connection_pop_message(connection)};
+
+        if (msg && dbus_message_is_signal(msg, "org.freedesktop.DBus.Properties", "PropertiesChanged"))
+        {
+            return msg;
+        }
+    }
+}
@@ -21,6 +21,8 @@
 
 #include "dbus_client.h"
 
+#include <functional>
+
 namespace usc
 {
 namespace test
@@ -43,6 +45,14 @@ public:
     DBusAsyncReplyVoid request_set_touchpad_tap_to_click(bool enabled);
     DBusAsyncReplyVoid request_set_touchpad_disable_with_mouse(bool enabled);
     DBusAsyncReplyVoid request_set_touchpad_disable_while_typing(bool enabled);
+    // append_settings appends the {sv} entries to iter_dict
+    DBusAsyncReplyVoid request_set_configuration(
+        std::function<void(DBusMessageIter* iter_dict)> const& append_settings);
+    DBusAsyncReply request_property(char const* name);
+    DBusAsyncReply request_all_properties();
+
+    DBusMessageHandle listen_for_properties_changed();
+
     char const* const unity_input_interface = "com.canonical.Unity.Input";
 };
 
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/dbus_event_loop.h"
+
+#include "advanceable_timer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ADBusEventLoopWithDelayedActions : testing::Test
+{
+    ADBusEventLoopWithDelayedActions()
+    {
+        std::promise<void> event_loop_started;
+        auto event_loop_started_future = event_loop_started.get_future();
+
+        dbus_loop_thread = std::thread(
+            [this,&event_loop_started]
+            {
+                dbus_event_loop.run(event_loop_started);
+            });
+
+        event_loop_started_future.wait();
+    }
+
+    ~ADBusEventLoopWithDelayedActions()
+    {
+        dbus_event_loop.stop();
+        dbus_loop_thread.join();
+    }
+
+    // Advances the clock, and waits for the loop to complete an iteration
+    // so that it has run any actions that became due
+    void advance_by(std::chrono::milliseconds advance)
+    {
+        timer->advance_by(advance);
+
+        std::promise<void> iteration_done;
+        dbus_event_loop.enqueue([&iteration_done] { iteration_done.set_value(); });
+        iteration_done.get_future().wait();
+    }
+
+    void sync_with_loop()
+    {
+        advance_by(0ms);
+    }
+
+    std::shared_ptr<AdvanceableTimer> const timer{std::make_shared<AdvanceableTimer>()};
+    usc::DBusEventLoop dbus_event_loop{1, usc::DBusEventLoop::Trigger::level, timer};
+    std::thread dbus_loop_thread;
+    std::vector<int> run_actions;
+};
+
+}
+
+TEST_F(ADBusEventLoopWithDelayedActions, runs_action_only_after_delay)
+{
+    dbus_event_loop.enqueue_after(500ms, [this] { run_actions.push_back(1); });
+
+    advance_by(499ms);
+    EXPECT_THAT(run_actions, IsEmpty());
+
+    advance_by(1ms);
+    EXPECT_THAT(run_actions, ElementsAre(1));
+}
+
+TEST_F(ADBusEventLoopWithDelayedActions, runs_actions_in_deadline_order)
+{
+    dbus_event_loop.enqueue_after(300ms, [this] { run_actions.push_back(3); });
+    dbus_event_loop.enqueue_after(100ms, [this] { run_actions.push_back(1); });
+    dbus_event_loop.enqueue_after(200ms, [this] { run_actions.push_back(2); });
+
+    advance_by(150ms);
+    EXPECT_THAT(run_actions, ElementsAre(1));
+
+    advance_by(150ms);
+    EXPECT_THAT(run_actions, ElementsAre(1, 2, 3));
+}
+
+TEST_F(ADBusEventLoopWithDelayedActions, does_not_run_cancelled_action)
+{
+    auto action = dbus_event_loop.enqueue_after(500ms, [this] { run_actions.push_back(1); });
+
+    advance_by(100ms);
+    EXPECT_TRUE(action.cancel());
+
+    advance_by(500ms);
+    EXPECT_THAT(run_actions, IsEmpty());
+    EXPECT_FALSE(action.cancel());
+}
+
+TEST_F(ADBusEventLoopWithDelayedActions, cannot_cancel_action_that_has_run)
+{
+    auto action = dbus_event_loop.enqueue_after(500ms, [this] { run_actions.push_back(1); });
+
+    advance_by(500ms);
+
+    EXPECT_THAT(run_actions, ElementsAre(1));
+    EXPECT_FALSE(action.cancel());
+}
+
+TEST_F(ADBusEventLoopWithDelayedActions, runs_action_scheduled_from_the_loop_thread)
+{
+    dbus_event_loop.enqueue(
+        [this]
+        {
+            dbus_event_loop.enqueue_after(100ms, [this] { run_actions.push_back(1); });
+        });
+    sync_with_loop();
+
+    advance_by(100ms);
+    EXPECT_THAT(run_actions, ElementsAre(1));
+}
+
+TEST_F(ADBusEventLoopWithDelayedActions, measures_action_deadlines_on_the_loop_clock)
+{
+    std::promise<void> unblock_promise;
+    std::promise<void> blocked_promise;
+    dbus_event_loop.enqueue(
+        [&unblock_promise,&blocked_promise]
+        {
+            blocked_promise.set_value();
+            unblock_promise.get_future().wait();
+        });
+    blocked_promise.get_future().wait();
+
+    dbus_event_loop.enqueue(usc::DBusEventLoop::ActionPriority::urgent, 100ms, []{});
+    dbus_event_loop.enqueue(usc::DBusEventLoop::ActionPriority::normal, 300ms, []{});
+
+    timer->advance_by(200ms);
+    unblock_promise.set_value();
+    sync_with_loop();
+
+    EXPECT_THAT(dbus_event_loop.deadline_misses(), Eq(1u));
+}
+
+TEST_F(ADBusEventLoopWithDelayedActions, does_nothing_when_cancelling_empty_handle)
+{
+    usc::DBusEventLoop::DelayedAction action;
+    EXPECT_FALSE(action.cancel());
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "src/dbus_event_loop_stats.h"
+
+#include "src/dbus_method_table.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+TEST(ALatencyHistogram, puts_durations_in_power_of_two_microsecond_buckets)
+{
+    EXPECT_THAT(usc::LatencyHistogram::bucket_for(0ns), Eq(0u));
+    EXPECT_THAT(usc::LatencyHistogram::bucket_for(999ns), Eq(0u));
+    EXPECT_THAT(usc::LatencyHistogram::bucket_for(1us), Eq(1u));
+    EXPECT_THAT(usc::LatencyHistogram::bucket_for(2us), Eq(2u));
+    EXPECT_THAT(usc::LatencyHistogram::bucket_for(3us), Eq(2u));
+    EXPECT_THAT(usc::LatencyHistogram::bucket_for(4us), Eq(3u));
+    EXPECT_THAT(usc::LatencyHistogram::bucket_for(1000us), Eq(10u));
+}
+
+TEST(ALatencyHistogram, puts_very_long_durations_in_the_last_bucket)
+{
+    EXPECT_THAT(usc::LatencyHistogram::bucket_for(1h),
+                Eq(usc::LatencyHistogram::num_buckets - 1));
+}
+
+TEST(ALatencyHistogram, counts_recorded_durations)
+{
+    usc::LatencyHistogram histogram;
+
+    histogram.record(3us);
+    histogram.record(2us);
+    histogram.record(100us);
+
+    auto const counts = histogram.counts();
+    EXPECT_THAT(counts[2], Eq(2u));
+    EXPECT_THAT(counts[7], Eq(1u));
+
+    histogram.reset();
+    EXPECT_THAT(histogram.counts(), Each(Eq(0u)));
+}
+
+namespace
+{
+
+struct ADBusEventLoopStats : testing::Test
+{
+    ADBusEventLoopStats()
+    {
+        methods.add("com.canonical.Unity.Display", "TurnOn", [] (DBusMessage*) {});
+        methods.add("com.canonical.Unity.Display", "TurnOff", [] (DBusMessage*) {});
+        stats.add_methods(methods);
+    }
+
+    usc::DBusMethodTable methods;
+    usc::DBusEventLoopStats stats;
+};
+
+}
+
+TEST_F(ADBusEventLoopStats, reports_handler_times_per_connection_and_method)
+{
+    auto const connection = stats.add_connection(":1.1");
+    auto const turn_on = stats.method_index("com.canonical.Unity.Display", "TurnOn");
+
+    stats.record_handler_time(connection, turn_on, 10us);
+    stats.record_handler_time(connection, turn_on, 30us);
+
+    auto const report = stats.report();
+    EXPECT_THAT(report, HasSubstr("connection :1.1: calls=2 total=40us max=30us"));
+    EXPECT_THAT(report, HasSubstr("method com.canonical.Unity.Display.TurnOn: calls=2 total=40us max=30us"));
+    EXPECT_THAT(report, Not(HasSubstr("TurnOff")));
+}
+
+TEST_F(ADBusEventLoopStats, counts_calls_to_methods_not_in_a_table_together)
+{
+    auto const connection = stats.add_connection(":1.1");
+
+    for (auto const member : {"Made", "Up", "Names"})
+    {
+        auto const method = stats.method_index("com.canonical.Unity.Display", member);
+        EXPECT_THAT(method, Eq(usc::DBusEventLoopStats::other_method));
+        stats.record_handler_time(connection, method, 10us);
+    }
+
+    auto const report = stats.report();
+    EXPECT_THAT(report, HasSubstr("method (other): calls=3 total=30us max=10us"));
+    EXPECT_THAT(report, Not(HasSubstr("Made")));
+}
+
+TEST_F(ADBusEventLoopStats, keeps_one_entry_per_name)
+{
+    EXPECT_THAT(stats.add_connection(":1.1"), Eq(stats.add_connection(":1.1")));
+    EXPECT_THAT(stats.add_connection(":1.2"), Ne(stats.add_connection(":1.1")));
+
+    auto const turn_on = stats.method_index("com.canonical.Unity.Display", "TurnOn");
+    stats.add_methods(methods);
+    EXPECT_THAT(stats.method_index("com.canonical.Unity.Display", "TurnOn"), Eq(turn_on));
+}
+
+TEST_F(ADBusEventLoopStats, reports_last_and_max_action_queue_depth)
+{
+    stats.record_action_queue_depth(5);
+    stats.record_action_queue_depth(2);
+
+    EXPECT_THAT(stats.report(), HasSubstr("action_queue_depth: last=2 max=5"));
+}
+
+TEST_F(ADBusEventLoopStats, forgets_everything_on_reset)
+{
+    stats.record_handler_time(
+        stats.add_connection(":1.1"),
+        stats.method_index("com.canonical.Unity.Display", "TurnOn"),
+        10us);
+    stats.record_wake_up_to_dispatch(10us);
+    stats.reset();
+
+    auto const report = stats.report();
+    EXPECT_THAT(report, Not(HasSubstr("TurnOn")));
+    EXPECT_THAT(report, HasSubstr("wake_up_to_dispatch:\n"));
+}
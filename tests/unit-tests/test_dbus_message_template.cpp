@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/dbus_message_template.h"
+#include "src/dbus_message_handle.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+
+using namespace testing;
+
+namespace
+{
+
+usc::DBusMessageTemplate activity_signal(int32_t activity)
+{
+    usc::DBusMessageHandle signal{
+        dbus_message_new_signal("/com/TestService", "com.Test", "Activity"),
+        DBUS_TYPE_INT32, &activity,
+        DBUS_TYPE_INVALID};
+
+    return usc::DBusMessageTemplate{signal};
+}
+
+usc::DBusMessageHandle method_call(dbus_uint32_t serial, char const* sender)
+{
+    usc::DBusMessageHandle call{
+        dbus_message_new_method_call(nullptr, "/com/TestService", "com.Test", "Get")};
+    dbus_message_set_serial(call, serial);
+    dbus_message_set_sender(call, sender);
+    return call;
+}
+
+int32_t int32_arg(DBusMessage* message)
+{
+    int32_t value{-1};
+    dbus_message_get_args(message, nullptr, DBUS_TYPE_INT32, &value, DBUS_TYPE_INVALID);
+    return value;
+}
+
+}
+
+TEST(ADBusMessageTemplate, instantiates_copies_of_the_template)
+{
+    auto const signal_template = activity_signal(7);
+
+    auto const first = signal_template.instantiate();
+    auto const second = signal_template.instantiate();
+
+    EXPECT_THAT(static_cast<DBusMessage*>(first), Ne(static_cast<DBusMessage*>(second)));
+    EXPECT_TRUE(dbus_message_is_signal(first, "com.Test", "Activity"));
+    EXPECT_TRUE(dbus_message_is_signal(second, "com.Test", "Activity"));
+    EXPECT_THAT(int32_arg(first), Eq(7));
+    EXPECT_THAT(int32_arg(second), Eq(7));
+}
+
+TEST(ADBusMessageTemplate, instantiates_copies_without_a_serial)
+{
+    auto const signal_template = activity_signal(7);
+
+    auto const first = signal_template.instantiate();
+    dbus_message_set_serial(first, 10);
+    auto const second = signal_template.instantiate();
+
+    EXPECT_THAT(dbus_message_get_serial(second), Eq(0u));
+}
+
+TEST(ADBusMessageTemplate, addresses_replies_to_the_method_call)
+{
+    int32_t const value{5};
+    auto const reply_template = usc::DBusMessageTemplate::method_return(
+        DBUS_TYPE_INT32, &value, DBUS_TYPE_INVALID);
+
+    auto const call = method_call(42, ":1.7");
+    auto const reply = reply_template.instantiate_reply(call);
+
+    EXPECT_THAT(dbus_message_get_type(reply), Eq(DBUS_MESSAGE_TYPE_METHOD_RETURN));
+    EXPECT_THAT(dbus_message_get_reply_serial(reply), Eq(42u));
+    EXPECT_THAT(dbus_message_get_destination(reply), StrEq(":1.7"));
+    EXPECT_THAT(int32_arg(reply), Eq(5));
+}
+
+TEST(ADBusMessageTemplate, refuses_to_instantiate_an_empty_template)
+{
+    usc::DBusMessageTemplate const empty;
+
+    EXPECT_FALSE(empty);
+    EXPECT_THROW(empty.instantiate(), std::logic_error);
+}
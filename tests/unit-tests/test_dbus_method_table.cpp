@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "src/dbus_method_table.h"
+#include "src/dbus_message_handle.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+#include <string>
+
+using namespace testing;
+
+namespace
+{
+
+char const* const test_path = "/com/TestService";
+
+usc::DBusMessageHandle method_call(char const* interface, char const* member)
+{
+    return usc::DBusMessageHandle{
+        dbus_message_new_method_call(nullptr, test_path, interface, member)};
+}
+
+struct ADBusMethodTable : testing::Test
+{
+    ADBusMethodTable()
+    {
+        table.add("com.Test.A", "Get", [this] (DBusMessage*) { called += "A.Get "; });
+        table.add("com.Test.A", "Set", [this] (DBusMessage*) { called += "A.Set "; });
+        table.add("com.Test.B", "Get", [this] (DBusMessage*) { called += "B.Get "; });
+    }
+
+    usc::DBusMethodTable table;
+    std::string called;
+};
+
+}
+
+TEST_F(ADBusMethodTable, dispatches_calls_by_interface_and_member)
+{
+    EXPECT_TRUE(table.dispatch(method_call("com.Test.B", "Get")));
+    EXPECT_TRUE(table.dispatch(method_call("com.Test.A", "Set")));
+    EXPECT_TRUE(table.dispatch(method_call("com.Test.A", "Get")));
+
+    EXPECT_THAT(called, Eq("B.Get A.Set A.Get "));
+}
+
+TEST_F(ADBusMethodTable, rejects_unknown_methods)
+{
+    EXPECT_FALSE(table.dispatch(method_call("com.Test.B", "Set")));
+    EXPECT_FALSE(table.dispatch(method_call("com.Test.C", "Get")));
+    EXPECT_FALSE(table.dispatch(method_call("com.Test.AG", "et")));
+
+    EXPECT_THAT(called, Eq(""));
+}
+
+TEST_F(ADBusMethodTable, dispatches_calls_without_interface_to_first_matching_member)
+{
+    EXPECT_TRUE(table.dispatch(method_call(nullptr, "Get")));
+    EXPECT_TRUE(table.dispatch(method_call(nullptr, "Set")));
+    EXPECT_FALSE(table.dispatch(method_call(nullptr, "Unknown")));
+
+    EXPECT_THAT(called, Eq("A.Get A.Set "));
+}
+
+TEST_F(ADBusMethodTable, refuses_duplicate_methods)
+{
+    EXPECT_THROW({ table.add("com.Test.A", "Get", [] (DBusMessage*) {}); }, std::logic_error);
+}
+
+TEST_F(ADBusMethodTable, runs_wrapped_handler_in_place_of_original)
+{
+    table.wrap("com.Test.A", "Set",
+        [this] (usc::DBusMethodTable::Handler const& handler)
+        {
+            return [this, handler] (DBusMessage* message)
+                {
+                    called += "before ";
+                    handler(message);
+                };
+        });
+
+    EXPECT_TRUE(table.dispatch(method_call("com.Test.A", "Set")));
+    EXPECT_TRUE(table.dispatch(method_call(nullptr, "Set")));
+    EXPECT_TRUE(table.dispatch(method_call("com.Test.A", "Get")));
+
+    EXPECT_THAT(called, Eq("before A.Set before A.Set A.Get "));
+}
+
+TEST_F(ADBusMethodTable, refuses_to_wrap_unknown_methods)
+{
+    auto const wrap = [] (usc::DBusMethodTable::Handler const& handler) { return handler; };
+
+    EXPECT_THROW({ table.wrap("com.Test.B", "Set", wrap); }, std::logic_error);
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/dbus_rate_limiter.h"
+#include "src/dbus_message_handle.h"
+
+#include "advanceable_timer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <future>
+#include <string>
+#include <thread>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ADBusSenderBuckets : testing::Test
+{
+    // Up to 3 calls at once, and then 10 a second
+    usc::DBusSenderBuckets buckets{10.0, 3};
+    usc::DBusSenderBuckets::TimePoint const start{};
+    usc::DBusSenderBuckets::Duration const zero{usc::DBusSenderBuckets::Duration::zero()};
+};
+
+struct ADBusRateLimiter : testing::Test
+{
+    ADBusRateLimiter()
+    {
+        table.add("com.example.Test", "Set", [this] (DBusMessage*) { ++handled_calls; });
+        limiter.limit(table, "com.example.Test", "Set", usc::DBusRateLimiter::Excess::coalesce);
+
+        std::promise<void> event_loop_started;
+        auto event_loop_started_future = event_loop_started.get_future();
+
+        dbus_loop_thread = std::thread(
+            [this,&event_loop_started]
+            {
+                dbus_event_loop->run(event_loop_started);
+            });
+
+        event_loop_started_future.wait();
+    }
+
+    ~ADBusRateLimiter()
+    {
+        dbus_event_loop->stop();
+        dbus_loop_thread.join();
+    }
+
+    void run_on_loop(std::function<void()> const& action)
+    {
+        std::promise<void> done;
+        dbus_event_loop->enqueue([&action, &done] { action(); done.set_value(); });
+        done.get_future().wait();
+    }
+
+    void call_set(char const* sender)
+    {
+        usc::DBusMessageHandle const method_call{
+            dbus_message_new_method_call(nullptr, "/", "com.example.Test", "Set")};
+        dbus_message_set_sender(method_call, sender);
+
+        run_on_loop([&] { table.dispatch(method_call); });
+    }
+
+    // Advances the clock, and waits for the loop to run any held calls
+    // that became due
+    void advance_by(std::chrono::milliseconds advance)
+    {
+        timer->advance_by(advance);
+        run_on_loop([]{});
+    }
+
+    std::shared_ptr<AdvanceableTimer> const timer{std::make_shared<AdvanceableTimer>()};
+    std::shared_ptr<usc::DBusEventLoop> const dbus_event_loop{
+        std::make_shared<usc::DBusEventLoop>(1, usc::DBusEventLoop::Trigger::level, timer)};
+    usc::DBusMethodTable table;
+    // One call at once, and then 10 a second. Held calls never need the
+    // connection, as there is no newer call to replace them.
+    usc::DBusRateLimiter limiter{dbus_event_loop, nullptr, {10.0, 1}};
+    int handled_calls{0};
+    std::thread dbus_loop_thread;
+};
+
+}
+
+TEST_F(ADBusSenderBuckets, allows_a_burst_of_calls_at_once)
+{
+    EXPECT_THAT(buckets.take_call(":1.1", start), Eq(zero));
+    EXPECT_THAT(buckets.take_call(":1.1", start), Eq(zero));
+    EXPECT_THAT(buckets.take_call(":1.1", start), Eq(zero));
+    EXPECT_THAT(buckets.take_call(":1.1", start), Gt(zero));
+}
+
+TEST_F(ADBusSenderBuckets, says_how_long_until_the_next_call_is_allowed)
+{
+    for (int i = 0; i < 3; ++i)
+        buckets.take_call(":1.1", start);
+
+    auto const delay = buckets.take_call(":1.1", start + 40ms);
+
+    EXPECT_THAT(delay, AllOf(Gt(59ms), Le(61ms)));
+    EXPECT_THAT(buckets.take_call(":1.1", start + 40ms + delay), Eq(zero));
+}
+
+TEST_F(ADBusSenderBuckets, refills_at_the_call_rate_up_to_the_burst)
+{
+    for (int i = 0; i < 3; ++i)
+        buckets.take_call(":1.1", start);
+
+    auto const later = start + 10s;
+    for (int i = 0; i < 3; ++i)
+        EXPECT_THAT(buckets.take_call(":1.1", later), Eq(zero));
+    EXPECT_THAT(buckets.take_call(":1.1", later), Gt(zero));
+}
+
+TEST_F(ADBusSenderBuckets, keeps_an_allowance_per_sender)
+{
+    for (int i = 0; i < 3; ++i)
+        buckets.take_call(":1.1", start);
+
+    EXPECT_THAT(buckets.take_call(":1.1", start), Gt(zero));
+    EXPECT_THAT(buckets.take_call(":1.2", start), Eq(zero));
+}
+
+TEST_F(ADBusSenderBuckets, forgets_senders_that_have_their_full_allowance_again)
+{
+    for (int i = 0; i < 1000; ++i)
+        buckets.take_call(":1." + std::to_string(i), start + i * 1s);
+
+    EXPECT_THAT(buckets.senders(), Lt(100u));
+}
+
+TEST_F(ADBusRateLimiter, runs_a_held_call_once_the_sender_may_call_again_on_the_loop_clock)
+{
+    call_set(":1.1");
+    call_set(":1.1");
+    EXPECT_THAT(handled_calls, Eq(1));
+
+    advance_by(99ms);
+    EXPECT_THAT(handled_calls, Eq(1));
+
+    advance_by(2ms);
+    EXPECT_THAT(handled_calls, Eq(2));
+}
+
+TEST_F(ADBusRateLimiter, refills_allowances_on_the_loop_clock)
+{
+    call_set(":1.1");
+    advance_by(101ms);
+
+    call_set(":1.1");
+    EXPECT_THAT(handled_calls, Eq(2));
+}
@@ -129,3 +129,78 @@ TEST_F(MirInputConfiguration, ignores_keyboard_when_added)
     obs->device_added(mock_keyboard);
 }
 
+
+TEST_F(MirInputConfiguration, applies_settings_with_one_configuration_per_device)
+{
+    usc::MirInputConfiguration config(mock_hub);
+    obs->device_added(mock_mouse);
+    obs->device_added(mock_touchpad);
+
+    usc::InputSettings settings;
+    settings.mouse_primary_button = 1;
+    settings.mouse_cursor_speed = 0.9;
+    settings.touchpad_primary_button = 1;
+    settings.touchpad_cursor_speed = 0.9;
+
+    EXPECT_CALL(*mock_mouse, apply_pointer_configuration(_)).Times(1);
+    EXPECT_CALL(*mock_touchpad, apply_pointer_configuration(_)).Times(1);
+    EXPECT_CALL(*mock_touchpad, apply_touchpad_configuration(_)).Times(1);
+    config.apply_settings(settings);
+}
+
+TEST_F(MirInputConfiguration, leaves_touchpads_alone_when_applying_mouse_settings)
+{
+    usc::MirInputConfiguration config(mock_hub);
+    obs->device_added(mock_mouse);
+    obs->device_added(mock_touchpad);
+
+    usc::InputSettings settings;
+    settings.mouse_primary_button = 1;
+
+    EXPECT_CALL(*mock_mouse, apply_pointer_configuration(
+        Truly([] (MirPointerConfig const& conf)
+              {
+                  return conf.handedness() == mir_pointer_handedness_left;
+              })));
+    EXPECT_CALL(*mock_touchpad, apply_pointer_configuration(_)).Times(0);
+    EXPECT_CALL(*mock_touchpad, apply_touchpad_configuration(_)).Times(0);
+    config.apply_settings(settings);
+}
+
+TEST_F(MirInputConfiguration, does_not_reconfigure_devices_for_unchanged_settings)
+{
+    usc::MirInputConfiguration config(mock_hub);
+    obs->device_added(mock_mouse);
+    obs->device_added(mock_touchpad);
+
+    usc::InputSettings settings;
+    settings.mouse_primary_button = 1;
+    settings.touchpad_cursor_speed = 0.9;
+    settings.tap_to_click = true;
+    config.apply_settings(settings);
+
+    EXPECT_CALL(*mock_mouse, apply_pointer_configuration(_)).Times(0);
+    EXPECT_CALL(*mock_touchpad, apply_pointer_configuration(_)).Times(0);
+    EXPECT_CALL(*mock_touchpad, apply_touchpad_configuration(_)).Times(0);
+    config.apply_settings(settings);
+}
+
+TEST_F(MirInputConfiguration, reports_applied_settings)
+{
+    usc::MirInputConfiguration config(mock_hub);
+
+    usc::InputSettings settings;
+    settings.mouse_primary_button = 1;
+    settings.touchpad_scroll_speed = 2.0;
+    settings.tap_to_click = false;
+    settings.two_finger_scroll = true;
+    config.apply_settings(settings);
+
+    auto const current = config.current_settings();
+
+    EXPECT_THAT(*current.mouse_primary_button, Eq(1));
+    EXPECT_THAT(*current.touchpad_primary_button, Eq(0));
+    EXPECT_THAT(*current.touchpad_scroll_speed, DoubleEq(2.0));
+    EXPECT_FALSE(*current.tap_to_click);
+    EXPECT_TRUE(*current.two_finger_scroll);
+}
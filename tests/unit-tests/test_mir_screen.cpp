@@ -30,6 +30,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <utility>
+#include <vector>
+
 using namespace testing;
 
 namespace mg = mir::graphics;
@@ -52,6 +55,28 @@ struct MockDisplayWithExternalOutputs : ut::MockDisplay
     }
 };
 
+// One internal and one external output, both on
+struct MockDisplayWithOneOutputOfEach : ut::MockDisplay
+{
+    std::unique_ptr<mir::graphics::DisplayConfiguration> configuration() const override
+    {
+        return std::make_unique<usc::test::StubDisplayConfiguration>(1, 1, 0);
+    }
+};
+
+std::vector<std::pair<int, MirPowerMode>> power_modes_of(mg::DisplayConfiguration const& conf)
+{
+    std::vector<std::pair<int, MirPowerMode>> power_modes;
+
+    conf.for_each_output(
+        [&power_modes](mg::DisplayConfigurationOutput const& output)
+        {
+            power_modes.emplace_back(output.id.as_value(), output.power_mode);
+        });
+
+    return power_modes;
+}
+
 struct AMirScreen : testing::Test
 {
     void turn_all_displays_off()
@@ -72,6 +97,12 @@ struct AMirScreen : testing::Test
         verify_and_clear_expectations();
     }
 
+    void use_mir_screen_with_one_output_of_each()
+    {
+        display = std::make_shared<testing::NiceMock<MockDisplayWithOneOutputOfEach>>();
+        mir_screen = std::make_shared<usc::MirScreen>(compositor, display);
+    }
+
     void verify_and_clear_expectations()
     {
         Mock::VerifyAndClearExpectations(display.get());
@@ -103,6 +134,13 @@ struct AMirScreen : testing::Test
             active_outputs = active_outputs_arg;
         };
 
+    std::vector<usc::OutputState> output_states;
+    usc::OutputStatesHandler output_states_handler =
+        [this] (std::vector<usc::OutputState> const& output_states_arg)
+        {
+            output_states = output_states_arg;
+        };
+
     std::shared_ptr<usc::MirScreen> mir_screen{
         std::make_shared<usc::MirScreen>(compositor, display)};
 };
@@ -212,3 +250,64 @@ TEST_F(AMirScreen, support_multiple_handlers)
 
     mir_screen->unregister_active_outputs_handler(&display);
 }
+
+TEST_F(AMirScreen, turns_off_only_the_listed_outputs)
+{
+    use_mir_screen_with_one_output_of_each();
+
+    std::vector<std::pair<int, MirPowerMode>> configured_power_modes;
+
+    InSequence s;
+    EXPECT_CALL(*compositor, stop());
+    EXPECT_CALL(*display, configure(_))
+        .WillOnce(Invoke(
+            [&] (mg::DisplayConfiguration const& conf)
+            {
+                configured_power_modes = power_modes_of(conf);
+            }));
+    EXPECT_CALL(*compositor, start());
+
+    mir_screen->turn_off_outputs({2});
+
+    EXPECT_THAT(configured_power_modes, ElementsAre(
+        std::make_pair(1, mir_power_mode_on),
+        std::make_pair(2, mir_power_mode_off)));
+}
+
+TEST_F(AMirScreen, does_not_reconfigure_for_outputs_already_in_the_mode)
+{
+    use_mir_screen_with_one_output_of_each();
+
+    EXPECT_CALL(*compositor, stop()).Times(0);
+    EXPECT_CALL(*display, configure(_)).Times(0);
+
+    mir_screen->turn_on_outputs({1, 2});
+}
+
+TEST_F(AMirScreen, does_not_reconfigure_for_unknown_outputs)
+{
+    EXPECT_CALL(*compositor, stop()).Times(0);
+    EXPECT_CALL(*display, configure(_)).Times(0);
+
+    mir_screen->turn_off_outputs({7});
+}
+
+TEST_F(AMirScreen, output_states_handler_gets_connected_outputs)
+{
+    mir_screen->register_output_states_handler(this, output_states_handler);
+
+    mir_screen->configuration_applied(
+        std::make_shared<ut::StubDisplayConfiguration>(1, 1, 1));
+
+    ASSERT_THAT(output_states, SizeIs(2));
+    EXPECT_THAT(output_states[0].id, Eq(1));
+    EXPECT_FALSE(output_states[0].external);
+    EXPECT_THAT(output_states[0].power_mode, Eq(mir_power_mode_on));
+    EXPECT_THAT(output_states[0].width, Eq(1080));
+    EXPECT_THAT(output_states[0].height, Eq(1920));
+    EXPECT_THAT(output_states[0].refresh_rate, Eq(60.0));
+    EXPECT_THAT(output_states[1].id, Eq(2));
+    EXPECT_TRUE(output_states[1].external);
+
+    mir_screen->unregister_output_states_handler(this);
+}
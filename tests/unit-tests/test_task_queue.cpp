@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/task_queue.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+
+TEST(ATask, runs_move_only_callables)
+{
+    int result{0};
+    auto value = std::make_unique<int>(5);
+
+    usc::Task task{[&result, value = std::move(value)] { result = *value; }};
+    usc::Task moved_task{std::move(task)};
+
+    EXPECT_FALSE(task);
+    moved_task();
+    EXPECT_THAT(result, Eq(5));
+}
+
+TEST(ATask, stores_small_callables_inline)
+{
+    int* p{nullptr};
+    auto small = [p] { (void)p; };
+    std::array<char, 2 * usc::Task::inline_size> big{};
+    auto large = [big] { (void)big; };
+
+    EXPECT_TRUE(usc::Task::is_inline<decltype(small)>());
+    EXPECT_FALSE(usc::Task::is_inline<decltype(large)>());
+}
+
+TEST(ATask, runs_callables_stored_on_the_heap)
+{
+    std::array<int, 4 * usc::Task::inline_size> big{};
+    big.back() = 7;
+    int result{0};
+
+    usc::Task task{[big, &result] { result = big.back(); }};
+    usc::Task moved_task;
+    moved_task = std::move(task);
+    moved_task();
+
+    EXPECT_THAT(result, Eq(7));
+}
+
+TEST(ATaskQueue, runs_pushed_tasks_in_order)
+{
+    usc::TaskQueue queue{8};
+    std::vector<int> order;
+
+    for (int i = 0; i < 5; ++i)
+        queue.push([&order, i] { order.push_back(i); });
+
+    EXPECT_THAT(queue.run_pending(), Eq(5u));
+    EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4));
+    EXPECT_THAT(queue.run_pending(), Eq(0u));
+}
+
+TEST(ATaskQueue, keeps_order_when_ring_overflows)
+{
+    usc::TaskQueue queue{4};
+    std::vector<int> order;
+    std::vector<int> expected;
+
+    for (int i = 0; i < 20; ++i)
+    {
+        queue.push([&order, i] { order.push_back(i); });
+        expected.push_back(i);
+    }
+
+    queue.run_pending();
+    EXPECT_THAT(order, ContainerEq(expected));
+
+    // The ring is usable again once the overflow has been consumed
+    order.clear();
+    queue.push([&order] { order.push_back(100); });
+    queue.run_pending();
+    EXPECT_THAT(order, ElementsAre(100));
+}
+
+TEST(ATaskQueue, runs_at_most_the_requested_number_of_tasks_in_order)
+{
+    usc::TaskQueue queue{4};
+    std::vector<int> order;
+    std::vector<int> expected;
+
+    for (int i = 0; i < 20; ++i)
+    {
+        queue.push([&order, i] { order.push_back(i); });
+        expected.push_back(i);
+    }
+
+    while (queue.run_pending(3) == 3)
+    {
+        // Tasks pushed while the overflow is being consumed come after it
+        queue.push([&order] { order.push_back(100); });
+        expected.push_back(100);
+    }
+    queue.run_pending();
+
+    EXPECT_THAT(order, ContainerEq(expected));
+}
+
+TEST(ATaskQueue, does_not_run_tasks_pushed_by_running_tasks)
+{
+    usc::TaskQueue queue;
+    int runs{0};
+
+    queue.push([&] { ++runs; queue.push([&] { ++runs; }); });
+
+    EXPECT_THAT(queue.run_pending(), Eq(1u));
+    EXPECT_THAT(queue.run_pending(), Eq(1u));
+    EXPECT_THAT(runs, Eq(2));
+}
+
+TEST(ATaskQueue, runs_all_tasks_from_concurrent_producers_in_per_producer_order)
+{
+    int const num_producers = 4;
+    int const tasks_per_producer = 50000;
+
+    usc::TaskQueue queue{256};
+    std::array<int, num_producers> last_seen;
+    last_seen.fill(-1);
+    bool in_order{true};
+    int total_run{0};
+    std::atomic<int> producers_done{0};
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p)
+    {
+        producers.emplace_back(
+            [&, p]
+            {
+                for (int i = 0; i < tasks_per_producer; ++i)
+                {
+                    queue.push(
+                        [&, p, i]
+                        {
+                            in_order = in_order && last_seen[p] == i - 1;
+                            last_seen[p] = i;
+                            ++total_run;
+                        });
+                }
+                ++producers_done;
+            });
+    }
+
+    while (producers_done < num_producers ||
+           total_run < num_producers * tasks_per_producer)
+    {
+        queue.run_pending();
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_THAT(total_run, Eq(num_producers * tasks_per_producer));
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 UBports foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/timer_queue.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <vector>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct ATimerQueue : Test
+{
+    void run_due(usc::TimerQueue::TimePoint now)
+    {
+        std::vector<usc::Task> due;
+        timer_queue.take_due(now, due);
+        for (auto& task : due)
+            task();
+    }
+
+    usc::TimerQueue timer_queue;
+    usc::TimerQueue::TimePoint const start{std::chrono::steady_clock::now()};
+    std::vector<int> fired;
+};
+
+}
+
+TEST_F(ATimerQueue, has_no_deadline_when_empty)
+{
+    usc::TimerQueue::TimePoint deadline;
+    EXPECT_FALSE(timer_queue.next_deadline(deadline));
+}
+
+TEST_F(ATimerQueue, reports_earliest_deadline)
+{
+    timer_queue.add(start + 30ms, []{});
+    timer_queue.add(start + 10ms, []{});
+    timer_queue.add(start + 20ms, []{});
+
+    usc::TimerQueue::TimePoint deadline;
+    ASSERT_TRUE(timer_queue.next_deadline(deadline));
+    EXPECT_THAT(deadline, Eq(start + 10ms));
+}
+
+TEST_F(ATimerQueue, takes_only_due_tasks_in_deadline_order)
+{
+    timer_queue.add(start + 30ms, [this] { fired.push_back(3); });
+    timer_queue.add(start + 10ms, [this] { fired.push_back(1); });
+    timer_queue.add(start + 20ms, [this] { fired.push_back(2); });
+
+    run_due(start + 20ms);
+
+    EXPECT_THAT(fired, ElementsAre(1, 2));
+    EXPECT_THAT(timer_queue.size(), Eq(1u));
+}
+
+TEST_F(ATimerQueue, takes_tasks_with_equal_deadlines_in_insertion_order)
+{
+    for (int i = 0; i < 5; ++i)
+        timer_queue.add(start, [this,i] { fired.push_back(i); });
+
+    run_due(start);
+
+    EXPECT_THAT(fired, ElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST_F(ATimerQueue, does_not_run_cancelled_tasks)
+{
+    timer_queue.add(start + 10ms, [this] { fired.push_back(1); });
+    auto const id = timer_queue.add(start + 5ms, [this] { fired.push_back(2); });
+
+    EXPECT_TRUE(timer_queue.cancel(id));
+    EXPECT_FALSE(timer_queue.is_pending(id));
+
+    usc::TimerQueue::TimePoint deadline;
+    ASSERT_TRUE(timer_queue.next_deadline(deadline));
+    EXPECT_THAT(deadline, Eq(start + 10ms));
+
+    run_due(start + 10ms);
+    EXPECT_THAT(fired, ElementsAre(1));
+}
+
+TEST_F(ATimerQueue, does_not_cancel_tasks_already_taken)
+{
+    auto const id = timer_queue.add(start, []{});
+
+    run_due(start);
+
+    EXPECT_FALSE(timer_queue.cancel(id));
+}
+
+TEST_F(ATimerQueue, stays_consistent_after_many_cancellations)
+{
+    std::vector<usc::TimerQueue::Id> ids;
+    for (int i = 0; i < 1000; ++i)
+        ids.push_back(timer_queue.add(start + std::chrono::milliseconds{i}, [this,i] { fired.push_back(i); }));
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (i % 100 != 0)
+            timer_queue.cancel(ids[i]);
+    }
+
+    EXPECT_THAT(timer_queue.size(), Eq(10u));
+
+    run_due(start + 1000ms);
+    EXPECT_THAT(fired, ElementsAre(0, 100, 200, 300, 400, 500, 600, 700, 800, 900));
+}
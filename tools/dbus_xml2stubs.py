@@ -0,0 +1,496 @@
+#!/usr/bin/env python3
+# coding: utf-8
+
+# Copyright (C) 2026 UBports foundation.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Generates a C++ header with typed server stubs for the interfaces in a
+# D-Bus introspection XML file:
+#
+#   dbus_xml2stubs.py <xml> <class name> <header>
+#
+# The generated class has a pure virtual dbus_<Method>() for each method
+# and dbus_get_<Property>() for each property, and add_dbus_methods(), which
+# adds handlers for all of them to a DBusMethodTable. The handlers read the
+# arguments, call the virtual and send the reply, with the D-Bus types fixed
+# at generation time (see src/dbus_marshalling.h). The standard
+# org.freedesktop.DBus interfaces are skipped, except that
+# org.freedesktop.DBus.Properties Get and GetAll are generated for the
+# properties. GetAll replies are kept as DBusMessageTemplates until the
+# implementation calls dbus_properties_changed().
+#
+# Each signal gets a static dbus_<Signal>_signal(), which builds the signal
+# from its arguments for the implementation to send.
+#
+# A dbus_<Method>() can throw std::invalid_argument to reply with an
+# org.freedesktop.DBus.Error.InvalidArgs error instead.
+#
+# An in argument annotated with com.canonical.USC.DefaultValue takes that
+# value if the arguments can't be read. Either all the in arguments of a
+# method have defaults or none do.
+#
+# A method annotated with com.canonical.USC.Async set to true doesn't reply
+# when dbus_<Method>() returns. Instead dbus_<Method>() gets a
+# DBusDeferredReply as its last parameter and replies through that, from
+# any thread, once the call has finished.
+
+import keyword
+import os
+import sys
+import xml.etree.ElementTree as ElementTree
+
+default_value_annotation = 'com.canonical.USC.DefaultValue'
+async_annotation = 'com.canonical.USC.Async'
+
+basic_types = {
+    'b': 'bool',
+    'y': 'uint8_t',
+    'i': 'int32_t',
+    'u': 'uint32_t',
+    'x': 'int64_t',
+    't': 'uint64_t',
+    'd': 'double',
+    's': 'std::string',
+}
+
+cpp_keywords = {
+    'and', 'auto', 'bool', 'break', 'case', 'catch', 'char', 'class', 'const',
+    'default', 'delete', 'do', 'double', 'else', 'enum', 'explicit', 'false',
+    'float', 'for', 'if', 'int', 'long', 'namespace', 'new', 'not', 'operator',
+    'or', 'private', 'protected', 'public', 'return', 'short', 'signed',
+    'static', 'struct', 'switch', 'template', 'this', 'true', 'try',
+    'typedef', 'union', 'unsigned', 'using', 'virtual', 'void', 'while',
+}
+
+
+def fail(message):
+    sys.exit('dbus_xml2stubs.py: ' + message)
+
+
+def parse_type(signature, pos=0):
+    """Returns the C++ type of the complete type at pos, and the position
+    after it"""
+    code = signature[pos]
+    if code in basic_types:
+        return basic_types[code], pos + 1
+    if signature.startswith('a{sv}', pos):
+        return 'DBusVariantDict', pos + 5
+    if code == 'a':
+        element, end = parse_type(signature, pos + 1)
+        return 'std::vector<{}>'.format(element), end
+    if code == '(':
+        members = []
+        pos += 1
+        while signature[pos] != ')':
+            member, pos = parse_type(signature, pos)
+            members.append(member)
+        return 'std::tuple<{}>'.format(', '.join(members)), pos + 1
+    fail("unsupported D-Bus type '{}' in '{}'".format(code, signature))
+
+
+def cpp_type(signature):
+    result, end = parse_type(signature)
+    if end != len(signature):
+        fail("'{}' is not a single complete type".format(signature))
+    return result
+
+
+def param_type(signature):
+    result = cpp_type(signature)
+    if signature in basic_types and signature != 's':
+        return result
+    return result + ' const&'
+
+
+def cpp_literal(signature, value):
+    if signature == 's':
+        return '"' + value.replace('\\', '\\\\').replace('"', '\\"') + '"'
+    if signature == 'b':
+        return 'true' if value == 'true' else 'false'
+    if signature in basic_types:
+        return value
+    fail('default values are only supported for basic types')
+
+
+def cpp_name(name, index):
+    if not name:
+        return 'arg{}'.format(index)
+    if name in cpp_keywords or keyword.iskeyword(name):
+        return name + '_'
+    return name
+
+
+class Arg:
+    def __init__(self, element, index):
+        self.name = cpp_name(element.get('name'), index)
+        self.signature = element.get('type')
+        self.type = cpp_type(self.signature)
+        self.default = None
+        for annotation in element.findall('annotation'):
+            if annotation.get('name') == default_value_annotation:
+                self.default = cpp_literal(self.signature, annotation.get('value'))
+
+
+class Method:
+    def __init__(self, interface, element):
+        self.interface = interface
+        self.name = element.get('name')
+        args = element.findall('arg')
+        self.in_args = [Arg(a, i) for i, a in enumerate(args)
+                        if a.get('direction', 'in') == 'in']
+        self.out_args = [Arg(a, i) for i, a in enumerate(args)
+                         if a.get('direction') == 'out']
+
+        defaults = [a.default is not None for a in self.in_args]
+        if any(defaults) and not all(defaults):
+            fail('{}: either all in arguments need a default or none'.format(self.name))
+        self.has_defaults = self.in_args and all(defaults)
+
+        self.is_async = any(a.get('name') == async_annotation and a.get('value') == 'true'
+                            for a in element.findall('annotation'))
+        if self.is_async and self.out_args:
+            fail('{}: asynchronous methods reply through DBusDeferredReply, '
+                 'so their out arguments are not generated'.format(self.name))
+
+    def return_type(self):
+        if self.is_async or not self.out_args:
+            return 'void'
+        if len(self.out_args) == 1:
+            return self.out_args[0].type
+        return 'std::tuple<{}>'.format(', '.join(a.type for a in self.out_args))
+
+    def declaration(self):
+        params = ['{} {}'.format(param_type(a.signature), a.name) for a in self.in_args]
+        if self.is_async:
+            params.append('DBusDeferredReply const& reply')
+        params = ', '.join(params)
+        return 'virtual {} dbus_{}({}) = 0;'.format(self.return_type(), self.name, params)
+
+    def handler(self):
+        lines = []
+        for a in self.in_args:
+            init = a.default if a.default is not None else ''
+            lines.append('{} {}{{{}}};'.format(a.type, a.name, init))
+
+        if self.in_args:
+            read = 'dbus_read_args(message, {})'.format(', '.join(a.name for a in self.in_args))
+            if self.has_defaults:
+                lines.append('if (!{})'.format(read))
+                lines.append('{')
+                for a in self.in_args:
+                    lines.append('    {} = {};'.format(a.name, a.default))
+                lines.append('}')
+            else:
+                lines.append('if (!{})'.format(read))
+                lines.append('{')
+                lines.append('    dbus_send_error(connection, message, "Invalid arguments");')
+                lines.append('    return;')
+                lines.append('}')
+            lines.append('')
+
+        call_args = [a.name for a in self.in_args]
+        if self.is_async:
+            call_args.append('reply')
+        call = 'dbus_{}({})'.format(self.name, ', '.join(call_args))
+        calls = []
+        if self.is_async:
+            lines.append('DBusDeferredReply const reply{loop, connection_handle, message};')
+            calls.append(call + ';')
+        elif not self.out_args:
+            calls.append(call + ';')
+            calls.append('dbus_send_return(connection, message);')
+        elif len(self.out_args) == 1:
+            calls.append('auto const result = {};'.format(call))
+            calls.append('dbus_send_return(connection, message, result);')
+        else:
+            calls.append('auto const result = {};'.format(call))
+            outs = ', '.join('std::get<{}>(result)'.format(i)
+                             for i in range(len(self.out_args)))
+            calls.append('dbus_send_return(connection, message, {});'.format(outs))
+
+        lines.append('try')
+        lines.append('{')
+        lines += ['    ' + c for c in calls]
+        lines.append('}')
+        lines.append('catch (std::invalid_argument const& error)')
+        lines.append('{')
+        if self.is_async:
+            lines.append('    reply.send_error(DBUS_ERROR_INVALID_ARGS, error.what());')
+        else:
+            lines.append('    dbus_send_error(connection, message, DBUS_ERROR_INVALID_ARGS, error.what());')
+        lines.append('}')
+
+        body = '\n'.join(('                ' + l) if l else '' for l in lines)
+        captures = ['this']
+        if self.is_async:
+            captures += ['loop', 'connection_handle']
+        if not self.is_async or (self.in_args and not self.has_defaults):
+            captures.append('connection')
+        captures = ', '.join(captures)
+        return '''        table.add(
+            "{interface}", "{name}",
+            [{captures}] (DBusMessage* message)
+            {{
+{body}
+            }});
+'''.format(interface=self.interface, name=self.name, captures=captures, body=body)
+
+
+class Property:
+    def __init__(self, interface, element):
+        self.interface = interface
+        self.name = element.get('name')
+        self.signature = element.get('type')
+        self.type = cpp_type(self.signature)
+        if 'read' not in element.get('access', ''):
+            fail('{}: only readable properties are supported'.format(self.name))
+
+    def declaration(self):
+        return 'virtual {} dbus_get_{}() = 0;'.format(self.type, self.name)
+
+
+class Signal:
+    def __init__(self, interface, element):
+        self.interface = interface
+        self.name = element.get('name')
+        self.args = [Arg(a, i) for i, a in enumerate(element.findall('arg'))]
+
+    def helper(self):
+        params = ''.join(', {} {}'.format(param_type(a.signature), a.name) for a in self.args)
+        append = ''
+        if self.args:
+            append = '        dbus_append_args(signal, {});\n'.format(
+                ', '.join(a.name for a in self.args))
+        return '''    // A {name} signal from path
+    static DBusMessageHandle dbus_{name}_signal(
+        char const* path{params})
+    {{
+        DBusMessageHandle signal{{dbus_message_new_signal(path, "{interface}", "{name}")}};
+{append}        return signal;
+    }}
+'''.format(name=self.name, interface=self.interface, params=params, append=append)
+
+
+def property_interfaces(properties):
+    return sorted(set(p.interface for p in properties))
+
+
+def properties_handlers(properties):
+    get_lines = []
+    get_all_lines = []
+    for index, interface in enumerate(property_interfaces(properties)):
+        interface_properties = [p for p in properties if p.interface == interface]
+
+        get_lines.append('if (interface == "{}")'.format(interface))
+        get_lines.append('{')
+        for i, p in enumerate(interface_properties):
+            keyword_ = 'if' if i == 0 else 'else if'
+            get_lines.append('    {} (property == "{}")'.format(keyword_, p.name))
+            get_lines.append('        dbus_append_variant(&iter, dbus_get_{}());'.format(p.name))
+        get_lines.append('}')
+
+        get_all_lines.append('if (interface == "{}")'.format(interface))
+        get_all_lines.append('{')
+        get_all_lines.append('    auto& reply = dbus_all_properties_replies[{}];'.format(index))
+        get_all_lines.append('    if (!reply)')
+        get_all_lines.append('    {')
+        get_all_lines.append('        auto const all_properties = DBusMessageTemplate::new_method_return();')
+        get_all_lines.append('        DBusMessageIter iter;')
+        get_all_lines.append('        dbus_message_iter_init_append(all_properties, &iter);')
+        get_all_lines.append('        DBusMessageIter iter_dict;')
+        get_all_lines.append('        dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &iter_dict);')
+        for p in interface_properties:
+            get_all_lines.append(
+                '        dbus_append_property(&iter_dict, "{0}", dbus_get_{0}());'.format(p.name))
+        get_all_lines.append('        dbus_message_iter_close_container(&iter, &iter_dict);')
+        get_all_lines.append('        reply = DBusMessageTemplate{all_properties};')
+        get_all_lines.append('    }')
+        get_all_lines.append('')
+        get_all_lines.append('    reply.send_reply(connection, message);')
+        get_all_lines.append('    return;')
+        get_all_lines.append('}')
+
+    indent = '                '
+    get_body = '\n'.join(indent + l for l in get_lines)
+    get_all_body = '\n'.join((indent + l) if l else '' for l in get_all_lines)
+
+    return '''        table.add(
+            "org.freedesktop.DBus.Properties", "Get",
+            [this, connection] (DBusMessage* message)
+            {{
+                std::string interface;
+                std::string property;
+                if (!dbus_read_args(message, interface, property))
+                {{
+                    dbus_send_error(connection, message, "Invalid arguments");
+                    return;
+                }}
+
+                DBusMessageHandle reply{{dbus_message_new_method_return(message)}};
+                DBusMessageIter iter;
+                dbus_message_iter_init_append(reply, &iter);
+
+{get_body}
+
+                dbus_connection_send(connection, reply, nullptr);
+            }});
+        table.add(
+            "org.freedesktop.DBus.Properties", "GetAll",
+            [this, connection] (DBusMessage* message)
+            {{
+                std::string interface;
+                if (!dbus_read_args(message, interface))
+                {{
+                    dbus_send_error(connection, message, "Invalid arguments");
+                    return;
+                }}
+
+{get_all_body}
+
+                DBusMessageHandle reply{{dbus_message_new_method_return(message)}};
+                DBusMessageIter iter;
+                dbus_message_iter_init_append(reply, &iter);
+                DBusMessageIter iter_dict;
+                dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{{sv}}", &iter_dict);
+                dbus_message_iter_close_container(&iter, &iter_dict);
+                dbus_connection_send(connection, reply, nullptr);
+            }});
+'''.format(get_body=get_body, get_all_body=get_all_body)
+
+
+def properties_changed_helpers(properties):
+    helpers = []
+    for p in properties:
+        helpers.append('''    // A PropertiesChanged signal from path for {name}
+    static DBusMessageHandle dbus_{name}_changed_signal(
+        char const* path, {param} value)
+    {{
+        return dbus_properties_changed_signal(path, "{interface}", "{name}", value);
+    }}
+'''.format(name=p.name, interface=p.interface, param=param_type(p.signature)))
+    return '\n'.join(helpers)
+
+
+def properties_cache(properties):
+    return '''
+    // Call when a property changes value, so that GetAll replies are
+    // rebuilt
+    void dbus_properties_changed()
+    {{
+        for (auto& reply : dbus_all_properties_replies)
+            reply = DBusMessageTemplate{{}};
+    }}
+
+private:
+    // GetAll replies per interface, built on first use
+    DBusMessageTemplate dbus_all_properties_replies[{count}];
+'''.format(count=len(property_interfaces(properties)))
+
+
+def generate(xml_file, class_name, header):
+    root = ElementTree.parse(xml_file).getroot()
+
+    interfaces = []
+    methods = []
+    properties = []
+    signals = []
+    for interface in root.findall('interface'):
+        name = interface.get('name')
+        if name.startswith('org.freedesktop.DBus.'):
+            continue
+        interfaces.append(name)
+        methods += [Method(name, m) for m in interface.findall('method')]
+        properties += [Property(name, p) for p in interface.findall('property')]
+        signals += [Signal(name, s) for s in interface.findall('signal')]
+
+    guard = 'USC_' + os.path.basename(header).upper().replace('.', '_') + '_'
+
+    declarations = [m.declaration() for m in methods] + \
+                   [p.declaration() for p in properties]
+    handlers = ''.join(m.handler() for m in methods)
+    if properties:
+        handlers += properties_handlers(properties)
+
+    loop_param = 'loop' if any(m.is_async for m in methods) else '/*loop*/'
+
+    helpers = '\n'.join([s.helper() for s in signals] +
+                        ([properties_changed_helpers(properties)] if properties else []))
+    if helpers:
+        helpers = '\n' + helpers
+    if properties:
+        helpers += properties_cache(properties)
+
+    return '''// Generated by tools/dbus_xml2stubs.py from {xml}. Do not edit.
+
+#ifndef {guard}
+#define {guard}
+
+#include "dbus_connection_handle.h"
+#include "dbus_deferred_reply.h"
+#include "dbus_marshalling.h"
+#include "dbus_message_template.h"
+#include "dbus_method_table.h"
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace usc
+{{
+class DBusEventLoop;
+
+// Server stubs for {interfaces}
+class {class_name}
+{{
+public:
+    virtual ~{class_name}() = default;
+
+protected:
+    {declarations}
+
+    // Adds handlers for the methods and properties to table, replying on
+    // connection_handle. Deferred replies are sent from the thread of loop.
+    void add_dbus_methods(
+        DBusMethodTable& table,
+        std::shared_ptr<DBusEventLoop> const& {loop_param},
+        std::shared_ptr<DBusConnectionHandle> const& connection_handle)
+    {{
+        DBusConnection* const connection = *connection_handle;
+
+{handlers}    }}
+{helpers}}};
+
+}}
+
+#endif
+'''.format(xml=os.path.basename(xml_file),
+           guard=guard,
+           interfaces=', '.join(interfaces),
+           class_name=class_name,
+           loop_param=loop_param,
+           declarations='\n    '.join(declarations),
+           handlers=handlers,
+           helpers=helpers)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 4:
+        sys.exit('Usage: dbus_xml2stubs.py <xml> <class name> <header>')
+
+    output = generate(sys.argv[1], sys.argv[2], sys.argv[3])
+    with open(sys.argv[3], 'w') as f:
+        f.write(output)